@@ -0,0 +1,73 @@
+/**
+ * @file aggregate.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the accumulators which summarize windows of frames.
+ *
+ * Instead of every frame, only the mean, the maximum and the miss rate of
+ * every value over a window of frames are written. This cuts the output by
+ * the size of the window, while the length of the window keeps the time
+ * resolution configurable.
+ */
+
+#pragma once
+
+#include "error.h"
+
+#include <stdint.h>
+
+/**
+ * @brief The accumulators of one window of frames.
+ */
+typedef struct aggregate_s {
+    uintptr_t length; /**< Amount of values of one frame. */
+    uint32_t window;  /**< Amount of frames of a complete window. */
+    uint32_t frames;  /**< Amount of frames in the current window. */
+    uint64_t clock;   /**< Timestamp counter of the first frame of the
+                         current window. */
+    uint64_t *sum;    /**< Sum of every value over the window. */
+    uint32_t *max;    /**< Maximum of every value over the window. */
+    uint32_t *misses; /**< Amount of frames where a value was above the
+                         threshold. */
+} aggregate_t;
+
+/**
+ * @brief Initializes the accumulators of a window.
+ *
+ * @param aggregate the accumulators which get initialized
+ * @param length amount of values of one frame
+ * @param window amount of frames of a window
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+error_t aggregate_new(aggregate_t *aggregate, uintptr_t length,
+                      uint32_t window);
+
+/**
+ * @brief Adds a frame to the current window.
+ *
+ * @param aggregate the accumulators
+ * @param frame aggregate_t#length values
+ * @param clock timestamp counter at the start of the frame
+ * @param threshold values above are counted as misses
+ *
+ * @return Not zero if the window is complete.
+ */
+int aggregate_add(aggregate_t *aggregate, const uint32_t *frame,
+                  uint64_t clock, uint32_t threshold);
+
+/**
+ * @brief Starts the next window.
+ *
+ * @param aggregate the accumulators
+ */
+void aggregate_reset(aggregate_t *aggregate);
+
+/**
+ * @brief Frees the accumulators of a window.
+ *
+ * @param aggregate the accumulators which get freed
+ */
+void aggregate_free(aggregate_t *aggregate);
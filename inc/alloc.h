@@ -11,6 +11,72 @@
 
 #include <stdint.h>
 
+/**
+ * @brief available allocators of the probed cache lines.
+ */
+typedef enum alloc_mode {
+    ALLOC_AUTO,     /**< ALLOC_HUGEPAGE if hugepages are reserved, otherwise
+                       ALLOC_COLOR if the pagemap shows page frame numbers,
+                       otherwise ALLOC_EVSET. */
+    ALLOC_HUGEPAGE, /**< Physically contiguous hugepages. */
+    ALLOC_COLOR,    /**< Small pages which are picked by their color (see
+                       color_pool_new). */
+    ALLOC_ARENA,    /**< One hugepage region for all buffers (see
+                       arena.h). */
+    ALLOC_EVSET     /**< Eviction sets which are found by timing (see
+                       evset.h). */
+} alloc_mode_t;
+
+/**
+ * @brief Maximum amount of mapped small pages of a color pool, as a multiple
+ * of the pages which are needed at least.
+ */
+#define COLOR_POOL_FACTOR 4
+
+/**
+ * @brief Cache lines of a subset of the sets of a cache, which are collected
+ * from small pages.
+ *
+ * A set is identified like in llc_pool_t, so without slices the id is the
+ * set index.
+ */
+typedef struct color_pool_s {
+    void **pages;            /**< The small pages of the cache lines. */
+    uintptr_t page_count;    /**< Amount of small pages. */
+    uint64_t page_size;      /**< Size of one small page. */
+    uint32_t slice_count;    /**< Amount of slices of the cache. */
+    uint32_t sets_per_slice; /**< Amount of sets of one slice. */
+    uint32_t way_count;      /**< Amount of ways of a set. */
+    uint32_t set_count;      /**< Amount of sets in color_pool_t#lines. */
+    uintptr_t *lines; /**< Virtual addresses of the cache lines, the line of
+                         the i-th set and way w is lines[i * way_count + w]. */
+} color_pool_t;
+
+/**
+ * @brief Parses the name of an allocator.
+ *
+ * @param name one of "auto", "hugepage", "color", "arena" or "evset"
+ * @param mode writes the parsed allocator into
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_NONE
+ */
+error_t alloc_mode_from(const char *name, alloc_mode_t *mode);
+
+/**
+ * @brief Resolves ALLOC_AUTO.
+ *
+ * @param mode the requested allocator
+ * @param resolved writes the allocator which is used into
+ *
+ * @retval ERROR_IO_HUGEPAGE_NUMBER
+ * @retval ERROR_FMT
+ * @retval ERROR_SYSCONF
+ * @retval ERROR_MMAP
+ * @retval ERROR_NONE
+ */
+error_t alloc_mode_resolve(alloc_mode_t mode, alloc_mode_t *resolved);
+
 /**
  * @brief allocates an aligned buffer.
  *
@@ -47,3 +113,73 @@ error_t alloc_aligned(void **buffer, const cache_info_t *cache);
  *
  */
 error_t free_aligned(void *buffer, const cache_info_t *cache);
+
+/**
+ * @brief Allocates a buffer from hugepages.
+ *
+ * @param buffer writes a pointer to the buffer into
+ * @param size size of the buffer, rounded up to whole hugepages
+ *
+ * Unlike alloc_aligned the physical addresses are neither consecutive nor
+ * aligned to a cache, the hugepages only keep the TLB out of the accesses.
+ * The buffer is populated before it is returned.
+ *
+ * @retval ERROR_NO_HUGEPAGES
+ * @retval ERROR_MMAP
+ * @retval ERROR_SYSCONF
+ * @retval ERROR_IO_PROC_MEMINFO
+ * @retval ERROR_FMT
+ * @retval ERROR_NONE
+ */
+error_t alloc_huge(void **buffer, uint64_t size);
+
+/**
+ * @brief Frees a buffer created by alloc_huge.
+ *
+ * @param buffer pointer to the buffer that will be freed
+ * @param size size which was passed to alloc_huge
+ *
+ * @retval ERROR_MUNMAP
+ * @retval ERROR_NONE
+ */
+error_t free_huge(void *buffer, uint64_t size);
+
+/**
+ * @brief Collects the cache lines of a cache from small pages.
+ *
+ * @param pool the pool which gets initialized
+ * @param cache information about the cache
+ * @param slice_count amount of slices (see get_slice_count), 1 for caches
+ * which are not sliced
+ * @param sets the sets which get cache lines or NULL for all sets
+ * @param set_count amount of sets, ignored if @p sets is NULL
+ *
+ * The color of a page are the bits of its page frame number which are part
+ * of the set index. A page only contains lines of the sets of its color, so
+ * the allocator maps chunks of small pages, reads their page frame numbers
+ * from /proc/self/pagemap and keeps the pages with colors which still miss
+ * lines, until every requested set has one line per way. The other pages
+ * stay mapped during the search, so the kernel does not return them again,
+ * and are unmapped afterwards. This needs neither hugepages nor a retry of
+ * whole buffers, but the page frame numbers are only visible to root.
+ *
+ * @retval ERROR_SLICES
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_EVICTION_SETS
+ * @retval ERROR_PAGE_ENTRY
+ * @retval ERROR_MMAP
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_SYSCONF
+ * @retval ERROR_IO_PROC_SELF_PAGEMAP
+ * @retval ERROR_NONE
+ */
+error_t color_pool_new(color_pool_t *pool, const cache_info_t *cache,
+                       uint32_t slice_count, const uint32_t *sets,
+                       uint32_t set_count);
+
+/**
+ * @brief Unmaps the pages and frees the memory of a pool.
+ *
+ * @param pool the pool which gets freed
+ */
+void color_pool_free(color_pool_t *pool);
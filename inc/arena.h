@@ -0,0 +1,164 @@
+/**
+ * @file arena.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains an arena which carves all buffers of a profiling run out
+ * of one hugepage region.
+ *
+ * The physical address of every hugepage of the arena is looked up once.
+ * Afterwards the probe buffers are placed at offsets with the right physical
+ * color without any retries, and the metadata buffers (address tables and
+ * result rings) are placed at colors which are not probed, so the kernels
+ * do not evict their own measurement.
+ */
+
+#pragma once
+
+#include "error.h"
+#include "sys_info.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Size of a 2 MiB hugepage.
+ */
+#define ARENA_PAGE_2MB (2UL * 1024 * 1024)
+
+/**
+ * @brief Size of a 1 GiB hugepage.
+ */
+#define ARENA_PAGE_1GB (1024UL * 1024 * 1024)
+
+/**
+ * @brief Alignment of all allocations of an arena.
+ */
+#define ARENA_ALIGNMENT 64
+
+/**
+ * @brief Usage statistics of an arena.
+ */
+typedef struct arena_stats_s {
+    uintptr_t size;        /**< Size of the hugepage region. */
+    uintptr_t used;        /**< Bytes up to the end of the last allocation. */
+    uintptr_t allocated;   /**< Bytes which were requested. */
+    uintptr_t padding;     /**< Bytes which were skipped to reach a physical
+                              color. */
+    uint32_t allocations;  /**< Amount of allocations. */
+    uint32_t conflicts;    /**< Metadata allocations which overlap probed
+                              sets, because they are larger than the gap
+                              between the probed sets. */
+} arena_stats_t;
+
+/**
+ * @brief The probed sets of one cache geometry.
+ */
+typedef struct arena_avoid_s {
+    uint32_t line;   /**< Line size of the cache. */
+    uint32_t sets;   /**< Amount of sets of the cache. */
+    uint8_t *probed; /**< One byte per set, not zero if the set is probed. */
+} arena_avoid_t;
+
+/**
+ * @brief A hugepage region which is carved into buffers.
+ *
+ * Memory is only allocated by moving arena_t#offset forward, everything is
+ * released at once by arena_free.
+ */
+typedef struct arena_s {
+    uint8_t *base;         /**< Start of the hugepage region. */
+    uint64_t page_size;    /**< Size of one hugepage. */
+    uint32_t page_count;   /**< Amount of hugepages. */
+    uintptr_t *physical;   /**< Physical address of every hugepage. */
+    uintptr_t offset;      /**< Offset of the next free byte. */
+    arena_avoid_t *avoid;  /**< The probed sets of every cache geometry. */
+    uint32_t avoid_count;  /**< Amount of geometries, zero if no sets are
+                              avoided. */
+    arena_stats_t stats;   /**< Usage statistics. */
+} arena_t;
+
+/**
+ * @brief Maps the hugepage region of an arena.
+ *
+ * @param arena the arena which gets initialized
+ * @param size minimal size of the region, rounded up to whole hugepages
+ * @param page_size ARENA_PAGE_2MB or ARENA_PAGE_1GB
+ *
+ * The hugepages have to be reserved in
+ * /sys/kernel/mm/hugepages/hugepages-<size>kB/nr_hugepages.
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_MMAP
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_PAGE_ENTRY
+ * @retval ERROR_IO_PROC_SELF_PAGEMAP
+ * @retval ERROR_SYSCONF
+ * @retval ERROR_NONE
+ */
+error_t arena_new(arena_t *arena, uintptr_t size, uint64_t page_size);
+
+/**
+ * @brief Marks the sets which are probed, so metadata is placed elsewhere.
+ *
+ * @param arena the arena
+ * @param cache the probed cache
+ * @param sets the probed sets or NULL for all sets
+ * @param set_count amount of sets, ignored if @p sets is NULL
+ *
+ * This is called once per profiled cache. The cores of a hybrid CPU may
+ * have caches with different geometries, every geometry gets its own table
+ * and metadata avoids the probed sets of all of them.
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+error_t arena_avoid(arena_t *arena, const cache_info_t *cache,
+                    const uint32_t *sets, uint32_t set_count);
+
+/**
+ * @brief Carves a cache aligned buffer out of an arena.
+ *
+ * @param arena the arena
+ * @param cache the cache which the buffer corresponds to
+ * @param buffer writes the buffer into
+ *
+ * The buffer has the size of the cache, is physically contiguous and its
+ * first line belongs to the first set, like a buffer of alloc_aligned.
+ *
+ * @retval ERROR_ARENA
+ * @retval ERROR_NONE
+ */
+error_t arena_alloc_cache(arena_t *arena, const cache_info_t *cache,
+                          void **buffer);
+
+/**
+ * @brief Carves a metadata buffer out of an arena.
+ *
+ * @param arena the arena
+ * @param size size of the buffer
+ * @param buffer writes the buffer into
+ *
+ * The buffer starts at the first offset where none of its lines belongs to
+ * a set which is marked by arena_avoid. If the buffer is too large for the
+ * gaps between the probed sets, it is placed at the next free offset and
+ * counted in arena_stats_t#conflicts.
+ *
+ * @retval ERROR_ARENA
+ * @retval ERROR_NONE
+ */
+error_t arena_alloc(arena_t *arena, uintptr_t size, void **buffer);
+
+/**
+ * @brief Returns the fragmentation of an arena.
+ *
+ * @param arena the arena
+ *
+ * @return The share of the used bytes which was skipped as padding.
+ */
+double arena_fragmentation(const arena_t *arena);
+
+/**
+ * @brief Unmaps the region and frees the memory of an arena.
+ *
+ * @param arena the arena which gets freed
+ */
+void arena_free(arena_t *arena);
@@ -0,0 +1,122 @@
+/**
+ * @file calibration.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the calibrated access times of every cache level and the
+ * file in which they are kept between runs.
+ *
+ * The calibration file has one line per CPU model, CPU core and timer
+ * backend with tab separated fields:
+ *
+ *     model  cpu  timer  medians  thresholds  limit
+ *
+ * The medians and thresholds are comma separated lists, see calibration_t.
+ * Lines which start with `#` are comments.
+ */
+
+#pragma once
+
+#include "error.h"
+#include "timer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief The calibration file which is used if no other file is given.
+ */
+#define CALIBRATION_DEFAULT_FILE "/var/lib/cache-profiler/calibration"
+
+/**
+ * @brief Maximal amount of cache levels of a calibration.
+ */
+#define CALIBRATION_MAX_LEVELS 4
+
+/**
+ * @brief Size of the CPU model string, the CPUID brand string has 48
+ * characters.
+ */
+#define CALIBRATION_MODEL_SIZE 49
+
+/**
+ * @brief Accesses slower than this factor times the median of a DRAM access
+ * are outliers (interrupts, reschedules).
+ */
+#define CALIBRATION_LIMIT_FACTOR 4
+
+/**
+ * @brief The access times of all cache levels on one CPU core.
+ */
+typedef struct calibration_s {
+    char model[CALIBRATION_MODEL_SIZE]; /**< CPUID brand string. */
+    uint32_t cpu;                       /**< The calibrated CPU core. */
+    timer_type_t timer;                 /**< The calibrated timer backend. */
+    uint32_t level_count;               /**< Amount of cache levels. */
+    uint32_t median[CALIBRATION_MAX_LEVELS + 1]; /**< Median access time of a
+                                                    hit in L1, L2, ... and of
+                                                    a DRAM access last. */
+    uint32_t threshold[CALIBRATION_MAX_LEVELS];  /**< An access up to
+                                                    threshold[i] cycles is a
+                                                    hit in L(i + 1) or a
+                                                    closer level. */
+    uint32_t limit; /**< Accesses above are outliers. */
+} calibration_t;
+
+/**
+ * @brief Reads the model of the CPU.
+ *
+ * @param model writes the CPUID brand string without leading spaces into
+ */
+void calibration_model(char model[CALIBRATION_MODEL_SIZE]);
+
+/**
+ * @brief Derives the thresholds and the limit from the medians.
+ *
+ * @param calibration a calibration with calibration_t#median
+ *
+ * The threshold between two levels is the middle of their medians.
+ *
+ * @return Zero if every level is faster than the next one, otherwise the
+ * first level (1 for L1) whose hits can not be separated.
+ */
+uint32_t calibration_derive(calibration_t *calibration);
+
+/**
+ * @brief Looks up the calibration of a CPU core.
+ *
+ * @param path the calibration file
+ * @param model model of the CPU, see calibration_model
+ * @param cpu the CPU core
+ * @param timer the timer backend
+ * @param calibration writes the calibration into
+ *
+ * @retval ERROR_CALIBRATION if the file or the line does not exist
+ * @retval ERROR_NONE
+ */
+error_t calibration_load(const char *path, const char *model, uint32_t cpu,
+                         timer_type_t timer, calibration_t *calibration);
+
+/**
+ * @brief Writes calibrations into the calibration file.
+ *
+ * @param path the calibration file, its directory is created if it does not
+ * exist
+ * @param calibrations the calibrations
+ * @param count amount of calibrations
+ *
+ * Older lines of the same model, CPU core and timer are replaced, all other
+ * lines are kept. The file is replaced atomically.
+ *
+ * @retval ERROR_CALIBRATION
+ * @retval ERROR_NONE
+ */
+error_t calibration_store(const char *path, const calibration_t *calibrations,
+                          uint32_t count);
+
+/**
+ * @brief Prints a calibration.
+ *
+ * @param calibration the calibration
+ * @param file the output stream
+ */
+void calibration_print(const calibration_t *calibration, FILE *file);
@@ -0,0 +1,99 @@
+/**
+ * @file classify.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the classification of measured access times into hits and
+ * misses.
+ *
+ * A classified frame is a bitmap with one bit per value of the frame, the
+ * bit is set if the value is above the threshold (a miss, the cache line was
+ * evicted). Value `i` of the frame is bit `i % 8` of byte `i / 8`, so a
+ * bitmap is 32 times smaller than the frame.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Amount of bins of a calibration histogram, larger values are
+ * counted in the last bin.
+ */
+#define CLASSIFY_HISTOGRAM_SIZE 4096
+
+/**
+ * @brief Amount of frames which are probed to calibrate the threshold.
+ */
+#define CLASSIFY_CALIBRATION_FRAMES 64
+
+/**
+ * @brief Width of the window in which the histogram is summed up, so
+ * quantized timers do not leave empty bins inside a peak.
+ */
+#define CLASSIFY_WINDOW 8
+
+/**
+ * @brief The peak of the hits ends where a window has less than 1 /
+ * CLASSIFY_VALLEY of the values of the highest window.
+ */
+#define CLASSIFY_VALLEY 100
+
+/**
+ * @brief Returns the size of the bitmap of a frame.
+ *
+ * @param length amount of values in the frame
+ *
+ * @return The amount of bytes.
+ */
+static inline uintptr_t classify_bitmap_size(uintptr_t length) {
+    return (length + 7) / 8;
+}
+
+/**
+ * @brief Packs a frame into a bitmap.
+ *
+ * @param values the frame
+ * @param length amount of values in the frame
+ * @param threshold values above the threshold are misses
+ * @param bitmap writes classify_bitmap_size(@p length) bytes into
+ *
+ * Eight values are compared at once with AVX2 if the CPU supports it,
+ * otherwise with SSE2.
+ */
+void classify_pack(const uint32_t *values, uintptr_t length,
+                   uint32_t threshold, uint8_t *bitmap);
+
+/**
+ * @brief Clamps outliers of frames.
+ *
+ * @param values the frames
+ * @param length amount of values
+ * @param limit values above the limit are replaced by the limit
+ */
+void classify_clamp(uint32_t *values, uintptr_t length, uint32_t limit);
+
+/**
+ * @brief Counts frames in a calibration histogram.
+ *
+ * @param histogram CLASSIFY_HISTOGRAM_SIZE counters
+ * @param values a frame
+ * @param length amount of values in the frame
+ */
+void classify_histogram_add(uint64_t *histogram, const uint32_t *values,
+                            uintptr_t length);
+
+/**
+ * @brief Derives the threshold from the access times of a primed cache.
+ *
+ * @param histogram CLASSIFY_HISTOGRAM_SIZE counters of frames which were
+ * probed right after priming
+ *
+ * Most lines of a primed cache are hits, so the highest peak of the
+ * histogram are the hits. The threshold is the end of this peak, i.e. the
+ * first window above the peak which holds less than 1 / CLASSIFY_VALLEY of
+ * the values of the peak. Lines which were evicted while priming (e.g. by
+ * the plan itself) form a second peak and stay above the threshold.
+ *
+ * @return The threshold in cycles.
+ */
+uint32_t classify_threshold(const uint64_t *histogram);
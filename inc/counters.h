@@ -0,0 +1,108 @@
+/**
+ * @file counters.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the counters of the profiler's own threads.
+ *
+ * Every counter has a single thread which increments it, so an increment is
+ * a relaxed load and store without a locked instruction. Other threads read
+ * the counters at any time without a lock and see a value which is at most
+ * one increment old.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Size of a cache line, the counters of different threads never
+ * share one.
+ */
+#define COUNTERS_ALIGNMENT 64
+
+/**
+ * @brief A counter with a single writer.
+ */
+typedef atomic_uint_fast64_t counter_t;
+
+/**
+ * @brief Adds to a counter (only from the thread which owns it).
+ *
+ * @param counter the counter
+ * @param value the increment
+ */
+static inline void counter_add(counter_t *counter, uint64_t value) {
+    atomic_store_explicit(
+        counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+        memory_order_relaxed);
+}
+
+/**
+ * @brief Reads a counter from any thread.
+ *
+ * @param counter the counter
+ *
+ * @return The value of the counter.
+ */
+static inline uint64_t counter_read(counter_t *counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+/**
+ * @brief The counters of a probe thread.
+ */
+typedef struct probe_counters_s {
+    _Alignas(COUNTERS_ALIGNMENT) counter_t frames; /**< Probed frames. */
+    counter_t interrupted; /**< Frames whose probe took much longer than the
+                              fastest one, probably because of an interrupt
+                              or a reschedule. */
+} probe_counters_t;
+
+/**
+ * @brief The counters of the writer thread.
+ */
+typedef struct writer_counters_s {
+    _Alignas(COUNTERS_ALIGNMENT) counter_t frames; /**< Drained frames. */
+    counter_t batches; /**< Batches of consecutive frames. */
+    counter_t busy_ns; /**< Time in the output, the classification, the
+                          histograms and the aggregation in ns. */
+    counter_t idle_ns; /**< Time the writer slept on empty rings in ns. */
+} writer_counters_t;
+
+/**
+ * @brief Initializes the counters of a probe thread.
+ *
+ * @param counters the counters which get initialized
+ */
+void probe_counters_init(probe_counters_t *counters);
+
+/**
+ * @brief Initializes the counters of the writer thread.
+ *
+ * @param counters the counters which get initialized
+ */
+void writer_counters_init(writer_counters_t *counters);
+
+/**
+ * @brief Prints the counters of a probe thread.
+ *
+ * @param counters the counters
+ * @param cpu the CPU core of the thread
+ * @param dropped amount of frames which the writer did not get
+ * @param seconds duration of the run
+ * @param file the output stream
+ */
+void probe_counters_print(probe_counters_t *counters, uint32_t cpu,
+                          uint64_t dropped, double seconds, FILE *file);
+
+/**
+ * @brief Prints the counters of the writer thread.
+ *
+ * @param counters the counters
+ * @param seconds duration of the run
+ * @param file the output stream
+ */
+void writer_counters_print(writer_counters_t *counters, double seconds,
+                           FILE *file);
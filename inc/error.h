@@ -224,6 +224,86 @@
  */
 #define ERROR_RDPMC -36
 
+/**
+ * @brief The dimensions of a frame differ from the previous frames.
+ */
+#define ERROR_FRAME_SHAPE -37
+
+/**
+ * @brief Failed to create or join a thread.
+ */
+#define ERROR_THREAD -38
+
+/**
+ * @brief A command line argument has an invalid value.
+ */
+#define ERROR_INVALID_ARGUMENT -39
+
+/**
+ * @brief The slice hash of the last level cache is not known.
+ *
+ * Only the complex addressing of Intel CPUs with 1, 2, 4 or 8 slices is
+ * supported.
+ */
+#define ERROR_SLICES -40
+
+/**
+ * @brief Not every eviction set could be filled.
+ *
+ * All hugepages were used, but some sets of a slice still have less cache
+ * lines than ways, or the timing based discovery did not find all sets.
+ * Reserve more hugepages or probe less sets.
+ */
+#define ERROR_EVICTION_SETS -41
+
+/**
+ * @brief The timer can not distinguish a cache hit from an eviction.
+ *
+ * The calibration of the eviction set discovery found no gap between the
+ * access time of a cached and an evicted cache line.
+ */
+#define ERROR_TIMER_THRESHOLD -42
+
+/**
+ * @brief Reading or writing the eviction set cache file failed.
+ */
+#define ERROR_IO_EVSET_CACHE -43
+
+/**
+ * @brief The hugepage arena has no space left.
+ *
+ * Either no part of the arena has the physical color of the requested
+ * buffer or the buffers need more memory than the arena has.
+ */
+#define ERROR_ARENA -44
+
+/**
+ * @brief The cache topology could neither be read from the sysfs nor with
+ * the CPUID instruction.
+ */
+#define ERROR_TOPOLOGY -45
+
+/**
+ * @brief No CPU core matches the placement policy of the workload.
+ *
+ * E.g. smt-sibling on a CPU without hyper threading, or shared-l3 if every
+ * CPU core which shares the cache is profiled.
+ */
+#define ERROR_PLACEMENT -46
+
+/**
+ * @brief Reading or writing a .cnv frame stream failed.
+ *
+ * Also returned if a file is not a .cnv file of a supported version.
+ */
+#define ERROR_IO_CNV -47
+
+/**
+ * @brief Reading or writing the calibration file failed, or it has no
+ * calibration of the CPU core.
+ */
+#define ERROR_CALIBRATION -48
+
 /**
  * @brief If the execution was successful
  *
@@ -273,8 +353,7 @@ const char *decode_error(error_t error);
     {                                                                          \
         error_t res = error_code;                                              \
         if (res != ERROR_NONE) {                                               \
-            fprintf(stderr, "%s, %s(%d) ", message, decode_error(error_code),  \
-                    error_code);                                               \
+            fprintf(stderr, "%s, %s(%d) ", message, decode_error(res), res);   \
             if (errno) {                                                       \
                 fprintf(stderr, ":%s(%d)", strerror(errno), errno);            \
             }                                                                  \
@@ -0,0 +1,120 @@
+/**
+ * @file evset.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the timing based discovery of eviction sets.
+ *
+ * Without hugepages the physical address bits above the page offset are
+ * unknown, so the sets of a cache can not be computed. Instead the eviction
+ * sets are found by measuring whether a group of cache lines evicts a target
+ * line. All lines at the same page offset form the candidates of one offset
+ * class, and the group testing reduction of Vila et al. shrinks a set of
+ * candidates which evicts the target to a minimal set of `ways` lines.
+ *
+ * The set id `s` of a discovered set is `k * classes + c`, where `c` is the
+ * offset class (the set bits inside the page offset) and `k` is the order of
+ * discovery within the class. Therefore only the lower bits of the id match
+ * the real set index of the cache.
+ */
+
+#pragma once
+
+#include "error.h"
+#include "sys_info.h"
+#include "timer.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Size of the pages of the candidate pool.
+ */
+#define EVSET_PAGE_SIZE 4096
+
+/**
+ * @brief The candidate pool has this many times `ways * sets per class`
+ * pages.
+ */
+#define EVSET_POOL_FACTOR 2
+
+/**
+ * @brief Amount of measurements of one eviction test. The test succeeds if
+ * the majority of the measurements is above the threshold.
+ */
+#define EVSET_TEST_REPEATS 5
+
+/**
+ * @brief Amount of failed attempts per set before the discovery gives up.
+ */
+#define EVSET_MAX_ATTEMPTS 20
+
+/**
+ * @brief Amount of measurements of the threshold calibration.
+ */
+#define EVSET_CALIBRATION_SAMPLES 200
+
+/**
+ * @brief Statistics of a discovery.
+ */
+typedef struct evset_stats_s {
+    uint64_t tests;       /**< Amount of eviction tests. */
+    uint64_t duration_ns; /**< Time of the calibration and discovery. */
+    uint32_t threshold;   /**< Cycles above which a line counts as evicted. */
+    int cached;           /**< If not zero, the sets were loaded from the
+                             cache file. */
+} evset_stats_t;
+
+/**
+ * @brief Eviction sets which were found by timing.
+ */
+typedef struct evset_pool_s {
+    uint8_t *pool;        /**< The candidate pages. */
+    uintptr_t pool_pages; /**< Amount of candidate pages. */
+    uintptr_t map_size;   /**< Size of the mapping of the pool. */
+    uintptr_t map_offset; /**< Offset of the pool in the mapping. */
+    uint8_t *map;         /**< The mapping which contains the pool. */
+    uint32_t set_count;   /**< Amount of sets in evset_pool_t#lines. */
+    uint32_t way_count;   /**< Amount of ways of a set. */
+    uintptr_t *lines; /**< Virtual addresses of the cache lines, the line of
+                         the i-th set and way w is lines[i * way_count + w]. */
+    evset_stats_t stats; /**< Statistics of the discovery. */
+} evset_pool_t;
+
+/**
+ * @brief Finds the eviction sets of a cache by timing.
+ *
+ * @param pool the pool which gets initialized
+ * @param cache information about the cache
+ * @param sets the set ids (see evset.h) which get an eviction set or NULL
+ * for all sets
+ * @param set_count amount of sets, ignored if @p sets is NULL
+ * @param timer the timer backend of the eviction tests
+ * @param cache_file path of the cache file or NULL
+ *
+ * If a cache file is given, the candidate pages are a shared mapping of
+ * this file, so they keep their physical pages until the next run as long as
+ * the file is located in a tmpfs (e.g. /dev/shm). The discovered sets are
+ * stored behind the pages. A later run reuses them, if the boot id and the
+ * cache are the same and every stored set still evicts its target line.
+ *
+ * The current thread has to be bound to the CPU of the cache.
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_TIMER_THRESHOLD
+ * @retval ERROR_EVICTION_SETS
+ * @retval ERROR_IO_EVSET_CACHE
+ * @retval ERROR_MMAP
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FD_CYCLE
+ * @retval ERROR_FD_CYCLE_CLOSE
+ * @retval ERROR_NONE
+ */
+error_t evset_pool_new(evset_pool_t *pool, const cache_info_t *cache,
+                       const uint32_t *sets, uint32_t set_count,
+                       timer_type_t timer, const char *cache_file);
+
+/**
+ * @brief Unmaps the candidate pages and frees the memory of a pool.
+ *
+ * @param pool the pool which gets freed
+ */
+void evset_pool_free(evset_pool_t *pool);
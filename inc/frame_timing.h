@@ -0,0 +1,93 @@
+/**
+ * @file frame_timing.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the timestamps of every frame and the breakdown of the
+ * time of the measurement loop.
+ *
+ * Every frame records the timestamp counter and CLOCK_MONOTONIC at its start
+ * and its end, and the cycles which were spent in prime, sched_yield and
+ * probe. The timestamp counter aligns the frames of different cores, the
+ * monotonic clock aligns them with the logs of a workload.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @brief The timestamps of one frame.
+ */
+typedef struct frame_timing_s {
+    uint64_t tsc_start;       /**< Timestamp counter before prime. */
+    uint64_t tsc_end;         /**< Timestamp counter after probe. */
+    uint64_t monotonic_start; /**< CLOCK_MONOTONIC before prime in ns. */
+    uint64_t monotonic_end;   /**< CLOCK_MONOTONIC after probe in ns. */
+    uint32_t prime;           /**< Cycles of prime. */
+    uint32_t yield;           /**< Cycles of sched_yield. */
+    uint32_t probe;           /**< Cycles of probe. */
+} frame_timing_t;
+
+/**
+ * @brief Sum, minimum and maximum of the cycles of one part of the loop.
+ */
+typedef struct frame_timing_phase_s {
+    uint64_t sum; /**< Cycles of all frames. */
+    uint32_t min; /**< Cycles of the fastest frame. */
+    uint32_t max; /**< Cycles of the slowest frame. */
+} frame_timing_phase_t;
+
+/**
+ * @brief The breakdown of the time of the measurement loop of one core.
+ */
+typedef struct frame_timing_report_s {
+    uint64_t frames;          /**< Amount of frames. */
+    uint64_t tsc_start;       /**< Timestamp counter of the first frame. */
+    uint64_t tsc_end;         /**< Timestamp counter after the last frame. */
+    uint64_t monotonic_start; /**< CLOCK_MONOTONIC of the first frame. */
+    uint64_t monotonic_end;   /**< CLOCK_MONOTONIC after the last frame. */
+    frame_timing_phase_t prime; /**< Cycles of prime. */
+    frame_timing_phase_t yield; /**< Cycles of sched_yield. */
+    frame_timing_phase_t probe; /**< Cycles of probe. */
+} frame_timing_report_t;
+
+/**
+ * @brief Returns CLOCK_MONOTONIC in nanoseconds.
+ */
+static inline uint64_t frame_timing_monotonic(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+/**
+ * @brief Initializes an empty report.
+ *
+ * @param report the report which gets initialized
+ */
+void frame_timing_report_init(frame_timing_report_t *report);
+
+/**
+ * @brief Adds a frame to a report.
+ *
+ * @param report the report
+ * @param timing the timestamps of the frame
+ */
+void frame_timing_report_add(frame_timing_report_t *report,
+                             const frame_timing_t *timing);
+
+/**
+ * @brief Prints the share of prime, sched_yield and probe of the loop.
+ *
+ * @param report the report
+ * @param cpu the CPU core of the loop
+ * @param file the output stream
+ *
+ * The rest of the time between the first and the last frame is spent with
+ * the timestamps and the frame ring. The mean frame rate and duration are
+ * taken from CLOCK_MONOTONIC.
+ */
+void frame_timing_report_print(const frame_timing_report_t *report,
+                               uint32_t cpu, FILE *file);
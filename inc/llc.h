@@ -0,0 +1,157 @@
+/**
+ * @file llc.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the eviction sets of the sliced last level cache.
+ *
+ * The last level cache of Intel CPUs is split into slices. The slice of a
+ * cache line is selected by a hash of its physical address (complex
+ * addressing) and the set within the slice by the bits above the line
+ * offset. Therefore the cache lines of one set can not be found at fixed
+ * offsets of a buffer, but have to be collected from many hugepages.
+ */
+
+#pragma once
+
+#include "error.h"
+#include "sys_info.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Caches of this level or higher are probed with eviction sets.
+ */
+#define LLC_MIN_LEVEL 3
+
+/**
+ * @brief Maximum amount of slices with a known slice hash.
+ */
+#define LLC_MAX_SLICES 8
+
+/**
+ * @brief The (slice, set) slots which collect the cache lines of a pool.
+ *
+ * A set is identified by `slice * sets_per_slice + index`, where index is
+ * the set within its slice. The lines are distributed by their physical
+ * address, so every page is only translated once.
+ */
+typedef struct llc_slots_s {
+    uint32_t slice_count;    /**< Amount of slices of the cache. */
+    uint32_t sets_per_slice; /**< Amount of sets of one slice. */
+    uint32_t way_count;      /**< Amount of ways of a set. */
+    uint32_t set_count;      /**< Amount of slots. */
+    uint32_t line_size;      /**< Size of a cache line. */
+    int64_t *slot_of; /**< Slot of every set of the cache or -1 if it is not
+                         probed. */
+    uint32_t *fill;   /**< Amount of lines of every slot. */
+    uintptr_t missing; /**< Amount of lines which are still missing. */
+    uintptr_t *lines; /**< Virtual addresses of the cache lines, the line of
+                         slot i and way w is lines[i * way_count + w]. */
+} llc_slots_t;
+
+/**
+ * @brief Eviction sets of a subset of the sets of a last level cache.
+ *
+ * A set is identified by `slice * sets_per_slice + index`, where index is
+ * the set within its slice.
+ */
+typedef struct llc_pool_s {
+    void **pages;            /**< The hugepages of the cache lines. */
+    uint32_t page_count;     /**< Amount of hugepages. */
+    uint64_t page_size;      /**< Size of one hugepage. */
+    uint32_t slice_count;    /**< Amount of slices of the cache. */
+    uint32_t sets_per_slice; /**< Amount of sets of one slice. */
+    uint32_t way_count;      /**< Amount of ways of a set. */
+    uint32_t set_count;      /**< Amount of sets in llc_pool_t#lines. */
+    uintptr_t *lines; /**< Virtual addresses of the cache lines, the line of
+                         the i-th set and way w is lines[i * way_count + w]. */
+} llc_pool_t;
+
+/**
+ * @brief Returns the slice of a physical address.
+ *
+ * @param physical the physical address
+ * @param slice_count amount of slices, 1, 2, 4 or 8
+ *
+ * Uses the XOR hash functions of the Intel complex addressing, which were
+ * reverse engineered by Maurice et al.
+ */
+uint32_t llc_slice_of(uintptr_t physical, uint32_t slice_count);
+
+/**
+ * @brief Prepares the slots of the requested sets.
+ *
+ * @param slots the slots which get initialized
+ * @param cache information about the cache
+ * @param slice_count amount of slices, 1 for caches which are not sliced
+ * @param sets the sets which get a slot or NULL for all sets
+ * @param set_count amount of sets, ignored if @p sets is NULL
+ *
+ * @retval ERROR_SLICES
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+error_t llc_slots_new(llc_slots_t *slots, const cache_info_t *cache,
+                      uint32_t slice_count, const uint32_t *sets,
+                      uint32_t set_count);
+
+/**
+ * @brief Distributes the cache lines of a page to the slots which still miss
+ * lines.
+ *
+ * @param slots the slots
+ * @param page virtual address of the page
+ * @param physical physical address of the page
+ * @param page_size size of the page
+ *
+ * @return The amount of lines which were taken from the page.
+ */
+uintptr_t llc_slots_take(llc_slots_t *slots, uintptr_t page,
+                         uintptr_t physical, uint64_t page_size);
+
+/**
+ * @brief Frees the memory of the slots.
+ *
+ * @param slots the slots which get freed
+ *
+ * llc_slots_t#lines is freed as well, unless it was set to NULL because a
+ * pool took it over.
+ */
+void llc_slots_free(llc_slots_t *slots);
+
+/**
+ * @brief Builds the eviction sets of a last level cache.
+ *
+ * @param pool the pool which gets initialized
+ * @param cache information about the last level cache
+ * @param slice_count amount of slices (see get_slice_count)
+ * @param sets the sets which get an eviction set or NULL for all sets
+ * @param set_count amount of sets, ignored if @p sets is NULL
+ *
+ * Maps hugepages until every requested set has one cache line per way. The
+ * slice of every line is computed from the physical address of its hugepage,
+ * so only one pagemap lookup per hugepage is needed. Hugepages which do not
+ * contribute a single line are unmapped after the search, so every hugepage
+ * is mapped at most once.
+ *
+ * @retval ERROR_SLICES
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_NO_HUGEPAGES
+ * @retval ERROR_EVICTION_SETS
+ * @retval ERROR_MMAP
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_IO_PROC_SELF_PAGEMAP
+ * @retval ERROR_IO_PROC_MEMINFO
+ * @retval ERROR_NONE
+ */
+error_t llc_pool_new(llc_pool_t *pool, const cache_info_t *cache,
+                     uint32_t slice_count, const uint32_t *sets,
+                     uint32_t set_count);
+
+/**
+ * @brief Unmaps the hugepages and frees the memory of a pool.
+ *
+ * @param pool the pool which gets freed
+ */
+void llc_pool_free(llc_pool_t *pool);
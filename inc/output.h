@@ -14,16 +14,228 @@
 
 #include "hdf5.h"
 
+#include "aggregate.h"
 #include "error.h"
+#include "frame_timing.h"
+#include "stats.h"
+#include "sys_info.h"
+#include "timer.h"
 
 #define OUTPUT_STDOUT 1
 #define OUTPUT_HD5_FILE 2
+#define OUTPUT_CNV_FILE 3
+
+/**
+ * @brief Name of the dataset which holds all frames in a HDF5 file.
+ */
+#define OUTPUT_HD5_FRAMES "frames"
+
+/**
+ * @brief Name of the dataset which holds the timestamp counter at the start
+ * of every frame.
+ *
+ * The timestamp counter is synchronized between all cores, so the frames of
+ * different cores can be aligned with this dataset.
+ */
+#define OUTPUT_HD5_CLOCK "clock"
+
+/**
+ * @brief Name of the dataset which holds all classified frames in a HDF5
+ * file.
+ *
+ * Every frame is one row of classify_bitmap_size bytes. The attribute
+ * `shape` holds the shape of the unpacked frame and `threshold` the
+ * threshold of the classification.
+ */
+#define OUTPUT_HD5_BITMAPS "bitmaps"
+
+/**
+ * @brief Name of the dataset which holds the cycle histogram of every set.
+ *
+ * Row `s` holds the counts of the values 0 to bins - 1 of the set `s`,
+ * followed by the count of all larger values.
+ */
+#define OUTPUT_HD5_HISTOGRAMS "histograms"
+
+/**
+ * @brief Name of the dataset which holds the summary of every set.
+ *
+ * Row `s` holds the OUTPUT_SUMMARY_COLUMNS of the set `s`: count, mean,
+ * variance, min, max, p50, p90, p99 and p99.9. A percentile which is not
+ * below the amount of bins is infinite.
+ */
+#define OUTPUT_HD5_SUMMARY "summary"
+
+/**
+ * @brief Amount of columns of the summary of a set.
+ */
+#define OUTPUT_SUMMARY_COLUMNS 9
+
+/**
+ * @brief Name of the group which holds the windows of an aggregated
+ * profile.
+ *
+ * The datasets `mean` (float), `max` (uint32) and `miss_rate` (float) hold
+ * one record with the shape of a frame per window, `clock` the timestamp
+ * counter of the first frame and `frames` the amount of frames of every
+ * window. Only the last window may have less frames than the attribute
+ * `window`. The attribute `threshold` holds the threshold of the misses.
+ */
+#define OUTPUT_HD5_WINDOWS "windows"
+
+/**
+ * @brief Name of the dataset which holds the timestamps of every frame.
+ *
+ * Record `i` is the frame_timing_t of frame `i`: the timestamp counter and
+ * CLOCK_MONOTONIC (ns) at the start and the end of the frame and the cycles
+ * of prime, sched_yield and probe.
+ */
+#define OUTPUT_HD5_TIMING "timing"
+
+/**
+ * @brief Name of the dataset which holds the ids of the probed sets.
+ *
+ * Row `s` of a frame was measured on the set `sets[s]`. The dataset is
+ * missing if all sets were probed.
+ */
+#define OUTPUT_HD5_SETS "sets"
+
+/**
+ * @brief Name of the dataset which holds the ids of the probed ways.
+ *
+ * Column `w` of a frame was measured on the way `ways[w]`. The dataset is
+ * missing if all ways were probed.
+ */
+#define OUTPUT_HD5_WAYS "ways"
+
+/**
+ * @brief Amount of records of one chunk of the appended datasets of
+ * scalars, e.g. the clock of the windows or the timing of the frames.
+ */
+#define OUTPUT_HD5_RECORD_CHUNK 1024
+
+/**
+ * @brief Preferred size of one HDF5 chunk in bytes.
+ *
+ * The amount of frames per chunk is derived from this value, so that many
+ * small frames (e.g. L1) are grouped together into one chunk.
+ */
+#define OUTPUT_HD5_CHUNK_SIZE (1024 * 1024)
+
+/**
+ * @brief Initial size of the text buffer of a stream output.
+ *
+ * The buffer grows if a single frame does not fit into it.
+ */
+#define OUTPUT_TEXT_BUFFER (1024 * 1024)
+
+/**
+ * @brief available text formats of a stream output.
+ */
+typedef enum output_format {
+    OUTPUT_FORMAT_TEXT,  /**< One line `set S: v,v,...` per set. */
+    OUTPUT_FORMAT_CSV,   /**< One line `cpu,clock,set,v,v,...` per set. */
+    OUTPUT_FORMAT_NDJSON /**< One JSON object
+                            `{"cpu":C,"clock":T,"frame":[[v,...],...]}` per
+                            frame. */
+} output_format_t;
+
+/**
+ * @brief First bytes of a .cnv file.
+ */
+#define OUTPUT_CNV_MAGIC "CNVFRAME"
+
+/**
+ * @brief Version of the .cnv layout.
+ */
+#define OUTPUT_CNV_VERSION 2
+
+/**
+ * @brief Size of the header of a .cnv file, the first frame starts at this
+ * offset unless the ids of the probed sets and ways do not fit into it.
+ */
+#define OUTPUT_CNV_HEADER_SIZE 4096
+
+/**
+ * @brief Maximal amount of frames which are written with one pwritev.
+ */
+#define OUTPUT_CNV_BATCH 512
+
+/**
+ * @brief Header of a .cnv frame stream.
+ *
+ * A .cnv file is this header, padded to OUTPUT_CNV_HEADER_SIZE bytes,
+ * followed by records of cnv_header_t#record_size bytes: the 64 bit timestamp
+ * counter at the start of the frame and the `dim_y * dim_x` 32 bit values of
+ * the frame, or its packed bitmap if cnv_header_t#bits is 1. All values are
+ * little endian, so a reader maps the file and finds frame `i` at
+ * `OUTPUT_CNV_HEADER_SIZE + i * record_size`.
+ *
+ * The shape of the frames is written with the first frame and
+ * cnv_header_t#frame_count when the output is closed. If the profiler did
+ * not exit cleanly, the amount of frames follows from the file size.
+ *
+ * Since version 2 the ids of the probed sets and ways (32 bit each) follow
+ * the header if only some of them were probed, see output_set_mask. The
+ * header is then padded to the next multiple of OUTPUT_CNV_HEADER_SIZE, so
+ * the first frame is at cnv_header_t#header_size. Version 1 files have no
+ * ids and the same layout otherwise.
+ */
+typedef struct cnv_header_s {
+    char magic[8];         /**< OUTPUT_CNV_MAGIC without the zero. */
+    uint32_t version;      /**< OUTPUT_CNV_VERSION. */
+    uint32_t header_size;  /**< OUTPUT_CNV_HEADER_SIZE. */
+    uint32_t cpu;          /**< The profiled CPU core. */
+    uint32_t timer;        /**< The timer_type_t of the measurement. */
+    uint32_t level;        /**< Level of the profiled cache. */
+    uint32_t type;         /**< The cache_type_t of the profiled cache. */
+    uint32_t line_size;    /**< Line size of the cache. */
+    uint32_t total_size;   /**< Size of the cache. */
+    uint32_t set_count;    /**< Amount of sets of the cache. */
+    uint32_t way_count;    /**< Amount of ways of the cache. */
+    uint32_t rank;         /**< 2 for matrices, 1 for vectors and 0 if no
+                              frame was written yet. */
+    uint32_t dim_x;        /**< Width of one frame (ways). */
+    uint32_t dim_y;        /**< Height of one frame (sets). */
+    uint32_t record_size;  /**< Bytes of the timestamp and one frame. */
+    uint64_t frame_count;  /**< Amount of frames. */
+    uint32_t bits;         /**< Bits per value: 32, or 1 if the frames are
+                              bitmaps of classify.h. Zero (32) in files
+                              without classification. */
+    uint32_t threshold;    /**< Threshold of the classification. */
+    uint32_t mask_sets;    /**< Amount of set ids behind the header or 0 if
+                              all sets were probed. */
+    uint32_t mask_ways;    /**< Amount of way ids behind the set ids or 0 if
+                              all ways were probed. */
+} cnv_header_t;
 
 typedef struct output_s {
     uint8_t type;
     FILE *std;
-    hid_t h5;
+    hid_t h5;              /**< HDF5 file or group where the datasets are. */
+    uint8_t group;         /**< If not zero, output_t#h5 is a group. */
+    char label[16];        /**< Prefix of every line on a stream. */
     uintptr_t iter;
+    hid_t frames;          /**< Extendible frames dataset or -1. */
+    hid_t clock;           /**< Extendible clock dataset or -1. */
+    uint8_t rank;          /**< 2 for matrices and 1 for vectors. */
+    uintptr_t dim_x;       /**< Width of one frame (ways). */
+    uintptr_t dim_y;       /**< Height of one frame (sets). */
+    uint8_t *chunk;        /**< Frames which are not written yet. */
+    uint64_t *chunk_clock; /**< Timestamps of the frames in output_t#chunk. */
+    uintptr_t chunk_size;  /**< Capacity of output_t#chunk in frames. */
+    uintptr_t chunk_fill;  /**< Amount of frames in output_t#chunk. */
+    output_format_t format; /**< Text format of a stream output. */
+    int32_t cpu;           /**< CPU core in the csv and ndjson formats. */
+    char *text;            /**< Formatted text which is not written yet. */
+    uintptr_t text_size;   /**< Capacity of output_t#text. */
+    uintptr_t text_fill;   /**< Amount of bytes in output_t#text. */
+    uint8_t bits;          /**< Bits per value: 32, 1 for bitmaps or 0 before
+                              the first frame. */
+    uint32_t threshold;    /**< Threshold of the bitmaps. */
+    uint32_t *sets;        /**< Ids of the rows of a stream or NULL. */
+    int fd;                /**< File descriptor of a .cnv file or -1. */
+    cnv_header_t cnv;      /**< Header of a .cnv file. */
 } output_t;
 
 /**
@@ -38,8 +250,18 @@ typedef struct output_s {
  * Writes the output to the output stream which is specified in output_t. The
  * data is an two dimensional matrix which has an x and y dimension.
  *
- * @retval ERROR_IO_HDF
+ * Streams format the frames in the format of output_set_format into a buffer
+ * which is written with a single write at the end of every call.
+ *
+ * For HDF5 files all matrices are appended to one extendible dataset
+ * `frames[N][dimY][dimX]`. The matrices are collected until a whole chunk is
+ * filled and then written with a single hyperslab write. Therefore all
+ * matrices of one output have to share the same dimensions.
+ *
+ * @retval ERROR_IO
  * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FRAME_SHAPE
  * @retval ERROR_NOT_SUPPORTED_OUTPUT
  * @retval ERROR_NONE
  *
@@ -47,6 +269,192 @@ typedef struct output_s {
 error_t outputw_mat_ui32(output_t *output, uint32_t *data, uintptr_t dim_x,
                          uintptr_t dim_y);
 
+/**
+ * @brief Prints multiple matrices which are stored consecutively in the
+ * memory.
+ *
+ * @param output Holds data about the output stream
+ * @param data count matrices
+ * @param clock timestamp counter at the start of every matrix or NULL
+ * @param count amount of matrices
+ * @param dim_x dimension (x-axis)
+ * @param dim_y dimension (y-axis)
+ *
+ * Behaves like calling outputw_mat_ui32 for every matrix. HDF5 files store
+ * the timestamps in the dataset OUTPUT_HD5_CLOCK, they are zero if @p clock
+ * is NULL.
+ *
+ * @retval ERROR_IO
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FRAME_SHAPE
+ * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_NONE
+ *
+ */
+error_t outputw_mats_ui32(output_t *output, uint32_t *data, uint64_t *clock,
+                          uintptr_t count, uintptr_t dim_x, uintptr_t dim_y);
+
+/**
+ * @brief Prints a vector which holds i32 values.
+ *
+ * @param output Holds data about the output stream
+ * @param data Vector
+ * @param dim dimension of the vector
+ *
+ * Behaves like outputw_mat_ui32 with a matrix of width one, but HDF5 files
+ * store the vectors in a two dimensional dataset `frames[N][dim]`.
+ *
+ * @retval ERROR_IO
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FRAME_SHAPE
+ * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_NONE
+ *
+ */
+error_t outputw_vec_ui32(output_t *output, uint32_t *data, uintptr_t dim);
+
+/**
+ * @brief Prints multiple vectors which are stored consecutively in the
+ * memory.
+ *
+ * @param output Holds data about the output stream
+ * @param data count vectors
+ * @param clock timestamp counter at the start of every vector or NULL
+ * @param count amount of vectors
+ * @param dim dimension of one vector
+ *
+ * Behaves like calling outputw_vec_ui32 for every vector and stores the
+ * timestamps like outputw_mats_ui32.
+ *
+ * @retval ERROR_IO
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FRAME_SHAPE
+ * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_NONE
+ *
+ */
+error_t outputw_vecs_ui32(output_t *output, uint32_t *data, uint64_t *clock,
+                          uintptr_t count, uintptr_t dim);
+
+/**
+ * @brief Prints multiple classified matrices which are stored consecutively
+ * in the memory.
+ *
+ * @param output Holds data about the output stream
+ * @param bitmaps count bitmaps of classify_bitmap_size(dim_x * dim_y) bytes
+ * @param clock timestamp counter at the start of every matrix or NULL
+ * @param count amount of matrices
+ * @param dim_x dimension of the unpacked matrix (x-axis)
+ * @param dim_y dimension of the unpacked matrix (y-axis)
+ * @param threshold threshold of the classification
+ *
+ * HDF5 files store the bitmaps in the dataset OUTPUT_HD5_BITMAPS and .cnv
+ * files in records of the timestamp and the bitmap. Streams print every bit
+ * as 0 (hit) or 1 (miss) in the format of output_set_format. An output holds
+ * either values or bitmaps of one threshold.
+ *
+ * @retval ERROR_IO
+ * @retval ERROR_IO_CNV
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FRAME_SHAPE
+ * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_NONE
+ */
+error_t outputw_mats_bits(output_t *output, uint8_t *bitmaps, uint64_t *clock,
+                          uintptr_t count, uintptr_t dim_x, uintptr_t dim_y,
+                          uint32_t threshold);
+
+/**
+ * @brief Prints multiple classified vectors which are stored consecutively
+ * in the memory.
+ *
+ * @param output Holds data about the output stream
+ * @param bitmaps count bitmaps of classify_bitmap_size(dim) bytes
+ * @param clock timestamp counter at the start of every vector or NULL
+ * @param count amount of vectors
+ * @param dim dimension of one unpacked vector
+ * @param threshold threshold of the classification
+ *
+ * Behaves like outputw_mats_bits.
+ *
+ * @retval ERROR_IO
+ * @retval ERROR_IO_CNV
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FRAME_SHAPE
+ * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_NONE
+ */
+error_t outputw_vecs_bits(output_t *output, uint8_t *bitmaps, uint64_t *clock,
+                          uintptr_t count, uintptr_t dim, uint32_t threshold);
+
+/**
+ * @brief Writes the cycle histograms of all sets.
+ *
+ * @param output Holds data about the output stream
+ * @param histograms one histogram per set, all with the same amount of bins
+ * @param count amount of sets
+ *
+ * A HDF5 output gets the datasets OUTPUT_HD5_HISTOGRAMS and
+ * OUTPUT_HD5_SUMMARY. A stream gets one summary per set in its format, e.g.
+ * `set S: count N, mean M, ...` for text. A .cnv file has no room for
+ * histograms.
+ *
+ * @retval ERROR_IO
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_NONE
+ */
+error_t outputw_histograms(output_t *output, const stats_t *histograms,
+                           uintptr_t count);
+
+/**
+ * @brief Writes the timestamps of frames.
+ *
+ * @param output Holds data about the output stream
+ * @param timing the timestamps of @p count frames
+ * @param count amount of frames
+ *
+ * A HDF5 output appends them to the dataset OUTPUT_HD5_TIMING, which runs
+ * parallel to the frames. The other outputs only keep the timestamp counter
+ * at the start of a frame, so the timestamps are ignored.
+ *
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_NONE
+ */
+error_t outputw_timing(output_t *output, const frame_timing_t *timing,
+                       uintptr_t count);
+
+/**
+ * @brief Writes the summary of a window of frames.
+ *
+ * @param output Holds data about the output stream
+ * @param aggregate the accumulators of the window, with at least one frame
+ * @param rank 2 for matrices and 1 for vectors
+ * @param dim_x dimension of one frame (x-axis), 1 for vectors
+ * @param dim_y dimension of one frame (y-axis)
+ * @param threshold threshold of the misses
+ *
+ * A HDF5 output appends the window to the group OUTPUT_HD5_WINDOWS. A stream
+ * gets a line `window clock T frames F` followed by one line
+ * `set S: mean ...; max ...; miss ...` per set, csv one row
+ * `cpu,clock,set,quantity,v,...` per set and quantity and ndjson one object
+ * per window. A .cnv file has no room for windows.
+ *
+ * @retval ERROR_IO
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_NONE
+ */
+error_t outputw_window(output_t *output, const aggregate_t *aggregate,
+                       uint8_t rank, uintptr_t dim_x, uintptr_t dim_y,
+                       uint32_t threshold);
+
 /**
  * @brief Creates a new output_t with an FILE as output.
  *
@@ -75,14 +483,150 @@ error_t outputc_stdout(output_t *output, FILE *file);
  */
 error_t outputc_hd5_file(output_t *output, char *file);
 
+/**
+ * @brief Creates a new output_t which writes into a group of a HDF5 output.
+ *
+ * @param output Holds data about the output stream
+ * @param parent An output which was created with outputc_hd5_file.
+ * @param name Name of the new group.
+ *
+ * The group holds its own frames and clock datasets. It has to be closed
+ * before the parent is closed.
+ *
+ * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_NONE
+ *
+ */
+error_t outputc_hd5_group(output_t *output, output_t *parent,
+                          const char *name);
+
+/**
+ * @brief Creates a new output_t with a .cnv frame stream as output.
+ *
+ * @param output Holds data about the output stream
+ * @param file Path of the new file, an existing file is truncated.
+ * @param cache The profiled cache.
+ * @param timer The timer backend of the measurement.
+ * @param cpu The profiled CPU core.
+ *
+ * The frames are appended without any conversion with one pwritev per
+ * batch of up to OUTPUT_CNV_BATCH frames (see cnv_header_t).
+ *
+ * @retval ERROR_IO_CNV
+ * @retval ERROR_CHMOD
+ * @retval ERROR_NONE
+ *
+ */
+error_t outputc_cnv_file(output_t *output, const char *file,
+                         const cache_info_t *cache, timer_type_t timer,
+                         uint32_t cpu);
+
+/**
+ * @brief Writes all frames of a .cnv file to another output.
+ *
+ * @param path Path of the .cnv file.
+ * @param output An output, e.g. a HDF5 file or group.
+ *
+ * The file is mapped into the memory and every frame is passed on without
+ * parsing.
+ *
+ * @retval ERROR_IO_CNV
+ * @retval ERROR_IO
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FRAME_SHAPE
+ * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_NONE
+ */
+error_t output_cnv_convert(const char *path, output_t *output);
+
+/**
+ * @brief Sets the prefix of every line which is written to a stream.
+ *
+ * @param output Holds data about the output stream
+ * @param label The prefix, it is truncated to 15 characters.
+ *
+ * The label distinguishes the frames of multiple outputs which share the
+ * same stream. HDF5 outputs ignore the label.
+ */
+void output_set_label(output_t *output, const char *label);
+
+/**
+ * @brief Sets the text format of a stream output.
+ *
+ * @param output Holds data about the output stream
+ * @param format The format, OUTPUT_FORMAT_TEXT by default.
+ *
+ * Other outputs ignore the format.
+ */
+void output_set_format(output_t *output, output_format_t format);
+
+/**
+ * @brief Sets the CPU core which is written in the csv and ndjson formats.
+ *
+ * @param output Holds data about the output stream
+ * @param cpu The profiled CPU core.
+ */
+void output_set_cpu(output_t *output, uint32_t cpu);
+
+/**
+ * @brief Records which sets and ways of the cache were probed.
+ *
+ * @param output Holds data about the output stream
+ * @param sets the ids of the probed sets in the order of the rows of a frame
+ * or NULL for all sets
+ * @param set_count amount of probed sets
+ * @param ways the ids of the probed ways in the order of the columns of a
+ * frame or NULL for all ways
+ * @param way_count amount of probed ways
+ *
+ * HDF5 outputs get the datasets OUTPUT_HD5_SETS and OUTPUT_HD5_WAYS and
+ * .cnv files store the ids behind their header. Streams label every row
+ * with the id of its set instead of its index. This has to be called before
+ * the first frame is written.
+ *
+ * @retval ERROR_INVALID_ARGUMENT if a frame was already written
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_IO_CNV
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+error_t output_set_mask(output_t *output, const uint32_t *sets,
+                        uint32_t set_count, const uint32_t *ways,
+                        uint32_t way_count);
+
+/**
+ * @brief Parses the name of a text format.
+ *
+ * @param name one of "text", "csv" or "ndjson"
+ * @param format writes the parsed format into
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_NONE
+ */
+error_t output_format_from(const char *name, output_format_t *format);
+
+/**
+ * @brief Returns the name of a text format.
+ *
+ * @param format the format
+ *
+ * @return The name which is accepted by output_format_from.
+ */
+const char *output_format_name(output_format_t format);
+
 /**
  * @breif Closes the streams and flushes them.
  *
  * @param output Holds data about the output stream
  *
  * After this operation the output_t struct has to be initialized again.
+ * Frames which are still buffered are written before the file is closed.
  *
  * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_IO_CNV
+ * @retval ERROR_IO
  * @retval ERROR_NONE
  *
  */
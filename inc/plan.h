@@ -0,0 +1,182 @@
+/**
+ * @file plan.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the address plan which is walked by the prime and probe
+ * kernels.
+ */
+
+#pragma once
+
+#include "arena.h"
+#include "error.h"
+#include "sys_info.h"
+
+#include <stdint.h>
+
+/**
+ * @brief available traversal orders of a probe plan.
+ */
+typedef enum plan_order {
+    PLAN_ORDER_LINEAR,  /**< Sets ascending, ways ascending within a set. */
+    PLAN_ORDER_REVERSE, /**< Sets descending, ways descending within a set. */
+    PLAN_ORDER_RANDOM   /**< A random permutation of all cache lines. */
+} plan_order_t;
+
+/**
+ * @brief available measurement granularities of a probe plan.
+ */
+typedef enum plan_granularity {
+    PLAN_GRANULARITY_LINE, /**< One measurement per cache line. */
+    PLAN_GRANULARITY_SET   /**< One measurement per cache set. */
+} plan_granularity_t;
+
+/**
+ * @brief One cache line of a probe plan.
+ *
+ * The probe kernel accesses plan_entry_t#line and writes the measured time to
+ * the index plan_entry_t#slot of the result buffer. Therefore the layout of
+ * the result is always [set][way], independent of the traversal order.
+ *
+ * If the plan has the granularity PLAN_GRANULARITY_SET, an entry represents a
+ * whole set. plan_entry_t#line is the first cache line of a linked list which
+ * is embedded in the buffer: the first 8 bytes of every cache line of the set
+ * hold the address of the next cache line, the last one holds zero. The next
+ * 8 bytes hold the address of the previous cache line, the first one holds
+ * zero. The slot is the index of the set.
+ */
+typedef struct plan_entry_s {
+    uintptr_t line; /**< Virtual address of the cache line. */
+    uint64_t slot;  /**< Index in the result buffer (set * ways + way). */
+} plan_entry_t;
+
+/**
+ * @brief All cache lines of a buffer in the order in which they are probed.
+ *
+ * The plan is built once per cache, so the kernels do not have to compute
+ * the address of a cache line while they are running. The prime kernel walks
+ * the plan backwards and the probe kernel walks it forwards. A fused probe,
+ * which also primes the cache for the next frame, alternates between both
+ * directions and walks probe_plan_t#reverse backwards.
+ */
+typedef struct probe_plan_s {
+    plan_entry_t *entries; /**< The cache lines in traversal order. */
+    plan_entry_t *reverse; /**< The entries of a backward walk, in the same
+                              order as probe_plan_t#entries. These are the
+                              entries themselves, or the last cache line of
+                              every set with PLAN_GRANULARITY_SET. */
+    uintptr_t count;       /**< Amount of entries. */
+    uint32_t set_count;    /**< Amount of sets in the result. */
+    uint32_t way_count;    /**< Amount of ways in the result. */
+    plan_order_t order;    /**< Traversal order of the entries. */
+    plan_granularity_t granularity; /**< What one entry measures. */
+    int in_arena; /**< If not zero, the entries belong to an arena and are not
+                     freed with the plan. */
+} probe_plan_t;
+
+/**
+ * @brief Builds a probe plan for a cache aligned buffer.
+ *
+ * @param plan the plan which gets initialized
+ * @param cache information about the cache which the buffer corresponds to
+ * @param buffer cache aligned buffer (see alloc_aligned)
+ * @param sets the probed sets in the order of the result or NULL for all
+ * sets
+ * @param set_count amount of probed sets, ignored if @p sets is NULL
+ * @param ways the probed ways in the order of the result or NULL for all
+ * ways
+ * @param way_count amount of probed ways, ignored if @p ways is NULL
+ * @param order the traversal order of the plan
+ * @param granularity measure every cache line or every set
+ * @param arena the arena of the entries or NULL to allocate them on the heap
+ *
+ * The cache line of set `s` and way `w` is located at
+ * `buffer + (w * set_count + s) * line_size`. With PLAN_GRANULARITY_SET the
+ * linked lists of the sets are written into the buffer.
+ *
+ * Only the selected sets and ways are part of the plan, so the kernels touch
+ * no other cache line and a frame holds `set_count * way_count` values. The
+ * ways which are not primed are left to other processes, so fewer ways make
+ * the probe faster but need more foreign accesses for a miss.
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_ARENA
+ * @retval ERROR_NONE
+ */
+error_t probe_plan_new(probe_plan_t *plan, const cache_info_t *cache,
+                       void *buffer, const uint32_t *sets, uint32_t set_count,
+                       const uint32_t *ways, uint32_t way_count,
+                       plan_order_t order, plan_granularity_t granularity,
+                       arena_t *arena);
+
+/**
+ * @brief Builds a probe plan from a table of cache lines.
+ *
+ * @param plan the plan which gets initialized
+ * @param lines virtual addresses of the cache lines, the line of set `s`
+ * and way `w` is `lines[s * way_count + w]`
+ * @param set_count amount of sets in the table
+ * @param way_count amount of ways in the table
+ * @param ways the probed ways (columns of the table) in the order of the
+ * result or NULL for all ways
+ * @param selected amount of probed ways, ignored if @p ways is NULL
+ * @param order the traversal order of the plan
+ * @param granularity measure every cache line or every set
+ * @param arena the arena of the entries or NULL to allocate them on the heap
+ *
+ * This is used for caches where the cache lines of a set are not at fixed
+ * offsets of one buffer, e.g. the eviction sets of a sliced last level
+ * cache.
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_ARENA
+ * @retval ERROR_NONE
+ */
+error_t probe_plan_from_lines(probe_plan_t *plan, const uintptr_t *lines,
+                              uint32_t set_count, uint32_t way_count,
+                              const uint32_t *ways, uint32_t selected,
+                              plan_order_t order,
+                              plan_granularity_t granularity,
+                              arena_t *arena);
+
+/**
+ * @brief Returns the amount of values which are measured by a plan.
+ *
+ * @param plan the plan
+ *
+ * @return set_count * way_count for PLAN_GRANULARITY_LINE and set_count for
+ * PLAN_GRANULARITY_SET.
+ */
+uintptr_t probe_plan_frame_length(const probe_plan_t *plan);
+
+/**
+ * @brief Frees the memory of a probe plan.
+ *
+ * @param plan the plan which gets freed
+ */
+void probe_plan_free(probe_plan_t *plan);
+
+/**
+ * @brief Parses the name of a traversal order.
+ *
+ * @param name one of "linear", "reverse" or "random"
+ * @param order writes the parsed order into
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_NONE
+ */
+error_t plan_order_from(const char *name, plan_order_t *order);
+
+/**
+ * @brief Parses the name of a granularity.
+ *
+ * @param name one of "line" or "set"
+ * @param granularity writes the parsed granularity into
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_NONE
+ */
+error_t plan_granularity_from(const char *name,
+                              plan_granularity_t *granularity);
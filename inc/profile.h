@@ -7,25 +7,126 @@
 
 #pragma once
 
+#include "calibration.h"
 #include "error.h"
 #include "output.h"
+#include "plan.h"
 #include "sys_info.h"
+#include "timer.h"
 
 #include <stdint.h>
 
 /**
- * @brief Profiles the cache and prints the result to the output.
+ * @brief A CPU core which is profiled by its own probe thread.
+ */
+typedef struct profile_core_s {
+    uint32_t cpu;              /**< CPU core of the probe thread. */
+    const probe_plan_t *plan;  /**< The cache lines which are probed. */
+    output_t *output;          /**< Output of the frames of this core. */
+    uint32_t threshold;        /**< Threshold of the classification or zero
+                                  to calibrate it before the measurement. */
+    uint32_t limit;            /**< Values above are clamped to the limit
+                                  (outliers), zero to keep all values. */
+} profile_core_t;
+
+/**
+ * @brief Amount of bins of the histograms of a line granular profile.
+ */
+#define PROFILE_HISTOGRAM_BINS 1024
+
+/**
+ * @brief Amount of bins of the histograms of a set granular profile, where
+ * a value is the time of all ways of a set.
+ */
+#define PROFILE_HISTOGRAM_SET_BINS 4096
+
+/**
+ * @brief available kinds of per set histograms of a profile.
+ */
+typedef enum profile_histograms {
+    HISTOGRAMS_OFF,         /**< Only the frames are written. */
+    HISTOGRAMS_WITH_FRAMES, /**< The histograms are written after the frames. */
+    HISTOGRAMS_ONLY         /**< Only the histograms are written. */
+} profile_histograms_t;
+
+/**
+ * @brief Settings of a profiling run.
+ */
+typedef struct profile_config_s {
+    int bind;            /**< If not zero, every probe thread is bound to the
+                            CPU core of its profile_core_t. */
+    uint32_t iterations; /**< The program will run for n iterations or
+                            endlessly if this is zero. */
+    int32_t writer_cpu;  /**< CPU of the writer thread or -1 if the writer
+                            thread should not be bound. */
+    uintptr_t ring_size; /**< Amount of frames in the ring between a probe
+                            and the writer thread or zero for
+                            RING_DEFAULT_SIZE bytes shared by all rings. */
+    timer_type_t timer;  /**< The timer backend which is used in the probe
+                            kernel. */
+    arena_t *arena;      /**< Arena of the frames of the rings or NULL to
+                            allocate them on the heap. */
+    int classify;        /**< If not zero, the frames are written as hit/miss
+                            bitmaps (see classify.h) with the threshold of
+                            profile_core_t#threshold. */
+    profile_histograms_t histograms; /**< Whether every core counts the values
+                                        of every set in a histogram (see
+                                        stats.h), which is written to its
+                                        output after the last frame. */
+    uint32_t aggregate; /**< If not zero, every core writes the mean, the
+                           maximum and the miss rate of windows of this many
+                           frames (see aggregate.h) instead of the frames. */
+    int fused;               /**< If not zero, the probe of a frame also
+                                primes the next frame, alternating the
+                                direction of the walk every frame. */
+    int stats;               /**< If not zero, the counters of the probe and
+                                the writer threads (see counters.h) are
+                                printed to stderr at the end. */
+    uint32_t stats_interval; /**< If not zero, a line with the rates of all
+                                threads is printed to stderr every this many
+                                seconds. */
+} profile_config_t;
+
+/**
+ * @brief Profiles the caches of one or more CPU cores and prints the results
+ * to their outputs.
  *
- * @param cache pointer to information about the cache which is profiled
- * @param cpu the bounded cpu id
- * @param output file descriptor of the file where the results will be printed
- * @param iterations the program will run for n iterations
- * @param buffer cache aligned buffer
+ * @param cores the profiled CPU cores with their plans and outputs
+ * @param core_count amount of profiled CPU cores
+ * @param config settings of the profiling run
+ *
+ * Every core is probed by its own thread. The threads calibrate their timers
+ * and then wait for each other, so the first frames of all cores start at
+ * the same time. The timestamp counter at the start of every frame is written
+ * with the frame, so frames of different cores can be aligned afterwards.
+ *
+ * Primes the cache by loading all cache lines of the plan. Then the time it
+ * takes to access memory from a single cache line is measured and stored in a
+ * separate buffer. After all cache lines have been accessed the result buffer
+ * gets printed to the output. With profile_config_t#fused only the first
+ * frame is primed, every probe leaves the cache lines of the plan in the
+ * cache for the next one.
+ *
+ * Before the first frame the overhead of the timer backend is calibrated. It
+ * gets subtracted from every measurement. If the frames are classified or
+ * aggregated and a core has no threshold, its probe thread probes
+ * CLASSIFY_CALIBRATION_FRAMES frames right after priming and derives its
+ * threshold with classify_threshold.
+ *
+ * The results are passed through one frame ring per core to a single writer
+ * thread, so the measurement loops never wait for the output. If a ring is
+ * full the frame gets dropped and the amount of dropped frames is reported at
+ * the end. With profile_config_t#histograms the writer thread also counts the
+ * values of every set, and the histograms are written to the outputs after
+ * the writer thread has stopped. With profile_config_t#aggregate the writer
+ * thread accumulates the frames and writes a window whenever it is complete,
+ * the last incomplete window is written after the writer thread has stopped.
  *
- * Allocates a buffer the size of the cache, which is aligned to the cache
- * lines. Then the time it takes to access memory from a single cache line is
- * measured and stored in a separate buffer. After all cache lines have been
- * accessed the result buffer gets printed to the output.
+ * Every frame records its timestamps and the cycles of prime, sched_yield
+ * and probe (see frame_timing.h), which HDF5 outputs store next to the
+ * frames. At the end the share of every part of the loop is printed per
+ * core. The threads also keep counters (see counters.h), which
+ * profile_config_t#stats and profile_config_t#stats_interval print.
  *
  * @retval ERROR_ALLOCATION
  * @retval ERROR_SYSCONF
@@ -35,23 +136,162 @@
  * @retval ERROR_FD_CYCLE_CLOSE
  * @retval ERROR_HDF5_ERROR
  * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_SET_AFFINITY
+ * @retval ERROR_THREAD
  * @retval ERROR_NONE
  *
  */
-error_t profile(const cache_info_t *cache, uint32_t cpu, uint32_t iterations,
-                const void *buffer, output_t *output);
+error_t profile(const profile_core_t *cores, uint32_t core_count,
+                const profile_config_t *config);
 
 /**
  * @brief benchmarks the accuracy of the measurement
  *
  * @param iterations specifies the number of times the measurements will be
  * repeated
+ * @param cpu the bounded cpu id
+ *
+ * This benchmark measures the time of different performance timer. For every
+ * timer backend the overhead and jitter of an empty measurement are reported,
+ * followed by the time of a cache hit and a cache miss. The measurements are
+ * taken in batches and counted in a histogram (see stats.h), so the memory
+ * does not grow with @p iterations.
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FD_CYCLE
+ * @retval ERROR_FD_CYCLE_CLOSE
+ * @retval ERROR_NONE
+ *
+ */
+error_t benchmark(uint64_t iterations, uint32_t cpu);
+
+/**
+ * @brief benchmarks the text formats of the stream output
+ *
+ * @param cache the profiled cache, which gives the shape of the frames
+ *
+ * Synthetic frames with the shape of @p cache are written in batches to
+ * /dev/null in every output_format_t and the throughput is reported in
+ * frames per second.
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_IO
+ * @retval ERROR_NONE
+ */
+error_t benchmark_output(const cache_info_t *cache);
+
+/**
+ * @brief benchmarks the load latency of the memory hierarchy
  *
- * This benchmark measures the time of different performance timer.
+ * @param caches the data or unified caches of the CPU core, ordered by level
+ * @param level_count amount of caches
+ * @param cpu the bounded cpu id
+ *
+ * A pointer chase through a random cycle of the cache lines of a hugepage
+ * buffer is timed for every working set from 4 KiB to 1 GiB, doubling the
+ * size at every step. The cycles per load form a ladder with one rung per
+ * level of the memory hierarchy. Every cache of @p caches is confirmed if the
+ * latency rises between half and twice its size, otherwise the reported
+ * geometry does not match the hardware. Without enough reserved hugepages
+ * the ladder stops at the largest working set which fits.
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FD_CYCLE
+ * @retval ERROR_FD_CYCLE_CLOSE
+ * @retval ERROR_MUNMAP
+ * @retval ERROR_SYSCONF
+ * @retval ERROR_IO_PROC_MEMINFO
+ * @retval ERROR_FMT
+ * @retval ERROR_NONE
+ */
+error_t benchmark_latency(const cache_info_t *caches, uint32_t level_count,
+                          uint32_t cpu);
+
+/**
+ * @brief validates the fused probe against the separate prime and probe
+ *
+ * @param cache the profiled cache
+ * @param type the timer backend, rdpmc falls back to rdtscp if the cycle
+ * counter can not be used
+ * @param cpu the bounded cpu id
+ *
+ * A victim loads half of the ways of every fourth set before every probe.
+ * The frames are probed once with a prime before every probe and once with
+ * the fused probe of profile_config_t#fused. For both modes the frame rate
+ * and the share of the frames with a miss in the victim sets and in the
+ * idle sets are reported. The fused probe matches if the shares of both
+ * modes differ by at most 10 percentage points. If the separate prime and
+ * probe does not see the victim, e.g. because the timer can not tell the
+ * levels apart, the comparison is inconclusive. Without reserved hugepages
+ * the benchmark is skipped.
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_SYSCONF
+ * @retval ERROR_IO_PROC_MEMINFO
+ * @retval ERROR_IO_PROC_SELF_PAGEMAP
+ * @retval ERROR_FMT
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_FD_CYCLE
+ * @retval ERROR_FD_CYCLE_CLOSE
+ * @retval ERROR_NONE
+ */
+error_t benchmark_fused(const cache_info_t *cache, timer_type_t type,
+                        uint32_t cpu);
+
+/**
+ * @brief benchmarks the prime kernels
  *
+ * @param cache the profiled cache
+ * @param type the timer backend, rdpmc falls back to rdtscp if the cycle
+ * counter can not be used
+ * @param cpu the bounded cpu id
+ *
+ * The fenced reference kernel, the generic kernel and, if one matches the
+ * ways of @p cache, the unrolled kernel prime a buffer of the size of
+ * @p cache. For every kernel the cycles per cache line are reported. To
+ * prove that the kernel evicts the whole cache, a victim buffer of the same
+ * geometry is loaded and probed after the prime, every line of it has to
+ * miss. A warning is printed if less than 90% of the victim lines miss. If
+ * the victim is not slower than the primed lines, the timer can not tell
+ * the levels apart and the result is inconclusive. Without reserved
+ * hugepages the benchmark is skipped.
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_SYSCONF
+ * @retval ERROR_IO_PROC_MEMINFO
+ * @retval ERROR_IO_PROC_SELF_PAGEMAP
+ * @retval ERROR_FMT
+ * @retval ERROR_INVALID_ARGUMENT
  * @retval ERROR_FD_CYCLE
  * @retval ERROR_FD_CYCLE_CLOSE
  * @retval ERROR_NONE
+ */
+error_t benchmark_prime(const cache_info_t *cache, timer_type_t type,
+                        uint32_t cpu);
+
+/**
+ * @brief Calibrates the access times of all cache levels of a CPU core.
+ *
+ * @param caches the data or unified caches of the levels 1 to @p level_count
+ * @param level_count amount of cache levels
+ * @param type the timer backend
+ * @param cpu the CPU core, which this thread has to be bound to
+ * @param calibration writes the calibration into
  *
+ * For every level a buffer which fits into the level is primed, the closer
+ * levels are flushed by walking a buffer of twice their size and the
+ * buffer is probed with the probe kernel of @p type in random order. The
+ * DRAM access is measured after flushing the buffer with clflush. The
+ * thresholds are derived with calibration_derive, a warning is printed if
+ * two levels can not be separated.
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_MMAP
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FD_CYCLE
+ * @retval ERROR_FD_CYCLE_CLOSE
+ * @retval ERROR_NONE
  */
-error_t benchmark(uint64_t iterations);
+error_t calibrate_cpu(const cache_info_t *caches, uint32_t level_count,
+                      timer_type_t type, uint32_t cpu,
+                      calibration_t *calibration);
@@ -0,0 +1,208 @@
+/**
+ * @file ring.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains a lock-free frame ring and the writer thread which drains it.
+ *
+ * The probe thread is the single producer of a frame ring and the writer
+ * thread is its single consumer. This decouples the measurement loop from
+ * the latency of the output.
+ */
+
+#pragma once
+
+#include "aggregate.h"
+#include "arena.h"
+#include "counters.h"
+#include "error.h"
+#include "frame_timing.h"
+#include "output.h"
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/**
+ * @brief Size of a cache line, used to keep the ring indices apart.
+ */
+#define RING_ALIGNMENT 64
+
+/**
+ * @brief Default memory which is used for the frames of a ring.
+ */
+#define RING_DEFAULT_SIZE (64 * 1024 * 1024)
+
+/**
+ * @brief A preallocated single-producer single-consumer ring of frames.
+ *
+ * The producer and the consumer never block each other. If the ring is full
+ * the producer drops the frame and increments frame_ring_t#dropped.
+ */
+typedef struct frame_ring_s {
+    uint32_t *frames;       /**< capacity * frame_length values. */
+    uint64_t *clock;        /**< Timestamp counter at the start of a frame. */
+    frame_timing_t *timing; /**< Timestamps and durations of a frame. */
+    uintptr_t frame_length; /**< Amount of values in one frame. */
+    uintptr_t capacity;     /**< Amount of frames, always a power of two. */
+    int in_arena;           /**< If not zero, the frames belong to an arena
+                               and are not freed with the ring. */
+    _Alignas(RING_ALIGNMENT) atomic_uintptr_t head; /**< Next frame to write. */
+    _Alignas(RING_ALIGNMENT) atomic_uintptr_t tail; /**< Next frame to read. */
+    _Alignas(RING_ALIGNMENT) atomic_uintptr_t dropped; /**< Dropped frames. */
+    atomic_int closed;        /**< Set by the producer after the last frame. */
+    atomic_int failed;        /**< Set by the consumer if the output failed. */
+} frame_ring_t;
+
+/**
+ * @brief Initializes a frame ring.
+ *
+ * @param ring the ring which gets initialized
+ * @param frame_length amount of uint32_t values in one frame
+ * @param capacity amount of frames, rounded down to a power of two (at least
+ * two)
+ * @param arena the arena of the frames or NULL to allocate them on the heap
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_ARENA
+ * @retval ERROR_NONE
+ */
+error_t frame_ring_new(frame_ring_t *ring, uintptr_t frame_length,
+                       uintptr_t capacity, arena_t *arena);
+
+/**
+ * @brief Frees the memory of a frame ring.
+ *
+ * @param ring the ring which gets freed
+ */
+void frame_ring_free(frame_ring_t *ring);
+
+/**
+ * @brief Returns the next free frame of the ring (producer only).
+ *
+ * @param ring the ring
+ *
+ * @return A pointer to the next frame or NULL if the ring is full. In the
+ * latter case the frame counts as dropped.
+ */
+uint32_t *frame_ring_reserve(frame_ring_t *ring);
+
+/**
+ * @brief Publishes the frame returned by frame_ring_reserve (producer only).
+ *
+ * @param ring the ring
+ * @param timing timestamps of the frame, frame_timing_t#tsc_start is the
+ * clock of the frame
+ */
+void frame_ring_commit(frame_ring_t *ring, const frame_timing_t *timing);
+
+/**
+ * @brief Marks the ring as finished (producer only).
+ *
+ * @param ring the ring
+ */
+void frame_ring_close(frame_ring_t *ring);
+
+/**
+ * @brief Returns the committed frames which are stored consecutively
+ * (consumer only).
+ *
+ * @param ring the ring
+ * @param frames writes a pointer to the first committed frame into
+ * @param clock writes a pointer to the timestamp of the first committed frame
+ * into
+ * @param timing writes a pointer to the timestamps of the first committed
+ * frame into
+ *
+ * @return The amount of consecutive frames, which can be less than the amount
+ * of committed frames if the frames wrap around the end of the ring.
+ */
+uintptr_t frame_ring_peek(frame_ring_t *ring, uint32_t **frames,
+                          uint64_t **clock, frame_timing_t **timing);
+
+/**
+ * @brief Gives frames back to the producer (consumer only).
+ *
+ * @param ring the ring
+ * @param count amount of frames which have been processed
+ */
+void frame_ring_release(frame_ring_t *ring, uintptr_t count);
+
+/**
+ * @brief A frame ring and the output it is drained into.
+ */
+typedef struct writer_channel_s {
+    frame_ring_t *ring; /**< Ring which is drained. */
+    output_t *output;   /**< Output where the frames are written to. */
+    uint8_t rank;       /**< 2 for matrices and 1 for vectors. */
+    uintptr_t dim_x;    /**< Width of one frame, ignored for vectors. */
+    uintptr_t dim_y;    /**< Height of one frame. */
+    uint8_t *bitmaps;   /**< Room for the bitmaps of all frames of the ring
+                           if the frames are classified, otherwise NULL. */
+    uint32_t threshold; /**< Threshold of the classification, written by the
+                           producer before its first frame. */
+    uint32_t limit;     /**< Values above are clamped to the limit before
+                           they are written, zero to keep all values. */
+    stats_t *histograms; /**< One histogram per set (dim_y), which counts
+                            the values of every frame, or NULL. */
+    int skip_frames;    /**< If not zero, the frames only go into the
+                           histograms and are not written. */
+    aggregate_t *aggregate; /**< Accumulators of the current window, which
+                               replace the frames in the output, or NULL. */
+} writer_channel_t;
+
+/**
+ * @brief A thread which drains frame rings into outputs.
+ *
+ * A single thread serves all rings, because the HDF5 library may not be
+ * used by multiple threads at once.
+ */
+typedef struct writer_s {
+    pthread_t thread;            /**< The writer thread. */
+    writer_channel_t *channels;  /**< Rings and their outputs. */
+    uint32_t channel_count;      /**< Amount of channels. */
+    int32_t cpu;   /**< CPU of the thread or -1 if it is not bound. */
+    error_t error; /**< Error code of the thread. */
+    writer_counters_t counters; /**< Counters of the thread, which may be
+                                   read while it runs. */
+} writer_t;
+
+/**
+ * @brief Starts a writer thread.
+ *
+ * @param writer the writer which gets started
+ * @param channels the rings which get drained, the array has to be valid
+ * until writer_stop returned
+ * @param channel_count amount of channels
+ * @param cpu CPU to which the thread gets bound or -1
+ *
+ * The thread blocks all signals, so that the signal handlers always run in
+ * the main thread. If an output fails, all rings are marked as failed.
+ *
+ * @retval ERROR_THREAD
+ * @retval ERROR_NONE
+ */
+error_t writer_start(writer_t *writer, writer_channel_t *channels,
+                     uint32_t channel_count, int32_t cpu);
+
+/**
+ * @brief Closes all rings and waits until the writer wrote all frames.
+ *
+ * @param writer the writer which gets stopped
+ *
+ * @return The first error of the writer thread.
+ */
+error_t writer_stop(writer_t *writer);
+
+/**
+ * @brief Starts a thread with all signals blocked.
+ *
+ * @param thread writes the thread into
+ * @param run main function of the thread
+ * @param arg argument of @p run
+ *
+ * @retval ERROR_THREAD
+ * @retval ERROR_NONE
+ */
+error_t thread_start_masked(pthread_t *thread, void *(*run)(void *),
+                            void *arg);
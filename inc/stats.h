@@ -0,0 +1,137 @@
+/**
+ * @file stats.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains streaming statistics of cycle counts in constant memory.
+ *
+ * Instead of storing every sample and sorting it, the values are counted in a
+ * histogram with one bin per cycle. Values below the amount of bins give
+ * exact percentiles, larger values (reschedules, interrupts) are only
+ * counted. The mean and the variance are updated with the algorithm of
+ * Welford, so they include every value.
+ */
+
+#pragma once
+
+#include "error.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Default amount of bins, which covers hits and misses of all
+ * cache levels.
+ */
+#define STATS_DEFAULT_BINS 4096
+
+/**
+ * @brief Returned by stats_percentile if the percentile is not below the
+ * amount of bins.
+ */
+#define STATS_OVERFLOW UINT32_MAX
+
+/**
+ * @brief Streaming statistics of cycle counts.
+ */
+typedef struct stats_s {
+    uint64_t *histogram; /**< Count of every value below stats_t#bins. */
+    uint32_t bins;       /**< Amount of bins of the histogram. */
+    uint64_t overflow;   /**< Count of the values which have no bin. */
+    uint64_t count;      /**< Count of all values. */
+    double mean;         /**< Arithmetic mean of all values. */
+    double m2;           /**< Sum of the squared differences from the mean. */
+    uint32_t min;        /**< Smallest value. */
+    uint32_t max;        /**< Largest value. */
+} stats_t;
+
+/**
+ * @brief Initializes empty statistics.
+ *
+ * @param stats the statistics which get initialized
+ * @param bins amount of bins, values from zero to @p bins - 1 get exact
+ * percentiles
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+error_t stats_new(stats_t *stats, uint32_t bins);
+
+/**
+ * @brief Removes all values from statistics.
+ *
+ * @param stats the statistics
+ */
+void stats_reset(stats_t *stats);
+
+/**
+ * @brief Adds a value to statistics.
+ *
+ * @param stats the statistics
+ * @param value the value
+ */
+static inline void stats_add(stats_t *stats, uint32_t value) {
+    if (value < stats->bins) {
+        stats->histogram[value]++;
+    } else {
+        stats->overflow++;
+    }
+
+    if (!stats->count || value < stats->min) {
+        stats->min = value;
+    }
+    if (!stats->count || value > stats->max) {
+        stats->max = value;
+    }
+
+    stats->count++;
+    double delta = value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+}
+
+/**
+ * @brief Adds an array of values to statistics.
+ *
+ * @param stats the statistics
+ * @param values the values
+ * @param length amount of values
+ */
+void stats_add_values(stats_t *stats, const uint32_t *values,
+                      uintptr_t length);
+
+/**
+ * @brief Returns a percentile of statistics.
+ *
+ * @param stats the statistics
+ * @param fraction the percentile as a fraction, e.g. 0.99 for p99
+ *
+ * @return The smallest value which is at least as large as @p fraction of
+ * all values, zero without values or STATS_OVERFLOW if the value has no
+ * bin.
+ */
+uint32_t stats_percentile(const stats_t *stats, double fraction);
+
+/**
+ * @brief Returns the empirical variance of statistics.
+ *
+ * @param stats the statistics
+ *
+ * @return The variance or zero for less than two values.
+ */
+double stats_variance(const stats_t *stats);
+
+/**
+ * @brief Prints the median, mean, variance and tail percentiles.
+ *
+ * @param stats the statistics
+ * @param file the output stream
+ */
+void stats_print(const stats_t *stats, FILE *file);
+
+/**
+ * @brief Frees the histogram of statistics.
+ *
+ * @param stats the statistics which get freed
+ */
+void stats_free(stats_t *stats);
@@ -25,6 +25,19 @@
  */
 error_t focus_cpu_core(uint32_t pid, uint32_t cpu);
 
+/**
+ * @brief Locks a process to a set of CPU cores
+ *
+ * @param pid Process id which will be bound
+ * @param cpus ids of the CPUs the process will be bound to
+ * @param count amount of CPUs
+ *
+ * @retval ERROR_SET_AFFINITY
+ * @retval ERROR_NONE
+ *
+ */
+error_t focus_cpu_cores(uint32_t pid, const uint32_t *cpus, uint32_t count);
+
 /**
  * @brief Enables a CPU cycle counter which can be read with RDPMC
  *
@@ -157,6 +157,56 @@ error_t pagemap_entry_from(pagemap_entry_t *entry, uint64_t offset);
  */
 error_t get_physical_address(const void *addr, uintptr_t *target);
 
+/**
+ * @brief An open /proc/self/pagemap.
+ *
+ * Opening the pagemap and computing the page shift is done once, so
+ * translating many pages only costs one pread per range of pages.
+ */
+typedef struct pagemap_s {
+    int fd;              /**< File descriptor of /proc/self/pagemap. */
+    uint64_t page_size;  /**< Size of a small page. */
+    uint32_t page_shift; /**< log2 of pagemap_t#page_size. */
+} pagemap_t;
+
+/**
+ * @brief Opens /proc/self/pagemap.
+ *
+ * @param pagemap the pagemap which gets initialized
+ *
+ * @retval ERROR_IO_PROC_SELF_PAGEMAP
+ * @retval ERROR_SYSCONF
+ * @retval ERROR_NONE
+ */
+error_t pagemap_open(pagemap_t *pagemap);
+
+/**
+ * @brief Translates consecutive small pages into physical addresses.
+ *
+ * @param pagemap the open pagemap
+ * @param addr any virtual address in the first page
+ * @param count amount of consecutive small pages
+ * @param physical writes the physical address of the start of every page
+ * into
+ *
+ * Reads the entries of all pages with a single pread. The pages have to be
+ * present in the ram, e.g. by touching them or by mapping them with
+ * MAP_POPULATE.
+ *
+ * @retval ERROR_IO_PROC_SELF_PAGEMAP
+ * @retval ERROR_PAGE_ENTRY
+ * @retval ERROR_NONE
+ */
+error_t pagemap_translate(const pagemap_t *pagemap, const void *addr,
+                          uintptr_t count, uintptr_t *physical);
+
+/**
+ * @brief Closes the pagemap.
+ *
+ * @param pagemap the pagemap which gets closed
+ */
+void pagemap_close(pagemap_t *pagemap);
+
 /**
  * @brief Returns the number of possible hugepages in the system
  *
@@ -216,3 +266,53 @@ error_t get_current_cpu_core(uint32_t *core);
  * @retval ERROR_NONE
  */
 error_t can_use_rdpmc();
+
+/**
+ * @brief Returns a CPU core on which this process may run, other than the
+ * given ones.
+ *
+ * @param cpus the CPU cores which are excluded
+ * @param count amount of excluded CPU cores
+ * @param other the id of the other CPU core or -1 if there is none
+ *
+ * Uses the current CPU affinity of this process, so this has to be called
+ * before the process is bound to a single CPU core.
+ *
+ * @retval ERROR_GET_CPU_CORE
+ * @retval ERROR_NONE
+ *
+ */
+error_t get_other_cpu_core(const uint32_t *cpus, uint32_t count,
+                           int32_t *other);
+
+/**
+ * @brief Parses a list of ids in the format of the sysfs cpu lists.
+ *
+ * @param list comma separated ids or inclusive ranges, e.g. "0-15,32"
+ * @param ids writes a pointer to the allocated ids into, which has to be freed
+ * @param count writes the amount of ids into
+ *
+ * The ids keep the order of the list, duplicates are removed.
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+error_t parse_id_list(const char *list, uint32_t **ids, uint32_t *count);
+
+/**
+ * @brief Returns the amount of slices of a shared cache.
+ *
+ * @param info Filled cache_info_t of the cache
+ * @param slices Writes the amount of slices into.
+ *
+ * Intel CPUs have one slice of the last level cache per physical core. The
+ * amount is derived from the CPUs which share the cache (shared_cpu_list)
+ * and the hyper threads of the CPU of the cache (thread_siblings_list).
+ *
+ * @retval ERROR_IO_SYS_CPU
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+error_t get_slice_count(const cache_info_t *info, uint32_t *slices);
@@ -0,0 +1,162 @@
+/**
+ * @file timer.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the timing primitives which are used by the kernels.
+ *
+ * Every timer backend is defined by three assembly fragments. START reads the
+ * first timestamp and saves its lower 32 bit in r8d. STOP reads the second
+ * timestamp and leaves the difference in eax. SERIALIZE is executed after the
+ * result has been stored. The fragments clobber rax, rbx, rcx, rdx and r8.
+ */
+
+#pragma once
+
+#include "error.h"
+
+#include <stdint.h>
+
+/**
+ * @brief The fixed performance counter which counts the core cycles.
+ */
+#define TIMER_RDPMC_COUNTER "$1073741825"
+
+#define TIMER_RDPMC_START                                                      \
+    "cpuid;" /* serialize execution */                                         \
+    "mov " TIMER_RDPMC_COUNTER ", %%ecx;"                                      \
+    "rdpmc;"            /* load timestamps into edx:eax */                     \
+    "mov %%eax, %%r8d;" /* save the lower 32 bit of the first timestamp */     \
+    "mfence;"
+
+#define TIMER_RDPMC_STOP                                                       \
+    "mfence;"                                                                  \
+    "mov " TIMER_RDPMC_COUNTER ", %%ecx;"                                      \
+    "rdpmc;"            /* load timestamps into edx:eax */                     \
+    "sub %%r8d, %%eax;" /* eax = eax - r8 (end - start) */
+
+#define TIMER_RDPMC_SERIALIZE                                                  \
+    "mfence;"                                                                  \
+    "cpuid;" /* serialize execution */
+
+#define TIMER_RDTSCP_START                                                     \
+    "rdtscp;" /* waits for all previous instructions */                        \
+    "lfence;" /* later instructions start after the timestamp */               \
+    "mov %%eax, %%r8d;"
+
+#define TIMER_RDTSCP_STOP                                                      \
+    "rdtscp;" /* waits until the access has finished */                        \
+    "lfence;"                                                                  \
+    "sub %%r8d, %%eax;"
+
+#define TIMER_RDTSCP_SERIALIZE ""
+
+#define TIMER_RDTSC_START                                                      \
+    "lfence;"                                                                  \
+    "rdtsc;"                                                                   \
+    "lfence;"                                                                  \
+    "mov %%eax, %%r8d;"
+
+#define TIMER_RDTSC_STOP                                                       \
+    "lfence;" /* waits until the access has finished */                        \
+    "rdtsc;"                                                                   \
+    "sub %%r8d, %%eax;"
+
+#define TIMER_RDTSC_SERIALIZE "lfence;"
+
+/**
+ * @brief Subtracts the overhead operand from eax and saturates at zero.
+ */
+#define TIMER_SUBTRACT_OVERHEAD                                                \
+    "sub %k[overhead], %%eax;"                                                 \
+    "jae 1f;"                                                                  \
+    "xor %%eax, %%eax;"                                                        \
+    "1:;"
+
+/**
+ * @brief Amount of samples which are taken to calibrate a timer.
+ */
+#define TIMER_CALIBRATION_SAMPLES 100000
+
+/**
+ * @brief available timer backends.
+ */
+typedef enum timer_type {
+    TIMER_RDPMC,  /**< cpuid + mfence + rdpmc on the fixed cycle counter. */
+    TIMER_RDTSCP, /**< rdtscp + lfence. */
+    TIMER_RDTSC,  /**< lfence + rdtsc + lfence. */
+    TIMER_COUNT   /**< Amount of timer backends. */
+} timer_type_t;
+
+/**
+ * @brief A calibrated timer backend.
+ */
+typedef struct cycle_timer_s {
+    timer_type_t type; /**< The used backend. */
+    uint32_t overhead; /**< Median of an empty measurement in cycles. This
+                          value is subtracted from every measurement. */
+    double jitter;     /**< Standard deviation of an empty measurement. */
+} cycle_timer_t;
+
+/**
+ * @brief Parses the name of a timer backend.
+ *
+ * @param name one of "rdpmc", "rdtscp" or "rdtsc"
+ * @param type writes the parsed backend into
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_NONE
+ */
+error_t timer_type_from(const char *name, timer_type_t *type);
+
+/**
+ * @brief Returns the name of a timer backend.
+ *
+ * @param type the timer backend
+ */
+const char *timer_name(timer_type_t type);
+
+/**
+ * @brief Measures an empty region with the timer backend.
+ *
+ * @param type the timer backend
+ * @param samples amount of measurements
+ * @param result buffer for @p samples measurements
+ *
+ * If the backend is TIMER_RDPMC the cycle counter has to be enabled.
+ */
+void timer_measure_empty(timer_type_t type, uint64_t samples,
+                         uint32_t *result);
+
+/**
+ * @brief Measures a single memory access with the timer backend.
+ *
+ * @param type the timer backend
+ * @param overhead cycles which are subtracted from every measurement
+ * @param addr the address which is loaded
+ * @param flush if not zero, the cache line is flushed before every access
+ * @param samples amount of measurements
+ * @param result buffer for @p samples measurements
+ *
+ * If the backend is TIMER_RDPMC the cycle counter has to be enabled.
+ */
+void timer_measure_load(timer_type_t type, uint32_t overhead,
+                        const void *addr, int flush, uint64_t samples,
+                        uint32_t *result);
+
+/**
+ * @brief Measures the fixed overhead of a timer backend.
+ *
+ * @param timer writes the calibrated timer into
+ * @param type the timer backend
+ * @param samples amount of measurements
+ *
+ * Measures an empty region @p samples times and stores the median as the
+ * overhead and the standard deviation as the jitter of the timer. The
+ * measurements are kept in a histogram (see stats.h), so the memory does not
+ * grow with @p samples.
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+error_t timer_calibrate(cycle_timer_t *timer, timer_type_t type,
+                        uint64_t samples);
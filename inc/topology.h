@@ -0,0 +1,181 @@
+/**
+ * @file topology.h
+ * @date 16 Oct 2026
+ *
+ * @brief Contains a snapshot of the cache topology of all CPU cores.
+ *
+ * The topology is read once, either from the sysfs file system or, if
+ * /sys/devices/system/cpu/cpuN/cache does not exist, from the CPUID leaf 4
+ * of every CPU core. Every cache which is shared by several CPU cores is
+ * only stored once, all other modules look up the geometry of a cache in
+ * this table instead of reading the sysfs again.
+ */
+
+#pragma once
+
+#include "error.h"
+#include "sys_info.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief available sources of the topology.
+ */
+typedef enum topology_source {
+    TOPOLOGY_SYSFS, /**< Read from /sys/devices/system/cpu. */
+    TOPOLOGY_CPUID  /**< Read with the CPUID leaves 4 and 0xB. */
+} topology_source_t;
+
+/**
+ * @brief One cache of the system.
+ *
+ * cache_instance_t#info has the geometry of the cache, its
+ * cache_info_t#cpu_id is the first CPU core which uses the cache.
+ */
+typedef struct cache_instance_s {
+    cache_info_t info;  /**< Geometry of the cache. */
+    uint32_t *cpus;     /**< The CPU cores which share the cache. */
+    uint32_t cpu_count; /**< Amount of CPU cores which share the cache. */
+} cache_instance_t;
+
+/**
+ * @brief available placements of the workload relative to the profiled CPU
+ * cores.
+ */
+typedef enum topology_placement {
+    PLACEMENT_SAME_CORE,   /**< The workload shares the profiled CPU cores. */
+    PLACEMENT_SMT_SIBLING, /**< The workload runs on the hyper threads of the
+                              profiled CPU cores. */
+    PLACEMENT_SHARED_L2,   /**< The workload runs on other CPU cores which
+                              share the L2 cache. */
+    PLACEMENT_SHARED_L3    /**< The workload runs on other CPU cores which
+                              share the L3 cache. */
+} topology_placement_t;
+
+/**
+ * @brief The caches and hyper threads of one CPU core.
+ */
+typedef struct cpu_node_s {
+    uint32_t cpu;           /**< Id of the CPU core. */
+    uint32_t *siblings;     /**< Hyper threads of the physical core,
+                               including the CPU core itself. */
+    uint32_t sibling_count; /**< Amount of hyper threads. */
+    uint32_t *caches;       /**< Indexes of the caches in
+                               topology_t#caches, ordered by the cache index. */
+    uint32_t cache_count;   /**< Amount of caches. */
+} cpu_node_t;
+
+/**
+ * @brief The caches of all online CPU cores.
+ */
+typedef struct topology_s {
+    topology_source_t source; /**< Where the topology was read from. */
+    cpu_node_t *cpus;         /**< The online CPU cores, ascending. */
+    uint32_t cpu_count;       /**< Amount of CPU cores. */
+    cache_instance_t *caches; /**< Every cache, without duplicates. */
+    uint32_t cache_count;     /**< Amount of caches. */
+} topology_t;
+
+/**
+ * @brief Reads the cache topology of all online CPU cores.
+ *
+ * @param topology the topology which gets initialized
+ *
+ * The CPUID fallback binds the current thread to every CPU core and
+ * restores its CPU affinity afterwards.
+ *
+ * @retval ERROR_IO_SYS_CPU
+ * @retval ERROR_FMT
+ * @retval ERROR_TOPOLOGY
+ * @retval ERROR_GET_CPU_CORE
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+error_t topology_new(topology_t *topology);
+
+/**
+ * @brief Looks up the data or unified cache of a level on a CPU core.
+ *
+ * @param topology the topology
+ * @param cpu id of the CPU core
+ * @param level level of the cache
+ * @param info writes the geometry of the cache into, with
+ * cache_info_t#cpu_id set to @p cpu
+ *
+ * @retval ERROR_CACHE_NOT_EXISTS
+ * @retval ERROR_NONE
+ */
+error_t topology_cache(const topology_t *topology, uint32_t cpu,
+                       uint32_t level, cache_info_t *info);
+
+/**
+ * @brief Returns the amount of slices of a shared cache.
+ *
+ * @param topology the topology
+ * @param info a cache returned by topology_cache
+ * @param slices writes the amount of slices into
+ *
+ * Same as get_slice_count: one slice per physical core which shares the
+ * cache.
+ *
+ * @retval ERROR_CACHE_NOT_EXISTS
+ * @retval ERROR_NONE
+ */
+error_t topology_slice_count(const topology_t *topology,
+                             const cache_info_t *info, uint32_t *slices);
+
+/**
+ * @brief Chooses the CPU cores of the workload for a placement.
+ *
+ * @param topology the topology
+ * @param placement the placement policy
+ * @param cpus the profiled CPU cores
+ * @param count amount of profiled CPU cores
+ * @param workload writes a pointer to the allocated CPU cores of the workload
+ * into, which has to be freed
+ * @param workload_count writes the amount of CPU cores into
+ *
+ * Except for PLACEMENT_SAME_CORE the profiled CPU cores are never part of the
+ * workload, so the workload runs concurrently to the profiler instead of
+ * being time shared with it. With the shared cache placements, CPU cores on
+ * another physical core are preferred over the hyper threads of a profiled
+ * CPU core. Every profiled CPU core needs at least one CPU core of the
+ * workload.
+ *
+ * @retval ERROR_PLACEMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+error_t topology_place(const topology_t *topology,
+                       topology_placement_t placement, const uint32_t *cpus,
+                       uint32_t count, uint32_t **workload,
+                       uint32_t *workload_count);
+
+/**
+ * @brief Parses the name of a placement.
+ *
+ * @param name one of "same-core", "smt-sibling", "shared-l2" or "shared-l3"
+ * @param placement writes the parsed placement into
+ *
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_NONE
+ */
+error_t topology_placement_from(const char *name,
+                                topology_placement_t *placement);
+
+/**
+ * @brief Prints a topology as JSON.
+ *
+ * @param topology the topology
+ * @param file the output stream
+ */
+void topology_print_json(const topology_t *topology, FILE *file);
+
+/**
+ * @brief Frees the memory of a topology.
+ *
+ * @param topology the topology which gets freed
+ */
+void topology_free(topology_t *topology);
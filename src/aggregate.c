@@ -0,0 +1,68 @@
+/**
+ * @file aggregate.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the accumulators which summarize windows of frames.
+ */
+
+#include "aggregate.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+error_t aggregate_new(aggregate_t *aggregate, uintptr_t length,
+                      uint32_t window) {
+    if (!length || !window) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(aggregate, 0, sizeof(aggregate_t));
+    aggregate->length = length;
+    aggregate->window = window;
+    aggregate->sum = calloc(length, sizeof(uint64_t));
+    aggregate->max = calloc(length, sizeof(uint32_t));
+    aggregate->misses = calloc(length, sizeof(uint32_t));
+    if (aggregate->sum == NULL || aggregate->max == NULL ||
+        aggregate->misses == NULL) {
+        aggregate_free(aggregate);
+        return ERROR_ALLOCATION;
+    }
+
+    return ERROR_NONE;
+}
+
+int aggregate_add(aggregate_t *aggregate, const uint32_t *frame,
+                  uint64_t clock, uint32_t threshold) {
+    if (!aggregate->frames) {
+        aggregate->clock = clock;
+    }
+
+    // branch free, so the loop is vectorized
+    uint64_t *sum = aggregate->sum;
+    uint32_t *max = aggregate->max;
+    uint32_t *misses = aggregate->misses;
+    for (uintptr_t i = 0; i < aggregate->length; i++) {
+        uint32_t value = frame[i];
+        sum[i] += value;
+        max[i] = value > max[i] ? value : max[i];
+        misses[i] += value > threshold;
+    }
+
+    return ++aggregate->frames >= aggregate->window;
+}
+
+void aggregate_reset(aggregate_t *aggregate) {
+    memset(aggregate->sum, 0, sizeof(uint64_t) * aggregate->length);
+    memset(aggregate->max, 0, sizeof(uint32_t) * aggregate->length);
+    memset(aggregate->misses, 0, sizeof(uint32_t) * aggregate->length);
+    aggregate->frames = 0;
+}
+
+void aggregate_free(aggregate_t *aggregate) {
+    free(aggregate->sum);
+    free(aggregate->max);
+    free(aggregate->misses);
+    aggregate->sum = NULL;
+    aggregate->max = NULL;
+    aggregate->misses = NULL;
+}
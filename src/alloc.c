@@ -7,43 +7,104 @@
  */
 
 #include "alloc.h"
+#include "llc.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
+#include <unistd.h>
+
+error_t alloc_mode_from(const char *name, alloc_mode_t *mode) {
+    if (!strcmp(name, "auto")) {
+        *mode = ALLOC_AUTO;
+    } else if (!strcmp(name, "hugepage")) {
+        *mode = ALLOC_HUGEPAGE;
+    } else if (!strcmp(name, "color")) {
+        *mode = ALLOC_COLOR;
+    } else if (!strcmp(name, "arena")) {
+        *mode = ALLOC_ARENA;
+    } else if (!strcmp(name, "evset")) {
+        *mode = ALLOC_EVSET;
+    } else {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    return ERROR_NONE;
+}
+
+error_t alloc_mode_resolve(alloc_mode_t mode, alloc_mode_t *resolved) {
+    *resolved = mode;
+
+    if (mode != ALLOC_AUTO) {
+        return ERROR_NONE;
+    }
+
+    uint32_t hugepages;
+    FORWARD_ON_FAIL(get_hugepagenr(&hugepages));
+    if (hugepages > 0) {
+        *resolved = ALLOC_HUGEPAGE;
+        return ERROR_NONE;
+    }
+
+    // without CAP_SYS_ADMIN the pagemap shows zero page frame numbers
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size < 1) {
+        return ERROR_SYSCONF;
+    }
+
+    void *page = mmap(NULL, page_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (page == MAP_FAILED) {
+        return ERROR_MMAP;
+    }
+
+    uintptr_t physical = 0;
+    error_t err = get_physical_address(page, &physical);
+    munmap(page, page_size);
+
+    *resolved = err == ERROR_NONE && physical >= (uintptr_t)page_size
+                    ? ALLOC_COLOR
+                    : ALLOC_EVSET;
+    return ERROR_NONE;
+}
 
 /**
  * @brief tests if a buffer is aligned to the cache
- * @param cache points to information about the cache which the buffer
- * corresponds to
  * @param buffer pointer to the buffer that will be tested
+ * @param info points to information about the cache which the buffer
+ * corresponds to
+ * @param page_size size of the (huge)pages of the buffer
+ * @param pagemap the open pagemap
+ * @param physical space for the physical address of every small page of the
+ * buffer
  *
  * @retval ERROR_NOT_ALIGEND
  * @retval ERROR_IO_PROC_SELF_PAGEMAP
- * @retval ERROR_SYSCONF
+ * @retval ERROR_PAGE_ENTRY
  * @retval ERROR_NONE
  *
  * Tests if the buffer is aligned to the cache, by testing if every part of the
  * buffer corresponds to the correct cache line. This is archived by looking up
- * the physical address of every first virtual address of a (huge)page and
- * calculating to which cache line it belongs.
+ * the physical address of every small page of the buffer with a single read
+ * of the pagemap and calculating to which cache line it belongs.
  */
-error_t test_alignment(const void *buffer, const cache_info_t *info,
-                       uint64_t page_size) {
-    for (uint64_t current_line = 0;
-         current_line < info->total_size / info->line_size;
-         current_line += page_size / info->line_size) {
-        void *ptr =
-            (void *)(((uintptr_t)buffer) + current_line * info->line_size);
+static error_t test_alignment(const void *buffer, const cache_info_t *info,
+                              uint64_t page_size, const pagemap_t *pagemap,
+                              uintptr_t *physical) {
+    // ensures that every (huge)page is in memory
+    for (uint64_t offset = 0; offset < info->total_size; offset += page_size) {
+        *(volatile int *)((uintptr_t)buffer + offset) = 0;
+    }
 
-        // ensures that ptr is in memory
-        *((int *)ptr) = 0;
+    uintptr_t count =
+        (info->total_size + pagemap->page_size - 1) / pagemap->page_size;
+    FORWARD_ON_FAIL(pagemap_translate(pagemap, buffer, count, physical));
 
-        uintptr_t physical_address = 0;
-        FORWARD_ON_FAIL(get_physical_address(ptr, &physical_address));
+    for (uintptr_t i = 0; i < count; i++) {
+        uint64_t current_line = i * pagemap->page_size / info->line_size;
 
-        // id of the cache line the pointer points to
-        uintptr_t line_id =
-            (physical_address % (info->total_size)) / info->line_size;
+        // id of the cache line the page starts with
+        uintptr_t line_id = (physical[i] % (info->total_size)) / info->line_size;
 
         if (current_line != line_id) {
             return ERROR_NOT_ALIGNED;
@@ -63,13 +124,25 @@ error_t alloc_aligned(void **buffer, const cache_info_t *cache) {
     uint64_t hugepagesize = 0;
     FORWARD_ON_FAIL(get_hugepagesize(&hugepagesize));
 
+    pagemap_t pagemap;
+    error_t err = pagemap_open(&pagemap);
+    if (err != ERROR_NONE) {
+        pagemap_close(&pagemap);
+        return err;
+    }
+
     void **old_buffers = malloc(sizeof(void *) * max_tries);
-    if (old_buffers == NULL) {
+    uintptr_t *physical = malloc(
+        sizeof(uintptr_t) *
+        ((cache->total_size + pagemap.page_size - 1) / pagemap.page_size));
+    if (old_buffers == NULL || physical == NULL) {
+        free(old_buffers);
+        free(physical);
+        pagemap_close(&pagemap);
         return ERROR_ALLOCATION;
     }
 
     uint64_t tries = 0;
-    error_t err = ERROR_NONE;
     for (; tries < max_tries; tries++) {
         *buffer = mmap(NULL, cache->total_size, PROT_READ | PROT_WRITE,
                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
@@ -79,14 +152,17 @@ error_t alloc_aligned(void **buffer, const cache_info_t *cache) {
             break;
         }
 
-        if ((err = test_alignment(*buffer, cache, hugepagesize)) ==
-            ERROR_NOT_ALIGNED) {
+        if ((err = test_alignment(*buffer, cache, hugepagesize, &pagemap,
+                                  physical)) == ERROR_NOT_ALIGNED) {
             old_buffers[tries] = *buffer;
         } else {
             break;
         }
     }
 
+    pagemap_close(&pagemap);
+    free(physical);
+
     for (int i = 0; i < tries; i++) {
         err = free_aligned(old_buffers[i], cache);
     }
@@ -119,3 +195,137 @@ error_t free_aligned(void *buffer, const cache_info_t *cache) {
     }
     return ERROR_NONE;
 }
+
+error_t alloc_huge(void **buffer, uint64_t size) {
+    uint32_t hugepage_count;
+    FORWARD_ON_FAIL(get_hugepagenr(&hugepage_count));
+    uint64_t hugepagesize;
+    FORWARD_ON_FAIL(get_hugepagesize(&hugepagesize));
+
+    uint64_t length = (size + hugepagesize - 1) / hugepagesize * hugepagesize;
+    if (length / hugepagesize > hugepage_count) {
+        return ERROR_NO_HUGEPAGES;
+    }
+
+    *buffer = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE,
+                   -1, 0);
+    if (*buffer == MAP_FAILED) {
+        *buffer = NULL;
+        return ERROR_MMAP;
+    }
+    return ERROR_NONE;
+}
+
+error_t free_huge(void *buffer, uint64_t size) {
+    uint64_t hugepagesize;
+    FORWARD_ON_FAIL(get_hugepagesize(&hugepagesize));
+
+    uint64_t length = (size + hugepagesize - 1) / hugepagesize * hugepagesize;
+    if (munmap(buffer, length) == -1) {
+        return ERROR_MUNMAP;
+    }
+    return ERROR_NONE;
+}
+
+error_t color_pool_new(color_pool_t *pool, const cache_info_t *cache,
+                       uint32_t slice_count, const uint32_t *sets,
+                       uint32_t set_count) {
+    llc_slots_t slots;
+    FORWARD_ON_FAIL(
+        llc_slots_new(&slots, cache, slice_count, sets, set_count));
+
+    pagemap_t pagemap;
+    error_t err = pagemap_open(&pagemap);
+    if (err != ERROR_NONE) {
+        pagemap_close(&pagemap);
+        llc_slots_free(&slots);
+        return err;
+    }
+
+    uint64_t page_size = pagemap.page_size;
+    memset(pool, 0, sizeof(color_pool_t));
+    pool->page_size = page_size;
+    pool->slice_count = slots.slice_count;
+    pool->sets_per_slice = slots.sets_per_slice;
+    pool->way_count = slots.way_count;
+    pool->set_count = slots.set_count;
+
+    // one chunk holds as many pages as the whole cache, so it contains every
+    // color about way_count times
+    uintptr_t chunk_pages = (cache->total_size + page_size - 1) / page_size;
+    uintptr_t max_pages = COLOR_POOL_FACTOR * chunk_pages;
+
+    pool->pages = malloc(sizeof(void *) * max_pages);
+    void **spare = malloc(sizeof(void *) * max_pages);
+    uintptr_t *physical = malloc(sizeof(uintptr_t) * chunk_pages);
+
+    uintptr_t spare_count = 0;
+    if (pool->pages == NULL || spare == NULL || physical == NULL) {
+        err = ERROR_ALLOCATION;
+        goto CLEANUP;
+    }
+
+    uintptr_t mapped = 0;
+    while (slots.missing && mapped < max_pages && err == ERROR_NONE) {
+        uint8_t *chunk = mmap(NULL, chunk_pages * page_size,
+                              PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (chunk == MAP_FAILED) {
+            err = ERROR_MMAP;
+            break;
+        }
+
+        // the whole chunk is translated with a single read
+        err = pagemap_translate(&pagemap, chunk, chunk_pages, physical);
+
+        for (uintptr_t i = 0; i < chunk_pages; i++) {
+            uint8_t *page = chunk + i * page_size;
+
+            if (slots.missing && err == ERROR_NONE &&
+                llc_slots_take(&slots, (uintptr_t)page, physical[i],
+                               page_size)) {
+                pool->pages[pool->page_count++] = page;
+            } else {
+                spare[spare_count++] = page;
+            }
+        }
+        mapped += chunk_pages;
+    }
+
+    if (slots.missing && err == ERROR_NONE) {
+        err = ERROR_EVICTION_SETS;
+    }
+
+    pool->lines = slots.lines;
+    slots.lines = NULL;
+
+CLEANUP:
+    // the spare pages are only released now, so the kernel could not hand
+    // them out again during the search
+    for (uintptr_t i = 0; i < spare_count; i++) {
+        munmap(spare[i], page_size);
+    }
+
+    pagemap_close(&pagemap);
+    llc_slots_free(&slots);
+    free(physical);
+    free(spare);
+    if (err != ERROR_NONE) {
+        color_pool_free(pool);
+    }
+
+    return err;
+}
+
+void color_pool_free(color_pool_t *pool) {
+    for (uintptr_t i = 0; pool->pages != NULL && i < pool->page_count; i++) {
+        munmap(pool->pages[i], pool->page_size);
+    }
+
+    free(pool->pages);
+    free(pool->lines);
+    pool->pages = NULL;
+    pool->lines = NULL;
+    pool->page_count = 0;
+}
@@ -0,0 +1,313 @@
+/**
+ * @file arena.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the hugepage arena of the probe buffers and the metadata.
+ */
+
+#define _GNU_SOURCE /* needed for MAP_HUGE_SHIFT */
+
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+/**
+ * @brief Rounds a value up to a multiple of an alignment.
+ */
+static uintptr_t align_up(uintptr_t value, uintptr_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Returns the physical address of an offset of the arena.
+ */
+static uintptr_t arena_physical(const arena_t *arena, uintptr_t offset) {
+    return arena->physical[offset / arena->page_size] +
+           offset % arena->page_size;
+}
+
+/**
+ * @brief Returns the size of the region of an arena.
+ */
+static uintptr_t arena_size(const arena_t *arena) {
+    return (uintptr_t)arena->page_count * arena->page_size;
+}
+
+/**
+ * @brief Finds the first discontinuity of the physical addresses of a range.
+ *
+ * @param arena the arena
+ * @param offset start of the range
+ * @param size size of the range
+ *
+ * @return Zero if the range is physically contiguous, otherwise the offset of
+ * the first hugepage which does not follow its predecessor.
+ */
+static uintptr_t arena_break(const arena_t *arena, uintptr_t offset,
+                             uintptr_t size) {
+    uintptr_t first = offset / arena->page_size;
+    uintptr_t last = (offset + size - 1) / arena->page_size;
+
+    for (uintptr_t page = first; page < last; page++) {
+        if (arena->physical[page + 1] !=
+            arena->physical[page] + arena->page_size) {
+            return (page + 1) * arena->page_size;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Moves the offset of an arena behind a new allocation.
+ *
+ * @param arena the arena
+ * @param offset start of the allocation
+ * @param size requested size of the allocation
+ *
+ * @return The allocation.
+ */
+static void *arena_take(arena_t *arena, uintptr_t offset, uintptr_t size) {
+    arena->stats.padding += offset - arena->offset;
+    arena->stats.allocated += size;
+    arena->stats.allocations++;
+
+    arena->offset = align_up(offset + size, ARENA_ALIGNMENT);
+    arena->stats.used = arena->offset;
+
+    return arena->base + offset;
+}
+
+error_t arena_new(arena_t *arena, uintptr_t size, uint64_t page_size) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE;
+    if (page_size == ARENA_PAGE_2MB) {
+        flags |= MAP_HUGE_2MB;
+    } else if (page_size == ARENA_PAGE_1GB) {
+        flags |= MAP_HUGE_1GB;
+    } else {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(arena, 0, sizeof(arena_t));
+    arena->page_size = page_size;
+    arena->page_count = (size + page_size - 1) / page_size;
+    if (!arena->page_count) {
+        arena->page_count = 1;
+    }
+
+    arena->base = mmap(NULL, arena_size(arena), PROT_READ | PROT_WRITE, flags,
+                       -1, 0);
+    if (arena->base == MAP_FAILED) {
+        arena->base = NULL;
+        return ERROR_MMAP;
+    }
+
+    arena->physical = malloc(sizeof(uintptr_t) * arena->page_count);
+    if (arena->physical == NULL) {
+        arena_free(arena);
+        return ERROR_ALLOCATION;
+    }
+
+    pagemap_t pagemap;
+    error_t err = pagemap_open(&pagemap);
+
+    // a hugepage is physically contiguous, so its first small page is enough
+    for (uint32_t i = 0; i < arena->page_count && err == ERROR_NONE; i++) {
+        err = pagemap_translate(&pagemap, arena->base + i * page_size, 1,
+                                arena->physical + i);
+    }
+
+    pagemap_close(&pagemap);
+    if (err != ERROR_NONE) {
+        arena_free(arena);
+        return err;
+    }
+
+    arena->stats.size = arena_size(arena);
+    return ERROR_NONE;
+}
+
+error_t arena_avoid(arena_t *arena, const cache_info_t *cache,
+                    const uint32_t *sets, uint32_t set_count) {
+    arena_avoid_t *avoid = NULL;
+    for (uint32_t i = 0; i < arena->avoid_count; i++) {
+        if (arena->avoid[i].line == cache->line_size &&
+            arena->avoid[i].sets == cache->set_count) {
+            avoid = arena->avoid + i;
+        }
+    }
+
+    if (avoid == NULL) {
+        arena_avoid_t *grown =
+            realloc(arena->avoid,
+                    sizeof(arena_avoid_t) * (arena->avoid_count + 1));
+        if (grown == NULL) {
+            return ERROR_ALLOCATION;
+        }
+        arena->avoid = grown;
+
+        avoid = grown + arena->avoid_count;
+        avoid->probed = calloc(cache->set_count, sizeof(uint8_t));
+        if (avoid->probed == NULL) {
+            return ERROR_ALLOCATION;
+        }
+        avoid->line = cache->line_size;
+        avoid->sets = cache->set_count;
+        arena->avoid_count++;
+    }
+
+    for (uint32_t i = 0; i < (sets != NULL ? set_count : cache->set_count);
+         i++) {
+        uint32_t set = sets != NULL ? sets[i] : i;
+        if (set < cache->set_count) {
+            avoid->probed[set] = 1;
+        }
+    }
+
+    return ERROR_NONE;
+}
+
+error_t arena_alloc_cache(arena_t *arena, const cache_info_t *cache,
+                          void **buffer) {
+    uintptr_t way_size = (uintptr_t)cache->set_count * cache->line_size;
+    uintptr_t offset = align_up(arena->offset, ARENA_ALIGNMENT);
+
+    while (offset + cache->total_size <= arena_size(arena)) {
+        uintptr_t miss = (way_size - arena_physical(arena, offset) % way_size) %
+                         way_size;
+        if (miss) {
+            // the next offset may be in the next hugepage with another color
+            offset += miss;
+            continue;
+        }
+
+        uintptr_t next = arena_break(arena, offset, cache->total_size);
+        if (!next) {
+            *buffer = arena_take(arena, offset, cache->total_size);
+            return ERROR_NONE;
+        }
+        offset = next;
+    }
+
+    return ERROR_ARENA;
+}
+
+/**
+ * @brief Returns the length of the longest run of sets which are not
+ * probed, including runs which wrap around.
+ */
+static uintptr_t arena_longest_gap(const arena_avoid_t *avoid) {
+    uintptr_t longest = 0;
+    uintptr_t run = 0;
+
+    for (uint64_t i = 0; i < 2 * (uint64_t)avoid->sets; i++) {
+        run = avoid->probed[i % avoid->sets] ? 0 : run + 1;
+        if (run > longest) {
+            longest = run;
+        }
+    }
+
+    return longest < avoid->sets ? longest : avoid->sets;
+}
+
+/**
+ * @brief Finds the first line of a range which belongs to a probed set.
+ *
+ * @param arena the arena
+ * @param offset start of the range
+ * @param size size of the range
+ *
+ * @return Zero if no line of the range is probed, otherwise the offset
+ * behind the first probed line.
+ */
+static uintptr_t arena_conflict(const arena_t *arena, uintptr_t offset,
+                                uintptr_t size) {
+    for (uint32_t i = 0; i < arena->avoid_count; i++) {
+        const arena_avoid_t *avoid = arena->avoid + i;
+
+        for (uintptr_t at = offset / avoid->line * avoid->line;
+             at < offset + size; at += avoid->line) {
+            uintptr_t set =
+                arena_physical(arena, at) / avoid->line % avoid->sets;
+            if (avoid->probed[set]) {
+                return at + avoid->line;
+            }
+        }
+    }
+
+    return 0;
+}
+
+error_t arena_alloc(arena_t *arena, uintptr_t size, void **buffer) {
+    uintptr_t start = align_up(arena->offset, ARENA_ALIGNMENT);
+    if (start + size > arena_size(arena)) {
+        return ERROR_ARENA;
+    }
+
+    if (!arena->avoid_count) {
+        *buffer = arena_take(arena, start, size);
+        return ERROR_NONE;
+    }
+
+    for (uint32_t i = 0; i < arena->avoid_count; i++) {
+        uint32_t line = arena->avoid[i].line;
+        if (align_up(size, line) / line > arena_longest_gap(arena->avoid + i)) {
+            arena->stats.conflicts++;
+            *buffer = arena_take(arena, start, size);
+            return ERROR_NONE;
+        }
+    }
+
+    uintptr_t offset = start;
+    while (offset + size <= arena_size(arena)) {
+        uintptr_t conflict = arena_conflict(arena, offset, size);
+        if (!conflict) {
+            *buffer = arena_take(arena, offset, size);
+            return ERROR_NONE;
+        }
+        offset = conflict;
+    }
+
+    arena->stats.conflicts++;
+    *buffer = arena_take(arena, start, size);
+    return ERROR_NONE;
+}
+
+double arena_fragmentation(const arena_t *arena) {
+    if (!arena->stats.used) {
+        return 0;
+    }
+    return (double)arena->stats.padding / arena->stats.used;
+}
+
+void arena_free(arena_t *arena) {
+    if (arena->base != NULL) {
+        munmap(arena->base, arena_size(arena));
+    }
+
+    for (uint32_t i = 0; arena->avoid != NULL && i < arena->avoid_count;
+         i++) {
+        free(arena->avoid[i].probed);
+    }
+
+    free(arena->physical);
+    free(arena->avoid);
+    arena->base = NULL;
+    arena->physical = NULL;
+    arena->avoid = NULL;
+    arena->avoid_count = 0;
+}
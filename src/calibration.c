@@ -0,0 +1,269 @@
+/**
+ * @file calibration.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the calibrated access times of every cache level and the
+ * file in which they are kept between runs.
+ */
+
+#include "calibration.h"
+
+#include <cpuid.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Maximal length of a line of the calibration file.
+ */
+#define CALIBRATION_LINE 256
+
+void calibration_model(char model[CALIBRATION_MODEL_SIZE]) {
+    uint32_t brand[12] = {0};
+
+    if (__get_cpuid_max(0x80000000, NULL) >= 0x80000004) {
+        for (uint32_t i = 0; i < 3; i++) {
+            __cpuid(0x80000002 + i, brand[4 * i], brand[4 * i + 1],
+                    brand[4 * i + 2], brand[4 * i + 3]);
+        }
+    }
+
+    const char *start = (const char *)brand;
+    while (*start == ' ' && start < (const char *)brand + sizeof(brand)) {
+        start++;
+    }
+
+    size_t length = (const char *)brand + sizeof(brand) - start;
+    memcpy(model, start, length);
+    model[length] = '\0';
+
+    // the model is a field of the file
+    for (char *c = model; *c; c++) {
+        if (*c == '\t' || *c == '\n') {
+            *c = ' ';
+        }
+    }
+    if (!*model) {
+        strcpy(model, "unknown");
+    }
+}
+
+uint32_t calibration_derive(calibration_t *calibration) {
+    uint32_t inseparable = 0;
+
+    for (uint32_t i = 0; i < calibration->level_count; i++) {
+        uint32_t hit = calibration->median[i];
+        uint32_t next = calibration->median[i + 1];
+
+        if (next <= hit && !inseparable) {
+            inseparable = i + 1;
+        }
+        calibration->threshold[i] = next > hit ? hit + (next - hit) / 2 : hit;
+    }
+
+    calibration->limit = CALIBRATION_LIMIT_FACTOR *
+                         calibration->median[calibration->level_count];
+    return inseparable;
+}
+
+/**
+ * @brief Parses a comma separated list of numbers.
+ *
+ * @param text the list
+ * @param values writes the numbers into
+ * @param count amount of numbers which are expected
+ *
+ * @return Zero if the list has exactly @p count numbers.
+ */
+static int calibration_parse_list(const char *text, uint32_t *values,
+                                  uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        char *end;
+        errno = 0;
+        unsigned long value = strtoul(text, &end, 10);
+        if (errno || end == text || value > UINT32_MAX ||
+            *end != (i + 1 < count ? ',' : '\0')) {
+            return -1;
+        }
+        values[i] = value;
+        text = end + 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Parses a line of the calibration file.
+ *
+ * @param line the line without the line break, which is changed
+ * @param calibration writes the calibration into
+ *
+ * @return Zero if the line is a valid calibration.
+ */
+static int calibration_parse(char *line, calibration_t *calibration) {
+    char *fields[6];
+    char *save = NULL;
+    for (uint32_t i = 0; i < 6; i++) {
+        fields[i] = strtok_r(i ? NULL : line, "\t", &save);
+        if (fields[i] == NULL) {
+            return -1;
+        }
+    }
+
+    memset(calibration, 0, sizeof(calibration_t));
+    snprintf(calibration->model, sizeof(calibration->model), "%s", fields[0]);
+
+    uint32_t values[1];
+    if (calibration_parse_list(fields[1], values, 1) ||
+        timer_type_from(fields[2], &calibration->timer)) {
+        return -1;
+    }
+    calibration->cpu = values[0];
+
+    // the amount of levels follows from the amount of medians
+    uint32_t medians = 1;
+    for (const char *c = fields[3]; *c; c++) {
+        medians += *c == ',';
+    }
+    if (medians < 2 || medians > CALIBRATION_MAX_LEVELS + 1) {
+        return -1;
+    }
+    calibration->level_count = medians - 1;
+
+    if (calibration_parse_list(fields[3], calibration->median, medians) ||
+        calibration_parse_list(fields[4], calibration->threshold,
+                               calibration->level_count) ||
+        calibration_parse_list(fields[5], &calibration->limit, 1)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Writes a calibration as a line of the calibration file.
+ */
+static int calibration_write(FILE *file, const calibration_t *calibration) {
+    int err = fprintf(file, "%s\t%u\t%s\t", calibration->model,
+                      calibration->cpu, timer_name(calibration->timer)) < 0;
+
+    for (uint32_t i = 0; i <= calibration->level_count; i++) {
+        err |= fprintf(file, i ? ",%u" : "%u", calibration->median[i]) < 0;
+    }
+    err |= fputc('\t', file) == EOF;
+    for (uint32_t i = 0; i < calibration->level_count; i++) {
+        err |= fprintf(file, i ? ",%u" : "%u", calibration->threshold[i]) < 0;
+    }
+    err |= fprintf(file, "\t%u\n", calibration->limit) < 0;
+
+    return err;
+}
+
+error_t calibration_load(const char *path, const char *model, uint32_t cpu,
+                         timer_type_t timer, calibration_t *calibration) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return ERROR_CALIBRATION;
+    }
+
+    char line[CALIBRATION_LINE];
+    error_t err = ERROR_CALIBRATION;
+    while (err != ERROR_NONE && fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+        if (line[0] == '#' || calibration_parse(line, calibration)) {
+            continue;
+        }
+
+        if (!strcmp(calibration->model, model) && calibration->cpu == cpu &&
+            calibration->timer == timer) {
+            err = ERROR_NONE;
+        }
+    }
+
+    fclose(file);
+    return err;
+}
+
+/**
+ * @brief Creates the directory of a file if it does not exist.
+ */
+static void calibration_directory(const char *path) {
+    char directory[PATH_MAX];
+    snprintf(directory, sizeof(directory), "%s", path);
+
+    char *slash = strrchr(directory, '/');
+    if (slash != NULL && slash != directory) {
+        *slash = '\0';
+        mkdir(directory, 0755);
+    }
+}
+
+error_t calibration_store(const char *path, const calibration_t *calibrations,
+                          uint32_t count) {
+    calibration_directory(path);
+
+    char temporary[PATH_MAX];
+    if (snprintf(temporary, sizeof(temporary), "%s.tmp", path) >=
+        (int)sizeof(temporary)) {
+        return ERROR_CALIBRATION;
+    }
+
+    FILE *out = fopen(temporary, "w");
+    if (out == NULL) {
+        return ERROR_CALIBRATION;
+    }
+
+    int err = fprintf(out, "# model\tcpu\ttimer\tmedians (L1,...,DRAM)\t"
+                           "thresholds\tlimit\n") < 0;
+
+    // keep the lines of other models, cores and timers
+    FILE *in = fopen(path, "r");
+    if (in != NULL) {
+        char line[CALIBRATION_LINE];
+        char copy[CALIBRATION_LINE];
+        while (fgets(line, sizeof(line), in) != NULL) {
+            calibration_t old;
+            memcpy(copy, line, sizeof(line));
+            copy[strcspn(copy, "\n")] = '\0';
+            if (line[0] == '#' || calibration_parse(copy, &old)) {
+                continue;
+            }
+
+            int replaced = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                replaced |= !strcmp(old.model, calibrations[i].model) &&
+                            old.cpu == calibrations[i].cpu &&
+                            old.timer == calibrations[i].timer;
+            }
+            if (!replaced) {
+                err |= calibration_write(out, &old);
+            }
+        }
+        fclose(in);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        err |= calibration_write(out, calibrations + i);
+    }
+
+    err |= fclose(out) == EOF;
+    if (err || rename(temporary, path)) {
+        remove(temporary);
+        return ERROR_CALIBRATION;
+    }
+
+    return ERROR_NONE;
+}
+
+void calibration_print(const calibration_t *calibration, FILE *file) {
+    fprintf(file, "CPU %u (%s timer):\n", calibration->cpu,
+            timer_name(calibration->timer));
+    for (uint32_t i = 0; i < calibration->level_count; i++) {
+        fprintf(file, "  L%u hit: %u cycles, hit up to %u cycles\n", i + 1,
+                calibration->median[i], calibration->threshold[i]);
+    }
+    fprintf(file, "  DRAM: %u cycles, outliers above %u cycles\n",
+            calibration->median[calibration->level_count],
+            calibration->limit);
+}
@@ -0,0 +1,132 @@
+/**
+ * @file classify.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the classification of measured access times into hits and
+ * misses.
+ */
+
+#include "classify.h"
+
+#include <x86intrin.h>
+
+/**
+ * @brief Flips the sign bit, so a signed compare orders unsigned values.
+ */
+#define CLASSIFY_BIAS 0x80000000u
+
+/**
+ * @brief Packs the values which are not a multiple of eight.
+ */
+static void classify_pack_tail(const uint32_t *values, uintptr_t first,
+                               uintptr_t length, uint32_t threshold,
+                               uint8_t *bitmap) {
+    if (first == length) {
+        return;
+    }
+
+    uint8_t byte = 0;
+    for (uintptr_t i = first; i < length; i++) {
+        byte |= (values[i] > threshold) << (i % 8);
+    }
+    bitmap[first / 8] = byte;
+}
+
+/**
+ * @brief Packs a frame with two 4 lane compares per byte.
+ */
+static void classify_pack_sse2(const uint32_t *values, uintptr_t length,
+                               uint32_t threshold, uint8_t *bitmap) {
+    const __m128i bias = _mm_set1_epi32(CLASSIFY_BIAS);
+    const __m128i limit = _mm_set1_epi32(threshold ^ CLASSIFY_BIAS);
+
+    uintptr_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i low = _mm_loadu_si128((const __m128i *)(values + i));
+        __m128i high = _mm_loadu_si128((const __m128i *)(values + i + 4));
+        low = _mm_cmpgt_epi32(_mm_xor_si128(low, bias), limit);
+        high = _mm_cmpgt_epi32(_mm_xor_si128(high, bias), limit);
+
+        bitmap[i / 8] = _mm_movemask_ps(_mm_castsi128_ps(low)) |
+                        _mm_movemask_ps(_mm_castsi128_ps(high)) << 4;
+    }
+
+    classify_pack_tail(values, i, length, threshold, bitmap);
+}
+
+/**
+ * @brief Packs a frame with one 8 lane compare per byte.
+ */
+__attribute__((target("avx2"))) static void
+classify_pack_avx2(const uint32_t *values, uintptr_t length,
+                   uint32_t threshold, uint8_t *bitmap) {
+    const __m256i bias = _mm256_set1_epi32(CLASSIFY_BIAS);
+    const __m256i limit = _mm256_set1_epi32(threshold ^ CLASSIFY_BIAS);
+
+    uintptr_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i value = _mm256_loadu_si256((const __m256i *)(values + i));
+        value = _mm256_cmpgt_epi32(_mm256_xor_si256(value, bias), limit);
+
+        bitmap[i / 8] = _mm256_movemask_ps(_mm256_castsi256_ps(value));
+    }
+
+    classify_pack_tail(values, i, length, threshold, bitmap);
+}
+
+void classify_pack(const uint32_t *values, uintptr_t length,
+                   uint32_t threshold, uint8_t *bitmap) {
+    if (__builtin_cpu_supports("avx2")) {
+        classify_pack_avx2(values, length, threshold, bitmap);
+    } else {
+        classify_pack_sse2(values, length, threshold, bitmap);
+    }
+}
+
+void classify_clamp(uint32_t *values, uintptr_t length, uint32_t limit) {
+    for (uintptr_t i = 0; i < length; i++) {
+        values[i] = values[i] > limit ? limit : values[i];
+    }
+}
+
+void classify_histogram_add(uint64_t *histogram, const uint32_t *values,
+                            uintptr_t length) {
+    for (uintptr_t i = 0; i < length; i++) {
+        uint32_t value = values[i];
+        histogram[value < CLASSIFY_HISTOGRAM_SIZE
+                      ? value
+                      : CLASSIFY_HISTOGRAM_SIZE - 1]++;
+    }
+}
+
+uint32_t classify_threshold(const uint64_t *histogram) {
+    uint64_t windows[CLASSIFY_HISTOGRAM_SIZE - CLASSIFY_WINDOW + 1];
+    uint32_t window_count = CLASSIFY_HISTOGRAM_SIZE - CLASSIFY_WINDOW + 1;
+
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < CLASSIFY_HISTOGRAM_SIZE; i++) {
+        sum += histogram[i];
+        if (i >= CLASSIFY_WINDOW) {
+            sum -= histogram[i - CLASSIFY_WINDOW];
+        }
+        if (i + 1 >= CLASSIFY_WINDOW) {
+            windows[i + 1 - CLASSIFY_WINDOW] = sum;
+        }
+    }
+
+    uint32_t peak = 0;
+    for (uint32_t i = 1; i < window_count; i++) {
+        if (windows[i] > windows[peak]) {
+            peak = i;
+        }
+    }
+
+    uint32_t end = peak;
+    while (end < window_count &&
+           windows[end] * CLASSIFY_VALLEY >= windows[peak]) {
+        end++;
+    }
+
+    // the last value of the window before the first window of the valley
+    return end + CLASSIFY_WINDOW - 2;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file counters.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the counters of the profiler's own threads.
+ */
+
+#include "counters.h"
+
+void probe_counters_init(probe_counters_t *counters) {
+    atomic_init(&counters->frames, 0);
+    atomic_init(&counters->interrupted, 0);
+}
+
+void writer_counters_init(writer_counters_t *counters) {
+    atomic_init(&counters->frames, 0);
+    atomic_init(&counters->batches, 0);
+    atomic_init(&counters->busy_ns, 0);
+    atomic_init(&counters->idle_ns, 0);
+}
+
+void probe_counters_print(probe_counters_t *counters, uint32_t cpu,
+                          uint64_t dropped, double seconds, FILE *file) {
+    uint64_t frames = counter_read(&counters->frames);
+    fprintf(file,
+            "  CPU %u: %lu frames (%.0lf frames/s), %lu dropped, %lu "
+            "probably interrupted\n",
+            cpu, frames, seconds > 0 ? frames / seconds : 0, dropped,
+            counter_read(&counters->interrupted));
+}
+
+void writer_counters_print(writer_counters_t *counters, double seconds,
+                           FILE *file) {
+    uint64_t frames = counter_read(&counters->frames);
+    uint64_t batches = counter_read(&counters->batches);
+    double busy = counter_read(&counters->busy_ns) / 1e9;
+    double idle = counter_read(&counters->idle_ns) / 1e9;
+    fprintf(file,
+            "  writer: %lu frames in %lu batches (%.1lf frames per batch), "
+            "busy %.3lf s (%.1lf%%), idle %.3lf s\n",
+            frames, batches, batches ? (double)frames / batches : 0, busy,
+            seconds > 0 ? 100 * busy / seconds : 0, idle);
+}
@@ -65,7 +65,28 @@ const error_unit_t error_map_table[] = {
                      "/sys/bus/event_source/devices/cpu/rdpmc "
                      "(ERROR_IO_RDPMC)"},
     {ERROR_RDPMC,
-     "the rdpmc instruction is not available in userspace (ERROR_RDPMC)"}};
+     "the rdpmc instruction is not available in userspace (ERROR_RDPMC)"},
+    {ERROR_FRAME_SHAPE,
+     "the frame dimensions changed during the output (ERROR_FRAME_SHAPE)"},
+    {ERROR_THREAD, "creating or joining a thread (ERROR_THREAD)"},
+    {ERROR_INVALID_ARGUMENT,
+     "an argument has an invalid value (ERROR_INVALID_ARGUMENT)"},
+    {ERROR_SLICES,
+     "the slice hash of the last level cache is unknown (ERROR_SLICES)"},
+    {ERROR_EVICTION_SETS,
+     "could not fill all eviction sets (ERROR_EVICTION_SETS)"},
+    {ERROR_TIMER_THRESHOLD,
+     "the timer can not separate hits and evictions (ERROR_TIMER_THRESHOLD)"},
+    {ERROR_IO_EVSET_CACHE,
+     "while accessing the eviction set cache (ERROR_IO_EVSET_CACHE)"},
+    {ERROR_ARENA, "no space left in the hugepage arena (ERROR_ARENA)"},
+    {ERROR_TOPOLOGY,
+     "while reading the cache topology from sysfs or cpuid (ERROR_TOPOLOGY)"},
+    {ERROR_PLACEMENT,
+     "no CPU core matches the placement of the workload (ERROR_PLACEMENT)"},
+    {ERROR_IO_CNV, "while accessing the .cnv file (ERROR_IO_CNV)"},
+    {ERROR_CALIBRATION,
+     "while accessing the calibration file (ERROR_CALIBRATION)"}};
 
 const char *default_error_message = "unknown error";
 
@@ -0,0 +1,801 @@
+/**
+ * @file evset.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the timing based discovery of eviction sets and their cache
+ * file.
+ */
+
+#include "evset.h"
+#include "llc.h"
+#include "sys_action.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Identifies an eviction set cache file.
+ */
+#define EVSET_CACHE_MAGIC "CNVEVSET"
+
+/**
+ * @brief Version of the layout of the cache file.
+ */
+#define EVSET_CACHE_VERSION 2
+
+/**
+ * @brief Length of the boot id including the terminating zero.
+ */
+#define EVSET_BOOT_ID_LENGTH 40
+
+/**
+ * @brief Amount of eviction tests of a stored set before it counts as moved.
+ */
+#define EVSET_VERIFY_ATTEMPTS 3
+
+/**
+ * @brief A reduced group has at most this many times `ways` lines.
+ *
+ * With adaptive replacement policies `ways` congruent lines do not always
+ * evict the target, so the reduction may end with a few more lines. They are
+ * all congruent, so the first `ways` lines form the eviction set and the
+ * whole group is kept to test the set again.
+ */
+#define EVSET_GROUP_FACTOR 2
+
+/**
+ * @brief Header of the cache file.
+ *
+ * The file contains the header in its first page, followed by the candidate
+ * pages and the table of the discovered sets. The magic is written last, so
+ * an interrupted discovery leaves an invalid file.
+ */
+typedef struct evset_cache_header_s {
+    char magic[8];                      /**< EVSET_CACHE_MAGIC */
+    uint32_t version;                   /**< EVSET_CACHE_VERSION */
+    char boot_id[EVSET_BOOT_ID_LENGTH]; /**< The boot of the discovery. */
+    uint32_t line_size;                 /**< Line size of the cache. */
+    uint32_t set_count;                 /**< Amount of sets of the cache. */
+    uint32_t way_count;                 /**< Amount of ways of the cache. */
+    uint32_t level;                     /**< Level of the cache. */
+    uint64_t pool_pages;                /**< Amount of candidate pages. */
+    uint64_t table_count;               /**< Amount of stored sets. */
+} evset_cache_header_t;
+
+/**
+ * @brief State of a discovery.
+ */
+typedef struct evset_ctx_s {
+    timer_type_t timer; /**< The timer backend. */
+    uint32_t overhead;  /**< Overhead of the timer backend. */
+    uint32_t threshold; /**< Cycles above which a line counts as evicted. */
+    uint64_t tests;     /**< Amount of eviction tests. */
+    uintptr_t *work;    /**< Candidates of the current reduction. */
+    uintptr_t *rest;    /**< Candidates without the tested group. */
+} evset_ctx_t;
+
+/**
+ * @brief Loads a cache line.
+ *
+ * @param addr address in the cache line
+ */
+static inline void evset_touch(uintptr_t addr) { *(volatile uint8_t *)addr; }
+
+/**
+ * @brief Measures the access time of a cache line.
+ *
+ * @param ctx the discovery
+ * @param addr address in the cache line
+ *
+ * A line in the other half of the page is loaded first, so the measurement
+ * does not contain a TLB miss, but the set of @p addr is not touched.
+ */
+static uint32_t evset_time(const evset_ctx_t *ctx, uintptr_t addr) {
+    evset_touch(addr ^ (EVSET_PAGE_SIZE / 2));
+
+    uint32_t time;
+    timer_measure_load(ctx->timer, ctx->overhead, (void *)addr, 0, 1, &time);
+    return time;
+}
+
+/**
+ * @brief Tests whether a group of cache lines evicts a target line.
+ *
+ * @param ctx the discovery
+ * @param set the group of cache lines
+ * @param count amount of cache lines in the group
+ * @param target the target line
+ *
+ * @return Not zero if the majority of EVSET_TEST_REPEATS measurements saw an
+ * eviction.
+ */
+static int evset_evicts(evset_ctx_t *ctx, const uintptr_t *set,
+                        uintptr_t count, uintptr_t target) {
+    int evicted = 0;
+    ctx->tests++;
+
+    for (int repeat = 0; repeat < EVSET_TEST_REPEATS; repeat++) {
+        evset_touch(target);
+
+        // a second pass evicts the target also with adaptive replacement
+        // policies
+        for (int pass = 0; pass < 2; pass++) {
+            for (uintptr_t i = 0; i < count; i++) {
+                evset_touch(set[i]);
+            }
+        }
+
+        evicted += evset_time(ctx, target) > ctx->threshold;
+    }
+
+    return evicted * 2 > EVSET_TEST_REPEATS;
+}
+
+/**
+ * @brief Compares two uint32_t for qsort.
+ */
+static int cmp_uint32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Calibrates the threshold between a cached and an evicted line.
+ *
+ * @param ctx the discovery, the threshold is written into
+ * @param cache the cache
+ *
+ * A line of the last level cache is evicted with clflush. For the other
+ * levels the lines at the same page offset of a pool sized buffer are
+ * touched twice, so the line is evicted into the next level exactly like by
+ * an eviction set. Walking the whole cache instead would also pollute the
+ * TLB and the next level and overestimate the latency.
+ *
+ * @retval ERROR_TIMER_THRESHOLD
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_MMAP
+ * @retval ERROR_NONE
+ */
+static error_t evset_calibrate(evset_ctx_t *ctx, const cache_info_t *cache) {
+    uintptr_t walk_size = 0;
+    if (cache->level < LLC_MIN_LEVEL) {
+        uintptr_t classes = EVSET_PAGE_SIZE / cache->line_size;
+        uintptr_t sets_per_class = (cache->set_count + classes - 1) / classes;
+        walk_size = EVSET_POOL_FACTOR * cache->ways_of_associativity *
+                    sets_per_class * EVSET_PAGE_SIZE;
+    }
+
+    uint8_t *buffer =
+        mmap(NULL, EVSET_PAGE_SIZE + walk_size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (buffer == MAP_FAILED) {
+        return ERROR_MMAP;
+    }
+
+    uint32_t *hit = malloc(sizeof(uint32_t) * EVSET_CALIBRATION_SAMPLES);
+    uint32_t *miss = malloc(sizeof(uint32_t) * EVSET_CALIBRATION_SAMPLES);
+    if (hit == NULL || miss == NULL) {
+        free(hit);
+        free(miss);
+        munmap(buffer, EVSET_PAGE_SIZE + walk_size);
+        return ERROR_ALLOCATION;
+    }
+
+    uintptr_t target = (uintptr_t)buffer;
+    for (int i = 0; i < EVSET_CALIBRATION_SAMPLES; i++) {
+        evset_touch(target);
+        hit[i] = evset_time(ctx, target);
+
+        evset_touch(target);
+        if (walk_size) {
+            for (int pass = 0; pass < 2; pass++) {
+                for (uintptr_t offset = 0; offset < walk_size;
+                     offset += EVSET_PAGE_SIZE) {
+                    evset_touch(target + EVSET_PAGE_SIZE + offset);
+                }
+            }
+        } else {
+            asm volatile("clflush (%[addr]); mfence;"
+                         : /* no output */
+                         : [addr] "r"(target)
+                         : "memory");
+        }
+        miss[i] = evset_time(ctx, target);
+    }
+
+    qsort(hit, EVSET_CALIBRATION_SAMPLES, sizeof(uint32_t), cmp_uint32);
+    qsort(miss, EVSET_CALIBRATION_SAMPLES, sizeof(uint32_t), cmp_uint32);
+
+    uint32_t hit_median = hit[EVSET_CALIBRATION_SAMPLES / 2];
+    uint32_t miss_median = miss[EVSET_CALIBRATION_SAMPLES / 2];
+
+    free(hit);
+    free(miss);
+    munmap(buffer, EVSET_PAGE_SIZE + walk_size);
+
+    if (miss_median <= hit_median + 1) {
+        return ERROR_TIMER_THRESHOLD;
+    }
+
+    ctx->threshold = (hit_median + miss_median) / 2;
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Returns the size of one table entry of the cache file.
+ *
+ * @param ways the associativity of the cache
+ *
+ * An entry holds the set id, the offset of the target, the size of the
+ * reduced group and the offsets of the lines of the group, all as uint64_t.
+ * The offsets are relative to the first candidate page.
+ */
+static uintptr_t evset_entry_size(uint32_t ways) {
+    return (3 + (uintptr_t)EVSET_GROUP_FACTOR * ways) * sizeof(uint64_t);
+}
+
+/**
+ * @brief Reduces a group of lines which evicts a target to `ways` lines.
+ *
+ * @param ctx the discovery
+ * @param set the group, gets reordered
+ * @param count amount of lines in the group
+ * @param target the target line
+ * @param ways the associativity of the cache
+ *
+ * Splits the group into `ways + 1` parts. At least one part can be removed
+ * without losing the eviction, because at most `ways` parts contain a line
+ * of the set of the target. If no part can be removed from a small group,
+ * single lines are removed instead (see EVSET_GROUP_FACTOR).
+ *
+ * @return The size of the reduced group or zero if the group could not be
+ * reduced.
+ */
+static uintptr_t evset_reduce(evset_ctx_t *ctx, uintptr_t *set,
+                              uintptr_t count, uintptr_t target,
+                              uint32_t ways) {
+    while (count > ways) {
+        uintptr_t groups = ways + 1;
+        int reduced = 0;
+
+        for (uintptr_t group = 0; group < groups && !reduced; group++) {
+            uintptr_t start = count * group / groups;
+            uintptr_t end = count * (group + 1) / groups;
+            if (start == end) {
+                continue;
+            }
+
+            memcpy(ctx->rest, set, start * sizeof(uintptr_t));
+            memcpy(ctx->rest + start, set + end,
+                   (count - end) * sizeof(uintptr_t));
+
+            if (evset_evicts(ctx, ctx->rest, count - (end - start), target)) {
+                count -= end - start;
+                memcpy(set, ctx->rest, count * sizeof(uintptr_t));
+                reduced = 1;
+            }
+        }
+
+        if (!reduced) {
+            break;
+        }
+    }
+
+    if (count > EVSET_GROUP_FACTOR * ways) {
+        return 0;
+    }
+
+    for (uintptr_t i = 0; i < count && count > ways;) {
+        memcpy(ctx->rest, set, i * sizeof(uintptr_t));
+        memcpy(ctx->rest + i, set + i + 1,
+               (count - i - 1) * sizeof(uintptr_t));
+
+        if (evset_evicts(ctx, ctx->rest, count - 1, target)) {
+            count--;
+            memcpy(set, ctx->rest, count * sizeof(uintptr_t));
+        } else {
+            i++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Discovers the eviction sets of one offset class.
+ *
+ * @param ctx the discovery
+ * @param candidates the lines of the class in all candidate pages, gets
+ * reordered
+ * @param count amount of candidates
+ * @param needed amount of sets which are discovered
+ * @param ways the associativity of the cache
+ * @param entries writes the target and the reduced group of every set into,
+ * in the layout of the table entries (see evset_entry_size) but with virtual
+ * addresses
+ *
+ * After a set is found, all candidates which are evicted by it are removed,
+ * so the next target belongs to a different set.
+ *
+ * @retval ERROR_EVICTION_SETS
+ * @retval ERROR_NONE
+ */
+static error_t evset_discover_class(evset_ctx_t *ctx, uintptr_t *candidates,
+                                    uintptr_t count, uint32_t needed,
+                                    uint32_t ways, uint64_t *entries) {
+    uintptr_t entry_length = evset_entry_size(ways) / sizeof(uint64_t);
+    uint32_t found = 0;
+    uint32_t attempts = 0;
+
+    while (found < needed) {
+        if (count <= ways || attempts++ > EVSET_MAX_ATTEMPTS * needed) {
+            return ERROR_EVICTION_SETS;
+        }
+
+        uintptr_t target = candidates[--count];
+
+        if (!evset_evicts(ctx, candidates, count, target)) {
+            // too few lines of the set of the target are left
+            continue;
+        }
+
+        memcpy(ctx->work, candidates, count * sizeof(uintptr_t));
+        uintptr_t group = evset_reduce(ctx, ctx->work, count, target, ways);
+        if (!group || !evset_evicts(ctx, ctx->work, group, target)) {
+            // noise, the target is tried again later
+            candidates[count++] = candidates[0];
+            candidates[0] = target;
+            continue;
+        }
+
+        uint64_t *entry = entries + found++ * entry_length;
+        entry[1] = target;
+        entry[2] = group;
+        memcpy(entry + 3, ctx->work, group * sizeof(uintptr_t));
+
+        uintptr_t kept = 0;
+        for (uintptr_t i = 0; i < count; i++) {
+            int member = 0;
+            for (uintptr_t line = 0; line < group; line++) {
+                member |= candidates[i] == ctx->work[line];
+            }
+
+            if (!member &&
+                !evset_evicts(ctx, ctx->work, group, candidates[i])) {
+                candidates[kept++] = candidates[i];
+            }
+        }
+        count = kept;
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Reads the boot id of the running kernel.
+ *
+ * @param boot_id writes the zero terminated boot id into
+ *
+ * @retval ERROR_IO_EVSET_CACHE
+ * @retval ERROR_NONE
+ */
+static error_t evset_boot_id(char boot_id[EVSET_BOOT_ID_LENGTH]) {
+    memset(boot_id, 0, EVSET_BOOT_ID_LENGTH);
+
+    FILE *file = fopen("/proc/sys/kernel/random/boot_id", "r");
+    if (file == NULL) {
+        return ERROR_IO_EVSET_CACHE;
+    }
+
+    char *ret = fgets(boot_id, EVSET_BOOT_ID_LENGTH, file);
+    fclose(file);
+
+    if (ret == NULL) {
+        return ERROR_IO_EVSET_CACHE;
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Maps the candidate pages.
+ *
+ * @param pool the pool
+ * @param cache_file path of the cache file or NULL
+ * @param table_count amount of table entries behind the pages
+ * @param ways the associativity of the cache
+ * @param fresh if not zero, an existing file is truncated
+ *
+ * @retval ERROR_IO_EVSET_CACHE
+ * @retval ERROR_MMAP
+ * @retval ERROR_NONE
+ */
+static error_t evset_map(evset_pool_t *pool, const char *cache_file,
+                         uintptr_t table_count, uint32_t ways, int fresh) {
+    uintptr_t pool_size = pool->pool_pages * EVSET_PAGE_SIZE;
+
+    if (cache_file == NULL) {
+        pool->map_offset = 0;
+        pool->map_size = pool_size;
+        pool->map = mmap(NULL, pool->map_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    } else {
+        int fd = open(cache_file, O_RDWR | O_CREAT | (fresh ? O_TRUNC : 0),
+                      0600);
+        if (fd == -1) {
+            return ERROR_IO_EVSET_CACHE;
+        }
+
+        pool->map_offset = EVSET_PAGE_SIZE;
+        pool->map_size = EVSET_PAGE_SIZE + pool_size +
+                         table_count * evset_entry_size(ways);
+
+        struct stat info;
+        if (fstat(fd, &info) ||
+            (fresh && ftruncate(fd, pool->map_size)) ||
+            (uintptr_t)info.st_size < (fresh ? 0 : pool->map_size)) {
+            close(fd);
+            return ERROR_IO_EVSET_CACHE;
+        }
+
+        pool->map = mmap(NULL, pool->map_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, 0);
+        close(fd);
+    }
+
+    if (pool->map == MAP_FAILED) {
+        pool->map = NULL;
+        return ERROR_MMAP;
+    }
+
+    pool->pool = pool->map + pool->map_offset;
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Loads the requested sets from the cache file.
+ *
+ * @param pool the pool with the size of the pool and the requested sets
+ * @param ctx the calibrated discovery
+ * @param cache the cache
+ * @param ids the requested set ids
+ * @param cache_file path of the cache file
+ *
+ * @return ERROR_NONE if all requested sets were loaded and still evict their
+ * targets, otherwise the pool is unmapped and an error is returned.
+ */
+static error_t evset_cache_load(evset_pool_t *pool, evset_ctx_t *ctx,
+                                const cache_info_t *cache,
+                                const uint32_t *ids,
+                                const char *cache_file) {
+    int fd = open(cache_file, O_RDONLY);
+    if (fd == -1) {
+        return ERROR_IO_EVSET_CACHE;
+    }
+
+    evset_cache_header_t header;
+    ssize_t size = pread(fd, &header, sizeof(header), 0);
+    close(fd);
+
+    char boot_id[EVSET_BOOT_ID_LENGTH];
+    FORWARD_ON_FAIL(evset_boot_id(boot_id));
+
+    if (size != sizeof(header) ||
+        memcmp(header.magic, EVSET_CACHE_MAGIC, sizeof(header.magic)) ||
+        header.version != EVSET_CACHE_VERSION ||
+        memcmp(header.boot_id, boot_id, EVSET_BOOT_ID_LENGTH) ||
+        header.line_size != cache->line_size ||
+        header.set_count != cache->set_count ||
+        header.way_count != cache->ways_of_associativity ||
+        header.level != cache->level ||
+        header.pool_pages != pool->pool_pages) {
+        return ERROR_IO_EVSET_CACHE;
+    }
+
+    FORWARD_ON_FAIL(evset_map(pool, cache_file, header.table_count,
+                              pool->way_count, 0));
+
+    const uint64_t *table = (const uint64_t *)(pool->pool +
+                                               pool->pool_pages *
+                                                   EVSET_PAGE_SIZE);
+    uintptr_t entry_length = evset_entry_size(pool->way_count) /
+                             sizeof(uint64_t);
+    uintptr_t pool_size = pool->pool_pages * EVSET_PAGE_SIZE;
+
+    for (uint32_t i = 0; i < pool->set_count; i++) {
+        const uint64_t *entry = NULL;
+        for (uint64_t j = 0; j < header.table_count && entry == NULL; j++) {
+            if (table[j * entry_length] == ids[i]) {
+                entry = table + j * entry_length;
+            }
+        }
+
+        int valid = entry != NULL && entry[1] < pool_size &&
+                    entry[2] >= pool->way_count &&
+                    entry[2] <= EVSET_GROUP_FACTOR * pool->way_count;
+        for (uint64_t line = 0; valid && line < entry[2]; line++) {
+            valid = entry[3 + line] < pool_size;
+            ctx->work[line] = (uintptr_t)pool->pool + entry[3 + line];
+        }
+
+        // the pages may have moved since the discovery, a single test may
+        // fail due to noise
+        int evicts = 0;
+        for (int attempt = 0;
+             valid && !evicts && attempt < EVSET_VERIFY_ATTEMPTS; attempt++) {
+            evicts = evset_evicts(ctx, ctx->work, entry[2],
+                                  (uintptr_t)pool->pool + entry[1]);
+        }
+
+        if (!evicts) {
+            munmap(pool->map, pool->map_size);
+            pool->map = NULL;
+            return ERROR_IO_EVSET_CACHE;
+        }
+
+        memcpy(pool->lines + (uintptr_t)i * pool->way_count, ctx->work,
+               pool->way_count * sizeof(uintptr_t));
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Writes the discovered sets into the cache file.
+ *
+ * @param pool the pool with the mapping of the cache file
+ * @param cache the cache
+ * @param ids the discovered set ids
+ * @param found the entries of the discovered sets with virtual addresses,
+ * indexed by the set id
+ *
+ * @retval ERROR_IO_EVSET_CACHE
+ * @retval ERROR_NONE
+ */
+static error_t evset_cache_store(evset_pool_t *pool,
+                                 const cache_info_t *cache,
+                                 const uint32_t *ids,
+                                 const uint64_t *found) {
+    uint64_t *table =
+        (uint64_t *)(pool->pool + pool->pool_pages * EVSET_PAGE_SIZE);
+    uintptr_t entry_length = evset_entry_size(pool->way_count) /
+                             sizeof(uint64_t);
+
+    for (uint32_t i = 0; i < pool->set_count; i++) {
+        uint64_t *entry = table + i * entry_length;
+        const uint64_t *source = found + (uintptr_t)ids[i] * entry_length;
+        entry[0] = ids[i];
+        entry[1] = source[1] - (uintptr_t)pool->pool;
+        entry[2] = source[2];
+        for (uint64_t line = 0; line < source[2]; line++) {
+            entry[3 + line] = source[3 + line] - (uintptr_t)pool->pool;
+        }
+    }
+
+    evset_cache_header_t header;
+    memset(&header, 0, sizeof(header));
+    FORWARD_ON_FAIL(evset_boot_id(header.boot_id));
+    header.version = EVSET_CACHE_VERSION;
+    header.line_size = cache->line_size;
+    header.set_count = cache->set_count;
+    header.way_count = cache->ways_of_associativity;
+    header.level = cache->level;
+    header.pool_pages = pool->pool_pages;
+    header.table_count = pool->set_count;
+
+    memcpy(pool->map, &header, sizeof(header));
+    // the magic marks the file as complete
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    memcpy(pool->map, EVSET_CACHE_MAGIC, sizeof(header.magic));
+
+    if (msync(pool->map, pool->map_size, MS_SYNC)) {
+        return ERROR_IO_EVSET_CACHE;
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Discovers all requested sets in the candidate pages.
+ *
+ * @param pool the pool with the mapped candidate pages
+ * @param ctx the calibrated discovery
+ * @param cache the cache
+ * @param ids the requested set ids
+ * @param classes amount of offset classes
+ * @param found writes the entry of every set into, indexed by the set id
+ * (see evset_discover_class)
+ *
+ * @retval ERROR_EVICTION_SETS
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t evset_discover(evset_pool_t *pool, evset_ctx_t *ctx,
+                              const cache_info_t *cache, const uint32_t *ids,
+                              uint32_t classes, uint64_t *found) {
+    uint32_t ways = pool->way_count;
+    uintptr_t entry_length = evset_entry_size(ways) / sizeof(uint64_t);
+    uint32_t sets_per_class = cache->set_count / classes;
+    uintptr_t *candidates = malloc(sizeof(uintptr_t) * pool->pool_pages);
+    uint64_t *class_entries =
+        malloc(sizeof(uint64_t) * sets_per_class * entry_length);
+    uint32_t *needed = calloc(classes, sizeof(uint32_t));
+
+    error_t err = ERROR_NONE;
+    if (candidates == NULL || class_entries == NULL || needed == NULL) {
+        err = ERROR_ALLOCATION;
+        goto CLEANUP;
+    }
+
+    for (uint32_t i = 0; i < pool->set_count; i++) {
+        uint32_t class = ids[i] % classes;
+        if (needed[class] < ids[i] / classes + 1) {
+            needed[class] = ids[i] / classes + 1;
+        }
+    }
+
+    for (uint32_t class = 0; class < classes && err == ERROR_NONE; class++) {
+        if (!needed[class]) {
+            continue;
+        }
+
+        for (uintptr_t page = 0; page < pool->pool_pages; page++) {
+            candidates[page] = (uintptr_t)pool->pool + page * EVSET_PAGE_SIZE +
+                               class * cache->line_size;
+        }
+
+        err = evset_discover_class(ctx, candidates, pool->pool_pages,
+                                   needed[class], ways, class_entries);
+
+        // the k-th set of the class gets the id k * classes + class
+        for (uint32_t k = 0; k < needed[class] && err == ERROR_NONE; k++) {
+            uint32_t id = k * classes + class;
+            memcpy(found + id * entry_length, class_entries + k * entry_length,
+                   entry_length * sizeof(uint64_t));
+            found[id * entry_length] = id;
+        }
+    }
+
+    for (uint32_t i = 0; i < pool->set_count && err == ERROR_NONE; i++) {
+        memcpy(pool->lines + (uintptr_t)i * ways,
+               found + ids[i] * entry_length + 3, ways * sizeof(uintptr_t));
+    }
+
+CLEANUP:
+    free(candidates);
+    free(class_entries);
+    free(needed);
+    return err;
+}
+
+error_t evset_pool_new(evset_pool_t *pool, const cache_info_t *cache,
+                       const uint32_t *sets, uint32_t set_count,
+                       timer_type_t timer, const char *cache_file) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    uint32_t classes = EVSET_PAGE_SIZE / cache->line_size;
+    if (classes > cache->set_count) {
+        classes = cache->set_count;
+    }
+    uint32_t sets_per_class = cache->set_count / classes;
+
+    if (sets == NULL) {
+        set_count = cache->set_count;
+    }
+
+    for (uint32_t i = 0; sets != NULL && i < set_count; i++) {
+        if (sets[i] >= cache->set_count) {
+            return ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    memset(pool, 0, sizeof(evset_pool_t));
+    pool->set_count = set_count;
+    pool->way_count = cache->ways_of_associativity;
+    pool->pool_pages =
+        (uintptr_t)EVSET_POOL_FACTOR * pool->way_count * sets_per_class;
+
+    evset_ctx_t ctx = {timer, 0, 0, 0, NULL, NULL};
+    uint32_t *ids = malloc(sizeof(uint32_t) * set_count);
+    uint64_t *found = malloc(evset_entry_size(pool->way_count) *
+                             cache->set_count);
+    pool->lines = malloc(sizeof(uintptr_t) * set_count * pool->way_count);
+    ctx.work = malloc(sizeof(uintptr_t) * pool->pool_pages);
+    ctx.rest = malloc(sizeof(uintptr_t) * pool->pool_pages);
+
+    uint32_t fd_cycle;
+    int counter = 0;
+    error_t err = ERROR_NONE;
+    if (ids == NULL || found == NULL || pool->lines == NULL ||
+        ctx.work == NULL || ctx.rest == NULL) {
+        err = ERROR_ALLOCATION;
+        goto CLEANUP;
+    }
+
+    for (uint32_t i = 0; i < set_count; i++) {
+        ids[i] = sets != NULL ? sets[i] : i;
+    }
+
+    if (timer == TIMER_RDPMC) {
+        if ((err = enable_cpu_cycle_counter(&fd_cycle, cache->cpu_id))) {
+            goto CLEANUP;
+        }
+        counter = 1;
+    }
+
+    cycle_timer_t calibrated;
+    if ((err = timer_calibrate(&calibrated, timer,
+                               TIMER_CALIBRATION_SAMPLES))) {
+        goto CLEANUP;
+    }
+    ctx.overhead = calibrated.overhead;
+
+    if ((err = evset_calibrate(&ctx, cache))) {
+        goto CLEANUP;
+    }
+
+    if (cache_file != NULL &&
+        evset_cache_load(pool, &ctx, cache, ids, cache_file) == ERROR_NONE) {
+        pool->stats.cached = 1;
+        goto CLEANUP;
+    }
+
+    if ((err = evset_map(pool, cache_file, set_count, pool->way_count, 1))) {
+        goto CLEANUP;
+    }
+
+    // backs every candidate page with its own physical page
+    for (uintptr_t page = 0; page < pool->pool_pages; page++) {
+        pool->pool[page * EVSET_PAGE_SIZE] = 1;
+    }
+
+    if ((err = evset_discover(pool, &ctx, cache, ids, classes, found))) {
+        goto CLEANUP;
+    }
+
+    if (cache_file != NULL) {
+        err = evset_cache_store(pool, cache, ids, found);
+    }
+
+CLEANUP:
+    if (counter) {
+        error_t disable_err = disable_cpu_cycle_counter(fd_cycle);
+        if (err == ERROR_NONE) {
+            err = disable_err;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pool->stats.tests = ctx.tests;
+    pool->stats.threshold = ctx.threshold;
+    pool->stats.duration_ns = (end.tv_sec - start.tv_sec) * 1000000000ULL +
+                              end.tv_nsec - start.tv_nsec;
+
+    free(ids);
+    free(found);
+    free(ctx.work);
+    free(ctx.rest);
+    if (err != ERROR_NONE) {
+        evset_pool_free(pool);
+    }
+
+    return err;
+}
+
+void evset_pool_free(evset_pool_t *pool) {
+    if (pool->map != NULL) {
+        munmap(pool->map, pool->map_size);
+    }
+
+    free(pool->lines);
+    pool->map = NULL;
+    pool->pool = NULL;
+    pool->lines = NULL;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file frame_timing.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the breakdown of the time of the measurement loop.
+ */
+
+#include "frame_timing.h"
+
+#include <string.h>
+
+void frame_timing_report_init(frame_timing_report_t *report) {
+    memset(report, 0, sizeof(frame_timing_report_t));
+    report->prime.min = UINT32_MAX;
+    report->yield.min = UINT32_MAX;
+    report->probe.min = UINT32_MAX;
+}
+
+/**
+ * @brief Adds the cycles of one frame to a part of the loop.
+ */
+static void phase_add(frame_timing_phase_t *phase, uint32_t cycles) {
+    phase->sum += cycles;
+    phase->min = cycles < phase->min ? cycles : phase->min;
+    phase->max = cycles > phase->max ? cycles : phase->max;
+}
+
+void frame_timing_report_add(frame_timing_report_t *report,
+                             const frame_timing_t *timing) {
+    if (!report->frames) {
+        report->tsc_start = timing->tsc_start;
+        report->monotonic_start = timing->monotonic_start;
+    }
+    report->tsc_end = timing->tsc_end;
+    report->monotonic_end = timing->monotonic_end;
+    report->frames++;
+
+    phase_add(&report->prime, timing->prime);
+    phase_add(&report->yield, timing->yield);
+    phase_add(&report->probe, timing->probe);
+}
+
+/**
+ * @brief Prints one part of the loop.
+ */
+static void phase_print(const frame_timing_phase_t *phase, const char *name,
+                        uint64_t frames, uint64_t cycles, FILE *file) {
+    fprintf(file,
+            "  %-11s %5.1lf%% (mean %.0lf cycles, min %u, max %u)\n",
+            name, 100.0 * phase->sum / cycles, (double)phase->sum / frames,
+            phase->min, phase->max);
+}
+
+void frame_timing_report_print(const frame_timing_report_t *report,
+                               uint32_t cpu, FILE *file) {
+    uint64_t cycles = report->tsc_end - report->tsc_start;
+    if (!report->frames || !cycles) {
+        return;
+    }
+
+    double seconds = (report->monotonic_end - report->monotonic_start) / 1e9;
+    fprintf(file,
+            "Loop time on CPU %u: %lu frames in %.3lf s (%.0lf frames/s, "
+            "%.1lf us per frame).\n",
+            cpu, report->frames, seconds,
+            seconds > 0 ? report->frames / seconds : 0,
+            seconds * 1e6 / report->frames);
+
+    phase_print(&report->prime, "prime", report->frames, cycles, file);
+    phase_print(&report->yield, "sched_yield", report->frames, cycles, file);
+    phase_print(&report->probe, "probe", report->frames, cycles, file);
+
+    uint64_t phases =
+        report->prime.sum + report->yield.sum + report->probe.sum;
+    uint64_t other = phases < cycles ? cycles - phases : 0;
+    fprintf(file, "  %-11s %5.1lf%% (timestamps and frame ring)\n", "other",
+            100.0 * other / cycles);
+}
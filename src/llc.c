@@ -0,0 +1,219 @@
+/**
+ * @file llc.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains all functions to build the eviction sets of the last level
+ * cache.
+ */
+
+#include "llc.h"
+
+#include <stdlib.h>
+#include <sys/mman.h>
+
+/**
+ * @brief Physical address bits which are XORed into the bits of the slice.
+ *
+ * The first mask selects bit 0 of the slice, the second bit 1 and the third
+ * bit 2. CPUs with 2^n slices use the first n masks.
+ */
+static const uint64_t llc_slice_masks[] = {0x1b5f575440, 0x2eb5faa880,
+                                           0x3cccc93100};
+
+uint32_t llc_slice_of(uintptr_t physical, uint32_t slice_count) {
+    uint32_t slice = 0;
+    for (uint32_t bit = 0; (1U << bit) < slice_count; bit++) {
+        slice |= __builtin_parityll(physical & llc_slice_masks[bit]) << bit;
+    }
+    return slice;
+}
+
+error_t llc_slots_new(llc_slots_t *slots, const cache_info_t *cache,
+                      uint32_t slice_count, const uint32_t *sets,
+                      uint32_t set_count) {
+    if (slice_count < 1 || slice_count > LLC_MAX_SLICES ||
+        (slice_count & (slice_count - 1)) ||
+        cache->set_count % slice_count) {
+        return ERROR_SLICES;
+    }
+
+    if (sets == NULL) {
+        set_count = cache->set_count;
+    }
+
+    for (uint32_t i = 0; sets != NULL && i < set_count; i++) {
+        if (sets[i] >= cache->set_count) {
+            return ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    slots->slice_count = slice_count;
+    slots->sets_per_slice = cache->set_count / slice_count;
+    slots->way_count = cache->ways_of_associativity;
+    slots->set_count = set_count;
+    slots->line_size = cache->line_size;
+    slots->missing = (uintptr_t)set_count * slots->way_count;
+    slots->slot_of = malloc(sizeof(int64_t) * cache->set_count);
+    slots->fill = calloc(set_count, sizeof(uint32_t));
+    slots->lines = malloc(sizeof(uintptr_t) * slots->missing);
+    if (slots->slot_of == NULL || slots->fill == NULL ||
+        slots->lines == NULL) {
+        llc_slots_free(slots);
+        return ERROR_ALLOCATION;
+    }
+
+    for (uint32_t i = 0; i < cache->set_count; i++) {
+        slots->slot_of[i] = sets == NULL ? (int64_t)i : -1;
+    }
+    for (uint32_t i = 0; sets != NULL && i < set_count; i++) {
+        slots->slot_of[sets[i]] = i;
+    }
+
+    return ERROR_NONE;
+}
+
+uintptr_t llc_slots_take(llc_slots_t *slots, uintptr_t page,
+                         uintptr_t physical, uint64_t page_size) {
+    uintptr_t taken = 0;
+
+    for (uintptr_t offset = 0; offset < page_size && slots->missing;
+         offset += slots->line_size) {
+        uintptr_t address = physical + offset;
+        uint32_t index = (address / slots->line_size) % slots->sets_per_slice;
+        uint32_t slice = llc_slice_of(address, slots->slice_count);
+
+        int64_t slot =
+            slots->slot_of[(uintptr_t)slice * slots->sets_per_slice + index];
+        if (slot < 0 || slots->fill[slot] == slots->way_count) {
+            continue;
+        }
+
+        slots->lines[slot * slots->way_count + slots->fill[slot]] =
+            page + offset;
+        slots->fill[slot]++;
+        slots->missing--;
+        taken++;
+    }
+
+    return taken;
+}
+
+void llc_slots_free(llc_slots_t *slots) {
+    free(slots->slot_of);
+    free(slots->fill);
+    free(slots->lines);
+    slots->slot_of = NULL;
+    slots->fill = NULL;
+    slots->lines = NULL;
+}
+
+error_t llc_pool_new(llc_pool_t *pool, const cache_info_t *cache,
+                     uint32_t slice_count, const uint32_t *sets,
+                     uint32_t set_count) {
+    llc_slots_t slots;
+    FORWARD_ON_FAIL(
+        llc_slots_new(&slots, cache, slice_count, sets, set_count));
+
+    uint32_t max_pages;
+    error_t err = get_hugepagenr(&max_pages);
+    if (err == ERROR_NONE && max_pages < 1) {
+        err = ERROR_NO_HUGEPAGES;
+    }
+    if (err == ERROR_NONE) {
+        err = get_hugepagesize(&pool->page_size);
+    }
+
+    // every hugepage has to cover all sets of a slice
+    if (err == ERROR_NONE &&
+        pool->page_size %
+            ((uint64_t)slots.sets_per_slice * cache->line_size)) {
+        err = ERROR_NOT_ALIGNED;
+    }
+
+    pagemap_t pagemap;
+    if (err == ERROR_NONE && (err = pagemap_open(&pagemap))) {
+        pagemap_close(&pagemap);
+    }
+    if (err != ERROR_NONE) {
+        llc_slots_free(&slots);
+        return err;
+    }
+
+    pool->page_count = 0;
+    pool->slice_count = slots.slice_count;
+    pool->sets_per_slice = slots.sets_per_slice;
+    pool->way_count = slots.way_count;
+    pool->set_count = slots.set_count;
+    pool->lines = NULL;
+    pool->pages = malloc(sizeof(void *) * max_pages);
+    void **spare = malloc(sizeof(void *) * max_pages);
+
+    uint32_t spare_count = 0;
+    if (pool->pages == NULL || spare == NULL) {
+        err = ERROR_ALLOCATION;
+        goto CLEANUP;
+    }
+
+    uint32_t mapped = 0;
+    while (slots.missing && mapped < max_pages) {
+        void *page =
+            mmap(NULL, pool->page_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (page == MAP_FAILED) {
+            // the remaining hugepages are used by other processes
+            break;
+        }
+
+        // ensures that the page is in memory
+        *(volatile int *)page = 0;
+        mapped++;
+
+        uintptr_t physical;
+        if ((err = pagemap_translate(&pagemap, page, 1, &physical))) {
+            munmap(page, pool->page_size);
+            goto CLEANUP;
+        }
+
+        if (llc_slots_take(&slots, (uintptr_t)page, physical,
+                           pool->page_size)) {
+            pool->pages[pool->page_count++] = page;
+        } else {
+            // the page stays mapped, an unmapped page would be handed out
+            // again by the next mmap
+            spare[spare_count++] = page;
+        }
+    }
+
+    if (slots.missing) {
+        err = mapped ? ERROR_EVICTION_SETS : ERROR_MMAP;
+    }
+
+    pool->lines = slots.lines;
+    slots.lines = NULL;
+
+CLEANUP:
+    for (uint32_t i = 0; i < spare_count; i++) {
+        munmap(spare[i], pool->page_size);
+    }
+
+    pagemap_close(&pagemap);
+    llc_slots_free(&slots);
+    free(spare);
+    if (err != ERROR_NONE) {
+        llc_pool_free(pool);
+    }
+
+    return err;
+}
+
+void llc_pool_free(llc_pool_t *pool) {
+    for (uint32_t i = 0; pool->pages != NULL && i < pool->page_count; i++) {
+        munmap(pool->pages[i], pool->page_size);
+    }
+
+    free(pool->pages);
+    free(pool->lines);
+    pool->pages = NULL;
+    pool->lines = NULL;
+    pool->page_count = 0;
+}
@@ -5,12 +5,20 @@
  * @brief Contains all functions which are necessary for the program execution.
  */
 #include "alloc.h"
+#include "arena.h"
+#include "calibration.h"
 #include "error.h"
+#include "evset.h"
+#include "llc.h"
+#include "plan.h"
 #include "profile.h"
+#include "ring.h"
 #include "sys_action.h"
 #include "sys_info.h"
+#include "topology.h"
 
 #include <argp.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -20,6 +28,31 @@
  */
 #define PROGRAM_IDENTIFIER 3000
 #define PROGRAM_ARGS_IDENTIFIER 3001
+#define WRITER_CPU_IDENTIFIER 3002
+#define RING_IDENTIFIER 3003
+#define ORDER_IDENTIFIER 3004
+#define TIMER_IDENTIFIER 3005
+#define GRANULARITY_IDENTIFIER 3006
+#define SETS_IDENTIFIER 3007
+#define ALLOC_IDENTIFIER 3008
+#define EVSET_CACHE_IDENTIFIER 3009
+#define ARENA_PAGE_IDENTIFIER 3010
+#define PLACEMENT_IDENTIFIER 3011
+#define INPUT_IDENTIFIER 3012
+#define FORMAT_IDENTIFIER 3013
+#define CLASSIFY_IDENTIFIER 3014
+#define CALIBRATION_IDENTIFIER 3015
+#define FILTER_IDENTIFIER 3016
+#define HISTOGRAMS_IDENTIFIER 3017
+#define AGGREGATE_IDENTIFIER 3018
+#define STATS_IDENTIFIER 3019
+#define FUSED_IDENTIFIER 3020
+#define WAYS_IDENTIFIER 3021
+
+/**
+ * Used to mark that the CPU of the writer thread is chosen automatically.
+ */
+#define WRITER_CPU_AUTO -2
 
 extern char **environ;
 
@@ -42,7 +75,10 @@ const char doc[] =
     "OPERATION MODES:\n\n"
     "  profile\t\tUsing assembly to compute the time of a cache access.\n"
     "  bench\t\t\tBenchmarking the system.\n"
-    "  info\t\t\tDisplays information about the cache."
+    "  info\t\t\tPrints the cache topology of all CPU cores as JSON.\n"
+    "  calibrate\t\tMeasures the access time of every cache level and "
+    "stores\n\t\t\tthe thresholds in the calibration file.\n"
+    "  convert\t\tConverts a .cnv file (--input) into a HDF5 file (-o)."
     "\n\n OPTIONS:";
 
 /**
@@ -57,12 +93,13 @@ static struct argp_option arg_options[] = {
     {"iter", 'i', "ITERATIONS", 0, "Specifies the amount of iterations."},
     {"seconds", 's', "SECONDS", 0,
      "Specifies the duration of the measurement in seconds."},
-    {"cpu", 'c', "ID", 0,
-     "Specifies the CPU core on which this program will run. If the process "
-     "gets bound by a different program set this to -1."},
+    {"cpu", 'c', "LIST", 0,
+     "Specifies the CPU cores on which this program will run, e.g. 0-15,32. "
+     "Every CPU core is profiled by its own thread. If the process gets bound "
+     "by a different program set this to -1."},
     {"pid", 'p', "PID", 0,
      "Specifies the PID of the another process. The process is moved to the"
-     "same CPU core if one is specified. This can not be used with the "
+     "same CPU cores if they are specified. This can not be used with the "
      "--program and"
      "the --program-args arguments."},
     {"level", 'l', "LEVEL", 0,
@@ -74,7 +111,90 @@ static struct argp_option arg_options[] = {
      "Specifies arguments for the program which will be run before the "
      "measurement. This can not be used with --pid argument."},
     {"output", 'o', "FILE", 0,
-     "Saves the time measurement into a file instead of stdio."},
+     "Saves the time measurement into a file instead of stdio. With multiple "
+     "CPU cores every core is stored in the group cpuN. A file ending with "
+     ".cnv is a raw frame stream which can be mapped into the memory, with "
+     "multiple CPU cores every core writes FILE.cpuN."},
+    {"input", INPUT_IDENTIFIER, "FILE", 0,
+     "Specifies the .cnv file of the convert mode. If it does not exist, the "
+     "files FILE.cpuN of the CPU cores in --cpu are converted into the groups "
+     "cpuN."},
+    {"writer-cpu", WRITER_CPU_IDENTIFIER, "ID", 0,
+     "Specifies the CPU core of the thread which writes the output. Defaults "
+     "to a CPU core which is not in --cpu. Set this to -1 to not bind the "
+     "thread."},
+    {"ring", RING_IDENTIFIER, "FRAMES", 0,
+     "Specifies how many frames can be buffered between the measurement and "
+     "the output. Frames are dropped if the buffer is full."},
+    {"order", ORDER_IDENTIFIER, "ORDER", 0,
+     "Specifies the order in which the cache lines are probed: linear "
+     "(default), reverse or random."},
+    {"timer", TIMER_IDENTIFIER, "TIMER", 0,
+     "Specifies the timing primitive of the measurement: rdpmc (default, "
+     "cpuid + rdpmc), rdtscp (rdtscp + lfence) or rdtsc (lfence + rdtsc)."},
+    {"granularity", GRANULARITY_IDENTIFIER, "GRANULARITY", 0,
+     "Specifies if every cache line (line, default) or every cache set (set) "
+     "is measured. With set all ways of a set are measured at once."},
+    {"sets", SETS_IDENTIFIER, "LIST", 0,
+     "Specifies the probed cache sets, e.g. 0-63,1024. Defaults to all sets. "
+     "In the last level cache the set i of slice s has the id "
+     "s * (sets / slices) + i."},
+    {"ways", WAYS_IDENTIFIER, "LIST", 0,
+     "Specifies the probed ways of every set, e.g. 0-3. Defaults to all ways. "
+     "With fewer sets and ways every frame is shorter, so the frame rate "
+     "grows, but a set only misses after other processes replaced the ways "
+     "which are not probed as well."},
+    {"alloc", ALLOC_IDENTIFIER, "MODE", 0,
+     "Specifies how the probed cache lines are allocated: hugepage (aligned "
+     "hugepages), color (small pages picked by their physical address), "
+     "evset (eviction sets found by timing), arena (probe buffers, probe "
+     "plans and rings carved out of one hugepage region) or auto (default, "
+     "the first one which is usable)."},
+    {"evset-cache", EVSET_CACHE_IDENTIFIER, "FILE", 0,
+     "Stores the eviction sets of --alloc evset in a file and reuses them "
+     "until the next reboot. The file should be located in a tmpfs, e.g. "
+     "/dev/shm/evsets. With multiple CPU cores .cpuN is appended."},
+    {"arena-page", ARENA_PAGE_IDENTIFIER, "SIZE", 0,
+     "Specifies the hugepage size of --alloc arena: 2M (default) or 1G."},
+    {"placement", PLACEMENT_IDENTIFIER, "POLICY", 0,
+     "Specifies the CPU cores of the --pid or --program workload: same-core "
+     "(default, the profiled CPU cores), smt-sibling (the hyper threads of "
+     "the profiled CPU cores), shared-l2 or shared-l3 (other CPU cores which "
+     "share this cache with the profiled CPU cores)."},
+    {"format", FORMAT_IDENTIFIER, "FORMAT", 0,
+     "Specifies the format of the output on stdout: text (default), csv "
+     "(cpu,clock,set,values... per set) or ndjson (one JSON object per "
+     "frame)."},
+    {"classify", CLASSIFY_IDENTIFIER, "CYCLES", OPTION_ARG_OPTIONAL,
+     "Writes every frame as a bitmap with one bit per value, which is set if "
+     "the access took more than CYCLES (a miss). Without CYCLES the "
+     "threshold is read from the calibration file or, if the CPU core is "
+     "not calibrated, measured before the measurement."},
+    {"calibration", CALIBRATION_IDENTIFIER, "FILE", 0,
+     "Specifies the calibration file of the calibrate mode, --classify and "
+     "--filter (default " CALIBRATION_DEFAULT_FILE ")."},
+    {"filter", FILTER_IDENTIFIER, 0, 0,
+     "Clamps outliers (e.g. interrupts), which are slower than the "
+     "calibrated limit, to the limit. Needs a calibration of the CPU "
+     "cores."},
+    {"histograms", HISTOGRAMS_IDENTIFIER, "only", OPTION_ARG_OPTIONAL,
+     "Counts the cycles of every set in a histogram and writes the "
+     "histograms and percentiles (p50, p90, p99, p99.9) after the last "
+     "frame. With only, the frames are not written. Not available for .cnv "
+     "files."},
+    {"aggregate", AGGREGATE_IDENTIFIER, "N", 0,
+     "Writes the mean, the maximum and the miss rate of every value over "
+     "windows of N frames instead of the frames. The threshold of the misses "
+     "is found like the one of --classify, which only sets the threshold "
+     "then. Not available for .cnv files."},
+    {"stats", STATS_IDENTIFIER, "SECONDS", OPTION_ARG_OPTIONAL,
+     "Prints the frame rate, the dropped and interrupted frames of every "
+     "CPU core and the load of the writer thread to stderr at the end. With "
+     "SECONDS a line with the current rates is printed every SECONDS."},
+    {"fused", FUSED_IDENTIFIER, 0, 0,
+     "Primes only the first frame, every probe primes the next frame. The "
+     "direction of the probe alternates every frame, which roughly doubles "
+     "the frame rate. The bench mode compares it with the separate prime."},
     {0}};
 
 /**
@@ -93,11 +213,59 @@ typedef struct {
                 core. arguments#pid. */
     int seconds; /**< Specifies the duration of the measurement in seconds
                     arguments#seconds*/
-    int cpu; /**< Specifies which CPU core should be used.. arguments#cpu. */
+    uint32_t *cpus;     /**< Specifies which CPU cores should be used.
+                           arguments#cpus. */
+    uint32_t cpu_count; /**< Amount of CPU cores. arguments#cpu_count. */
+    int bind; /**< Specifies if this program binds itself to the CPU cores.
+                 arguments#bind. */
     char *output_file; /**< Specifies the output file. arguments#output_file. */
+    char *input_file;  /**< Specifies the input file of the convert mode.
+                          arguments#input_file. */
     char *program;     /**< Specifies a program. arguments#output_file. */
     char *program_args; /**< Specifies the arguments of a program.
                            arguments#output_file. */
+    int writer_cpu; /**< Specifies the CPU core of the writer thread.
+                       arguments#writer_cpu. */
+    int ring_size;  /**< Specifies the amount of buffered frames.
+                       arguments#ring_size. */
+    plan_order_t order; /**< Specifies the traversal order of the cache
+                           lines. arguments#order. */
+    timer_type_t timer; /**< Specifies the timer backend. arguments#timer. */
+    plan_granularity_t granularity; /**< Specifies the measurement
+                                       granularity. arguments#granularity. */
+    uint32_t *sets;     /**< Specifies the probed sets or NULL for all sets.
+                           arguments#sets. */
+    uint32_t set_count; /**< Amount of probed sets. arguments#set_count. */
+    uint32_t *ways;     /**< Specifies the probed ways or NULL for all ways.
+                           arguments#ways. */
+    uint32_t way_count; /**< Amount of probed ways. arguments#way_count. */
+    alloc_mode_t alloc; /**< Specifies the allocator of the cache lines.
+                           arguments#alloc. */
+    char *evset_cache; /**< Specifies the eviction set cache file.
+                          arguments#evset_cache. */
+    uint64_t arena_page; /**< Specifies the hugepage size of the arena.
+                            arguments#arena_page. */
+    topology_placement_t placement; /**< Specifies the CPU cores of the
+                                       workload. arguments#placement. */
+    output_format_t format; /**< Specifies the format of the output on
+                               stdout. arguments#format. */
+    int classify; /**< Specifies if the frames are classified.
+                     arguments#classify. */
+    uint32_t threshold; /**< Specifies the threshold of the classification or
+                           zero to calibrate it. arguments#threshold. */
+    char *calibration_file; /**< Specifies the calibration file.
+                               arguments#calibration_file. */
+    int filter; /**< Specifies if outliers are clamped. arguments#filter. */
+    profile_histograms_t histograms; /**< Specifies the histograms of the
+                                        sets. arguments#histograms. */
+    uint32_t aggregate; /**< Specifies the size of the aggregated windows or
+                           zero to write every frame. arguments#aggregate. */
+    int stats; /**< Specifies if the statistics of the profiler are printed.
+                  arguments#stats. */
+    int fused; /**< Specifies if the probe primes the next frame.
+                  arguments#fused. */
+    uint32_t stats_interval; /**< Specifies the seconds between two lines of
+                                statistics. arguments#stats_interval. */
 } arguments_t;
 
 /**
@@ -113,7 +281,14 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
         arguments->pid = atoi(arg);
         break;
     case 'c':
-        arguments->cpu = atoi(arg);
+        free(arguments->cpus);
+        arguments->cpus = NULL;
+        arguments->cpu_count = 0;
+        arguments->bind = atoi(arg) > -1;
+        if (arguments->bind && parse_id_list(arg, &arguments->cpus,
+                                             &arguments->cpu_count)) {
+            argp_error(state, "Invalid CPU list %s.", arg);
+        }
         break;
     case 'l':
         arguments->level = atoi(arg);
@@ -133,6 +308,107 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
     case PROGRAM_ARGS_IDENTIFIER:
         arguments->program_args = arg;
         break;
+    case WRITER_CPU_IDENTIFIER:
+        arguments->writer_cpu = atoi(arg);
+        break;
+    case RING_IDENTIFIER:
+        arguments->ring_size = atoi(arg);
+        break;
+    case ORDER_IDENTIFIER:
+        if (plan_order_from(arg, &arguments->order)) {
+            argp_error(state, "Unknown order %s.", arg);
+        }
+        break;
+    case TIMER_IDENTIFIER:
+        if (timer_type_from(arg, &arguments->timer)) {
+            argp_error(state, "Unknown timer %s.", arg);
+        }
+        break;
+    case GRANULARITY_IDENTIFIER:
+        if (plan_granularity_from(arg, &arguments->granularity)) {
+            argp_error(state, "Unknown granularity %s.", arg);
+        }
+        break;
+    case SETS_IDENTIFIER:
+        free(arguments->sets);
+        if (parse_id_list(arg, &arguments->sets, &arguments->set_count)) {
+            argp_error(state, "Invalid set list %s.", arg);
+        }
+        break;
+    case WAYS_IDENTIFIER:
+        free(arguments->ways);
+        if (parse_id_list(arg, &arguments->ways, &arguments->way_count)) {
+            argp_error(state, "Invalid way list %s.", arg);
+        }
+        break;
+    case ALLOC_IDENTIFIER:
+        if (alloc_mode_from(arg, &arguments->alloc)) {
+            argp_error(state, "Unknown allocator %s.", arg);
+        }
+        break;
+    case EVSET_CACHE_IDENTIFIER:
+        arguments->evset_cache = arg;
+        break;
+    case ARENA_PAGE_IDENTIFIER:
+        if (!strcmp(arg, "2M")) {
+            arguments->arena_page = ARENA_PAGE_2MB;
+        } else if (!strcmp(arg, "1G")) {
+            arguments->arena_page = ARENA_PAGE_1GB;
+        } else {
+            argp_error(state, "Unknown hugepage size %s.", arg);
+        }
+        break;
+    case INPUT_IDENTIFIER:
+        arguments->input_file = arg;
+        break;
+    case PLACEMENT_IDENTIFIER:
+        if (topology_placement_from(arg, &arguments->placement)) {
+            argp_error(state, "Unknown placement %s.", arg);
+        }
+        break;
+    case CLASSIFY_IDENTIFIER:
+        arguments->classify = 1;
+        arguments->threshold = arg != NULL ? atoi(arg) : 0;
+        if (arg != NULL && arguments->threshold < 1) {
+            argp_error(state, "Invalid threshold %s.", arg);
+        }
+        break;
+    case CALIBRATION_IDENTIFIER:
+        arguments->calibration_file = arg;
+        break;
+    case FILTER_IDENTIFIER:
+        arguments->filter = 1;
+        break;
+    case HISTOGRAMS_IDENTIFIER:
+        if (arg == NULL) {
+            arguments->histograms = HISTOGRAMS_WITH_FRAMES;
+        } else if (!strcmp(arg, "only")) {
+            arguments->histograms = HISTOGRAMS_ONLY;
+        } else {
+            argp_error(state, "Unknown histograms %s.", arg);
+        }
+        break;
+    case FUSED_IDENTIFIER:
+        arguments->fused = 1;
+        break;
+    case STATS_IDENTIFIER:
+        arguments->stats = 1;
+        arguments->stats_interval = arg != NULL ? atoi(arg) : 0;
+        if (arg != NULL && arguments->stats_interval < 1) {
+            argp_error(state, "Invalid interval %s.", arg);
+        }
+        break;
+    case AGGREGATE_IDENTIFIER:
+        arguments->aggregate = atoi(arg);
+        if (arguments->aggregate < 1) {
+            argp_error(state, "Invalid window %s.", arg);
+        }
+        break;
+    case FORMAT_IDENTIFIER:
+        if (output_format_from(arg, &arguments->format)) {
+            argp_error(state, "Unknown format %s.", arg);
+        }
+        break;
     case ARGP_KEY_ARG:
         if (state->arg_num >= 1) {
             argp_usage(state);
@@ -158,24 +434,138 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
  */
 static struct argp argp = {arg_options, parse_opt, args_doc, doc};
 
+/**
+ * @brief Returns if the output file is a .cnv frame stream.
+ */
+static int output_is_cnv(const char *path) {
+    size_t length = strlen(path);
+    return length >= 4 && !strcmp(path + length - 4, ".cnv");
+}
+
+/**
+ * @brief Looks up the caches of a CPU core, starting at L1.
+ *
+ * @param topology the topology
+ * @param cpu id of the CPU core
+ * @param levels writes up to CALIBRATION_MAX_LEVELS caches into
+ *
+ * @return The amount of caches.
+ */
+static uint32_t core_levels(const topology_t *topology, uint32_t cpu,
+                            cache_info_t *levels) {
+    uint32_t level_count = 0;
+    while (level_count < CALIBRATION_MAX_LEVELS &&
+           topology_cache(topology, cpu, level_count + 1,
+                          levels + level_count) == ERROR_NONE) {
+        level_count++;
+    }
+    return level_count;
+}
+
+/**
+ * @brief Estimates the size of the arena of a profiling run.
+ *
+ * @param arguments the program arguments
+ * @param caches the cache of every CPU core
+ *
+ * Every CPU core gets a probe buffer (twice the cache size, so an aligned
+ * offset is always found), its probe plan and its frame ring. The last level
+ * cache keeps its eviction sets, so only the plan and the ring are counted.
+ *
+ * @return The size in bytes.
+ */
+static uintptr_t arena_estimate(const arguments_t *arguments,
+                                const cache_info_t *caches) {
+    uintptr_t size = 0;
+
+    for (uint32_t i = 0; i < arguments->cpu_count; i++) {
+        const cache_info_t *cache = caches + i;
+        uintptr_t way_size = (uintptr_t)cache->set_count * cache->line_size;
+        uintptr_t sets =
+            arguments->sets != NULL ? arguments->set_count : cache->set_count;
+        uintptr_t ways = arguments->ways != NULL
+                             ? arguments->way_count
+                             : cache->ways_of_associativity;
+        uintptr_t frame = sets * ways * sizeof(uint32_t);
+
+        if (cache->level < LLC_MIN_LEVEL) {
+            size += 2 * cache->total_size;
+        }
+        size += sets * ways * sizeof(plan_entry_t);
+
+        if (arguments->ring_size > 0) {
+            uintptr_t power = 2;
+            while (power * 2 <= (uintptr_t)arguments->ring_size) {
+                power *= 2;
+            }
+            size += power * frame;
+        } else {
+            size += RING_DEFAULT_SIZE / arguments->cpu_count;
+        }
+
+        // slack to step over the probed sets
+        size += 2 * way_size;
+    }
+
+    return size;
+}
+
 int main(int argc, char **argv) {
-    output_t output;
+    output_t output = {0};
     arguments_t arguments;
-    cache_info_t cache;
 
     arguments.level = 1;
     arguments.iter = 0;
     arguments.pid = 0;
-    arguments.cpu = 0;
+    arguments.cpus = NULL;
+    arguments.cpu_count = 0;
+    arguments.bind = 1;
     arguments.seconds = 0;
     arguments.output_file = NULL;
+    arguments.input_file = NULL;
     arguments.program = NULL;
     arguments.program_args = NULL;
+    arguments.writer_cpu = WRITER_CPU_AUTO;
+    arguments.ring_size = 0;
+    arguments.order = PLAN_ORDER_LINEAR;
+    arguments.timer = TIMER_RDPMC;
+    arguments.granularity = PLAN_GRANULARITY_LINE;
+    arguments.sets = NULL;
+    arguments.ways = NULL;
+    arguments.set_count = 0;
+    arguments.alloc = ALLOC_AUTO;
+    arguments.evset_cache = NULL;
+    arguments.arena_page = ARENA_PAGE_2MB;
+    arguments.placement = PLACEMENT_SAME_CORE;
+    arguments.format = OUTPUT_FORMAT_TEXT;
+    arguments.classify = 0;
+    arguments.threshold = 0;
+    arguments.calibration_file = CALIBRATION_DEFAULT_FILE;
+    arguments.filter = 0;
+    arguments.histograms = HISTOGRAMS_OFF;
+    arguments.aggregate = 0;
+    arguments.stats = 0;
+    arguments.fused = 0;
+    arguments.stats_interval = 0;
 
     argp_parse(&argp, argc, argv, 0, 0, &arguments);
 
     pid_t this_pid = getpid();
-    void *buffer = NULL;
+    cache_info_t *caches = NULL;
+    void **buffers = NULL;
+    probe_plan_t *plans = NULL;
+    llc_pool_t *pools = NULL;
+    evset_pool_t *evsets = NULL;
+    color_pool_t *colors = NULL;
+    arena_t arena = {0};
+    arena_t *plan_arena = NULL;
+    topology_t topology = {0};
+    uint32_t *workload = NULL;
+    calibration_t *calibrations = NULL;
+    char model[CALIBRATION_MODEL_SIZE];
+    uint32_t workload_count = 0;
+    output_t *outputs = NULL;
+    profile_core_t *cores = NULL;
 
     if (!this_pid) {
         printf("Could not get the PID of this process.");
@@ -207,126 +597,594 @@ int main(int argc, char **argv) {
         }
     }
 
-    if (arguments.cpu > -1) {
-        printf("Binding this process(%u) to CPU %d.\n", this_pid,
-               arguments.cpu);
-        EXIT_ON_FAIL(focus_cpu_core(this_pid, arguments.cpu),
+    EXIT_ON_FAIL(topology_new(&topology),
+                 "Error while reading the cache topology");
+    calibration_model(model);
+
+    if (!strcmp(arguments.mode, "info")) {
+        topology_print_json(&topology, stdout);
+        goto FINALIZE;
+    }
+
+    if (arguments.cpu_count == 0) {
+        arguments.cpus = malloc(sizeof(uint32_t));
+        if (arguments.cpus == NULL) {
+            EXIT_ON_FAIL(ERROR_ALLOCATION, "Error while parsing the CPU list");
+        }
+        arguments.cpus[0] = 0;
+        arguments.cpu_count = 1;
+
+        if (!arguments.bind) {
+            printf("WARNING: you have to bind this process(%u) to a fixed CPU "
+                   "by yourself.\n",
+                   this_pid);
+
+            EXIT_ON_FAIL(get_current_cpu_core(arguments.cpus),
+                         "Error while retrieving current CPU core");
+        }
+    }
+
+    if (!strcmp(arguments.mode, "convert")) {
+        if (arguments.input_file == NULL || arguments.output_file == NULL) {
+            fprintf(stderr, "The convert mode needs --input and --output.\n");
+            goto FINALIZE;
+        }
+
+        EXIT_ON_FAIL(outputc_hd5_file(&output, arguments.output_file),
+                     "Error while creating output file for HDF5.");
+
+        if (!access(arguments.input_file, R_OK)) {
+            printf("Converting %s.\n", arguments.input_file);
+            EXIT_ON_FAIL(output_cnv_convert(arguments.input_file, &output),
+                         "Error while converting the .cnv file");
+            goto FINALIZE;
+        }
+
+        outputs = calloc(arguments.cpu_count, sizeof(output_t));
+        if (outputs == NULL) {
+            EXIT_ON_FAIL(ERROR_ALLOCATION,
+                         "Error while allocating the CPU cores");
+        }
+
+        for (uint32_t i = 0; i < arguments.cpu_count; i++) {
+            char path[PATH_MAX];
+            char name[16];
+            snprintf(path, sizeof(path), "%s.cpu%u", arguments.input_file,
+                     arguments.cpus[i]);
+            snprintf(name, sizeof(name), "cpu%u", arguments.cpus[i]);
+
+            printf("Converting %s.\n", path);
+            EXIT_ON_FAIL(outputc_hd5_group(outputs + i, &output, name),
+                         "Error while creating output group for HDF5.");
+            EXIT_ON_FAIL(output_cnv_convert(path, outputs + i),
+                         "Error while converting the .cnv file");
+        }
+        goto FINALIZE;
+    }
+
+    if (arguments.pid || arguments.program) {
+        EXIT_ON_FAIL(topology_place(&topology, arguments.placement,
+                                    arguments.cpus, arguments.cpu_count,
+                                    &workload, &workload_count),
+                     "Error while placing the workload");
+    }
+
+    if (arguments.writer_cpu == WRITER_CPU_AUTO) {
+        // the writer neither disturbs the profiler nor the workload
+        uint32_t *busy = malloc(sizeof(uint32_t) *
+                                (arguments.cpu_count + workload_count));
+        if (busy == NULL) {
+            EXIT_ON_FAIL(ERROR_ALLOCATION,
+                         "Error while choosing the CPU core of the writer "
+                         "thread");
+        }
+        memcpy(busy, arguments.cpus, sizeof(uint32_t) * arguments.cpu_count);
+        if (workload_count) {
+            memcpy(busy + arguments.cpu_count, workload,
+                   sizeof(uint32_t) * workload_count);
+        }
+
+        // has to be done before this process gets bound to a single CPU
+        error_t err = get_other_cpu_core(
+            busy, arguments.cpu_count + workload_count, &arguments.writer_cpu);
+        free(busy);
+        EXIT_ON_FAIL(err,
+                     "Error while choosing the CPU core of the writer thread");
+    }
+
+    if (arguments.bind) {
+        printf("Binding this process(%u) to CPU %u.\n", this_pid,
+               arguments.cpus[0]);
+        EXIT_ON_FAIL(focus_cpu_core(this_pid, arguments.cpus[0]),
                      "Error while setting CPU affinity of this process");
-    } else {
-        printf("WARNING: you have to bind this process(%u) to a fixed CPU by "
-               "yourself.\n",
-               this_pid);
-
-        uint32_t core;
-        EXIT_ON_FAIL(get_current_cpu_core(&core),
-                     "Error while retrieving current CPU core");
-        arguments.cpu = core;
     }
 
-    printf(" --------------------------------------------------------------\n");
+    caches = calloc(arguments.cpu_count, sizeof(cache_info_t));
+    buffers = calloc(arguments.cpu_count, sizeof(void *));
+    plans = calloc(arguments.cpu_count, sizeof(probe_plan_t));
+    pools = calloc(arguments.cpu_count, sizeof(llc_pool_t));
+    evsets = calloc(arguments.cpu_count, sizeof(evset_pool_t));
+    colors = calloc(arguments.cpu_count, sizeof(color_pool_t));
+    outputs = calloc(arguments.cpu_count, sizeof(output_t));
+    cores = calloc(arguments.cpu_count, sizeof(profile_core_t));
+    if (caches == NULL || buffers == NULL || plans == NULL || pools == NULL ||
+        evsets == NULL || colors == NULL || outputs == NULL ||
+        cores == NULL) {
+        EXIT_ON_FAIL(ERROR_ALLOCATION, "Error while allocating the CPU cores");
+    }
 
-    printf("Using L%d cache on CPU %d\n", arguments.level, arguments.cpu);
+    for (uint32_t i = 0; i < arguments.cpu_count; i++) {
+        printf(
+            " --------------------------------------------------------------\n");
 
-    EXIT_ON_FAIL(cache_info_new(&cache, arguments.cpu, arguments.level),
-                 "Error while initializing the cache info");
+        printf("Using L%d cache on CPU %u\n", arguments.level,
+               arguments.cpus[i]);
 
-    cache_info_print(&cache);
+        EXIT_ON_FAIL(topology_cache(&topology, arguments.cpus[i],
+                                    arguments.level, caches + i),
+                     "Error while initializing the cache info");
+
+        cache_info_print(caches + i);
+
+        uint32_t slices;
+        if (caches[i].level >= LLC_MIN_LEVEL &&
+            topology_slice_count(&topology, caches + i, &slices) ==
+                ERROR_NONE) {
+            printf("  SLICES: %u\n", slices);
+        }
+    }
 
     printf(" --------------------------------------------------------------\n");
 
-    if (!strcmp(arguments.mode, "info")) {
-        printf("Do nothing ... done.\n");
-    } else {
-        if (!has_root_access()) {
-            fprintf(stderr, "ERROR this program needs root permissions\n");
-            exit(EXIT_FAILURE);
+    if (!has_root_access()) {
+        fprintf(stderr, "ERROR this program needs root permissions\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((!strcmp(arguments.mode, "profile") ||
+         !strcmp(arguments.mode, "calibrate")) &&
+        arguments.timer == TIMER_RDPMC) {
+        EXIT_ON_FAIL(can_use_rdpmc(),
+                     "While checking if the rdpmc instruction can be used "
+                     "in userspace");
+    }
+
+    if (!strcmp(arguments.mode, "bench")) {
+        if (arguments.iter < 1) {
+            arguments.iter = 1000000;
         }
 
-        EXIT_ON_FAIL(
-            can_use_rdpmc(),
-            "While checking if the rdpmc instruction can be used in userspace");
+        printf("Starting benchmark with %d iterations ...\n",
+               arguments.iter);
+        EXIT_ON_FAIL(benchmark(arguments.iter, arguments.cpus[0]),
+                     "Error while benchmarking");
+        EXIT_ON_FAIL(benchmark_output(caches),
+                     "Error while benchmarking the output");
+
+        cache_info_t levels[CALIBRATION_MAX_LEVELS];
+        uint32_t level_count =
+            core_levels(&topology, arguments.cpus[0], levels);
+        EXIT_ON_FAIL(benchmark_latency(levels, level_count,
+                                       arguments.cpus[0]),
+                     "Error while benchmarking the latency");
+        EXIT_ON_FAIL(benchmark_fused(caches, arguments.timer,
+                                     arguments.cpus[0]),
+                     "Error while benchmarking the fused probe");
+        EXIT_ON_FAIL(benchmark_prime(caches, arguments.timer,
+                                     arguments.cpus[0]),
+                     "Error while benchmarking the prime");
+    } else if (!strcmp(arguments.mode, "calibrate")) {
+        calibrations = calloc(arguments.cpu_count, sizeof(calibration_t));
+        if (calibrations == NULL) {
+            EXIT_ON_FAIL(ERROR_ALLOCATION, "Error while calibrating");
+        }
 
-        if (!strcmp(arguments.mode, "bench")) {
-            if (arguments.iter < 1) {
-                arguments.iter = 1000000;
+        for (uint32_t i = 0; i < arguments.cpu_count; i++) {
+            cache_info_t levels[CALIBRATION_MAX_LEVELS];
+            uint32_t level_count =
+                core_levels(&topology, arguments.cpus[i], levels);
+
+            if (arguments.bind) {
+                EXIT_ON_FAIL(
+                    focus_cpu_core(this_pid, arguments.cpus[i]),
+                    "Error while setting CPU affinity of this process");
             }
 
-            printf("Starting benchmark with %d iterations ...\n",
-                   arguments.iter);
-            EXIT_ON_FAIL(benchmark(arguments.iter), "Error while benchmarking");
-        } else if (!strcmp(arguments.mode, "profile")) {
-            if (arguments.output_file == NULL) {
-                EXIT_ON_FAIL(outputc_stdout(&output, stdout),
-                             "Error while creating output for stdout.");
-            } else {
-                EXIT_ON_FAIL(outputc_hd5_file(&output, arguments.output_file),
-                             "Error while creating output file for HDF5.");
+            EXIT_ON_FAIL(calibrate_cpu(levels, level_count, arguments.timer,
+                                       arguments.cpus[i], calibrations + i),
+                         "Error while calibrating");
+            calibration_print(calibrations + i, stdout);
+        }
+
+        EXIT_ON_FAIL(calibration_store(arguments.calibration_file,
+                                       calibrations, arguments.cpu_count),
+                     "Error while storing the calibration");
+        printf("Stored the calibration in %s.\n", arguments.calibration_file);
+    } else if (!strcmp(arguments.mode, "profile")) {
+        if (arguments.output_file == NULL) {
+            EXIT_ON_FAIL(outputc_stdout(&output, stdout),
+                         "Error while creating output for stdout.");
+            output_set_format(&output, arguments.format);
+            output_set_cpu(&output, arguments.cpus[0]);
+        } else if (output_is_cnv(arguments.output_file)) {
+            if (arguments.histograms != HISTOGRAMS_OFF) {
+                EXIT_ON_FAIL(ERROR_INVALID_ARGUMENT,
+                             "A .cnv file can not hold histograms");
             }
+            if (arguments.aggregate) {
+                EXIT_ON_FAIL(ERROR_INVALID_ARGUMENT,
+                             "A .cnv file can not hold aggregated windows");
+            }
+
+            // with multiple CPU cores every core gets its own file
+            if (arguments.cpu_count == 1) {
+                EXIT_ON_FAIL(outputc_cnv_file(&output, arguments.output_file,
+                                              caches, arguments.timer,
+                                              arguments.cpus[0]),
+                             "Error while creating the .cnv file.");
+            }
+        } else {
+            EXIT_ON_FAIL(outputc_hd5_file(&output, arguments.output_file),
+                         "Error while creating output file for HDF5.");
+        }
 
-            printf("Start profiling ");
+        printf("Start profiling ");
 
-            if (arguments.iter) {
-                printf("for %d iterations ", arguments.iter);
+        if (arguments.iter) {
+            printf("for %d iterations ", arguments.iter);
+        }
+
+        if (arguments.seconds) {
+            printf("for %d seconds ", arguments.seconds);
+        }
+        printf("\n\n");
+
+        alloc_mode_t alloc;
+        EXIT_ON_FAIL(alloc_mode_resolve(arguments.alloc, &alloc),
+                     "Error while choosing the allocator");
+
+        if (alloc == ALLOC_ARENA) {
+            EXIT_ON_FAIL(arena_new(&arena,
+                                   arena_estimate(&arguments, caches),
+                                   arguments.arena_page),
+                         "Error while mapping the hugepage arena");
+            // the geometries of the cores of a hybrid CPU may differ
+            for (uint32_t i = 0; i < arguments.cpu_count; i++) {
+                if (caches[i].level < LLC_MIN_LEVEL) {
+                    EXIT_ON_FAIL(arena_avoid(&arena, caches + i,
+                                             arguments.sets,
+                                             arguments.set_count),
+                                 "Error while marking the probed sets");
+                }
             }
+            plan_arena = &arena;
+            printf("Using %u hugepages of %lu KiB for the arena.\n",
+                   arena.page_count, arena.page_size / 1024);
+        }
 
-            if (arguments.seconds) {
-                printf("for %d seconds ", arguments.seconds);
+        for (uint32_t i = 0; i < arguments.cpu_count; i++) {
+            if (arguments.bind) {
+                // the buffer is touched on its own CPU core, so it is
+                // allocated on the local memory node
+                EXIT_ON_FAIL(
+                    focus_cpu_core(this_pid, arguments.cpus[i]),
+                    "Error while setting CPU affinity of this process");
             }
-            printf("\n\n");
 
-            EXIT_ON_FAIL(alloc_aligned(&buffer, &cache),
-                         "Failed to allocate an aligned buffer.");
+            if (alloc == ALLOC_EVSET) {
+                char path[PATH_MAX];
+                char *cache_file = arguments.evset_cache;
+                if (cache_file != NULL && arguments.cpu_count > 1) {
+                    snprintf(path, sizeof(path), "%s.cpu%u", cache_file,
+                             arguments.cpus[i]);
+                    cache_file = path;
+                }
+
+                printf("Searching the eviction sets for CPU %u by "
+                       "timing.\n",
+                       arguments.cpus[i]);
+                EXIT_ON_FAIL(evset_pool_new(evsets + i, caches + i,
+                                            arguments.sets,
+                                            arguments.set_count,
+                                            arguments.timer, cache_file),
+                             "Failed to find the eviction sets.");
+                printf("%s %u eviction sets in %.3lf s (%lu eviction "
+                       "tests, threshold %u cycles, %lu pages).\n",
+                       evsets[i].stats.cached ? "Loaded" : "Found",
+                       evsets[i].set_count,
+                       evsets[i].stats.duration_ns / 1e9,
+                       evsets[i].stats.tests, evsets[i].stats.threshold,
+                       evsets[i].pool_pages);
+
+                EXIT_ON_FAIL(probe_plan_from_lines(
+                                 plans + i, evsets[i].lines,
+                                 evsets[i].set_count,
+                                 evsets[i].way_count, arguments.ways,
+                                 arguments.way_count, arguments.order,
+                                 arguments.granularity, plan_arena),
+                             "Failed to build the probe plan.");
+            } else if (alloc == ALLOC_COLOR) {
+                uint32_t slices = 1;
+                if (caches[i].level >= LLC_MIN_LEVEL) {
+                    EXIT_ON_FAIL(
+                        topology_slice_count(&topology, caches + i, &slices),
+                        "Error while counting the cache slices");
+                }
+
+                EXIT_ON_FAIL(color_pool_new(colors + i, caches + i,
+                                            slices, arguments.sets,
+                                            arguments.set_count),
+                             "Failed to collect the pages by color.");
+                printf("Using %lu small pages for %u sets on CPU %u.\n",
+                       colors[i].page_count, colors[i].set_count,
+                       arguments.cpus[i]);
+
+                EXIT_ON_FAIL(probe_plan_from_lines(
+                                 plans + i, colors[i].lines,
+                                 colors[i].set_count,
+                                 colors[i].way_count, arguments.ways,
+                                 arguments.way_count, arguments.order,
+                                 arguments.granularity, plan_arena),
+                             "Failed to build the probe plan.");
+            } else if (alloc == ALLOC_ARENA &&
+                       caches[i].level < LLC_MIN_LEVEL) {
+                void *buffer;
+                EXIT_ON_FAIL(arena_alloc_cache(&arena, caches + i, &buffer),
+                             "Failed to carve the buffer out of the "
+                             "arena.");
 
-            if (arguments.pid) {
-                printf("Binding the given process(%d) to CPU %d.\n",
-                       arguments.pid, arguments.cpu);
+                EXIT_ON_FAIL(probe_plan_new(plans + i, caches + i, buffer,
+                                            arguments.sets,
+                                            arguments.set_count,
+                                            arguments.ways,
+                                            arguments.way_count,
+                                            arguments.order,
+                                            arguments.granularity,
+                                            plan_arena),
+                             "Failed to build the probe plan.");
+            } else if (caches[i].level >= LLC_MIN_LEVEL) {
+                uint32_t slices;
                 EXIT_ON_FAIL(
-                    focus_cpu_core(arguments.pid, arguments.cpu),
-                    "Error while setting CPU affinity of the given process");
-            } else if (arguments.program) {
-                printf("Starting external program.\n");
-                EXIT_ON_FAIL(run_program(arguments.program,
-                                         arguments.program_args, environ,
-                                         &(arguments.pid)),
-                             "Error while starting external program");
-                printf("Started external program with PID %d.\n",
-                       arguments.pid);
+                    topology_slice_count(&topology, caches + i, &slices),
+                    "Error while counting the cache slices");
+
+                printf("Building the eviction sets of %u slices for CPU "
+                       "%u.\n",
+                       slices, arguments.cpus[i]);
+                EXIT_ON_FAIL(llc_pool_new(pools + i, caches + i, slices,
+                                          arguments.sets,
+                                          arguments.set_count),
+                             "Failed to build the eviction sets.");
+                printf("Using %u hugepages for %u eviction sets.\n",
+                       pools[i].page_count, pools[i].set_count);
+
+                EXIT_ON_FAIL(probe_plan_from_lines(
+                                 plans + i, pools[i].lines,
+                                 pools[i].set_count, pools[i].way_count,
+                                 arguments.ways, arguments.way_count,
+                                 arguments.order, arguments.granularity,
+                                 plan_arena),
+                             "Failed to build the probe plan.");
+            } else {
+                EXIT_ON_FAIL(alloc_aligned(buffers + i, caches + i),
+                             "Failed to allocate an aligned buffer.");
+
+                EXIT_ON_FAIL(probe_plan_new(plans + i, caches + i,
+                                            buffers[i], arguments.sets,
+                                            arguments.set_count,
+                                            arguments.ways,
+                                            arguments.way_count,
+                                            arguments.order,
+                                            arguments.granularity,
+                                            plan_arena),
+                             "Failed to build the probe plan.");
+            }
+
+            cores[i].cpu = arguments.cpus[i];
+            cores[i].plan = plans + i;
+            cores[i].output = outputs + i;
+            cores[i].threshold = arguments.threshold;
+            cores[i].limit = 0;
+
+            calibration_t calibration;
+            int threshold = arguments.classify || arguments.aggregate;
+            if ((threshold || arguments.filter) &&
+                calibration_load(arguments.calibration_file, model,
+                                 arguments.cpus[i], arguments.timer,
+                                 &calibration) == ERROR_NONE) {
+                // the calibration holds the time of a single cache line
+                uint32_t lines = 1;
+                if (arguments.granularity == PLAN_GRANULARITY_SET) {
+                    lines = plans[i].way_count;
+                }
+
+                if (threshold && !arguments.threshold &&
+                    lines == 1 &&
+                    caches[i].level <= calibration.level_count) {
+                    cores[i].threshold =
+                        calibration.threshold[caches[i].level - 1];
+                    printf("Using the calibrated threshold of %u cycles on "
+                           "CPU %u.\n",
+                           cores[i].threshold, arguments.cpus[i]);
+                }
+                if (arguments.filter) {
+                    cores[i].limit = calibration.limit * lines;
+                }
+            } else if (arguments.filter) {
+                EXIT_ON_FAIL(ERROR_CALIBRATION,
+                             "The filter needs a calibration of every CPU "
+                             "core, run the calibrate mode first");
             }
 
-            if (arguments.seconds > 0) {
-                alarm(arguments.seconds);
+            if (arguments.cpu_count == 1) {
+                cores[i].output = &output;
+            } else if (arguments.output_file == NULL) {
+                char label[16];
+                snprintf(label, sizeof(label), "cpu %u: ",
+                         arguments.cpus[i]);
+                EXIT_ON_FAIL(outputc_stdout(outputs + i, stdout),
+                             "Error while creating output for stdout.");
+                output_set_label(outputs + i, label);
+                output_set_format(outputs + i, arguments.format);
+                output_set_cpu(outputs + i, arguments.cpus[i]);
+            } else if (output_is_cnv(arguments.output_file)) {
+                char path[PATH_MAX];
+                snprintf(path, sizeof(path), "%s.cpu%u",
+                         arguments.output_file, arguments.cpus[i]);
+                EXIT_ON_FAIL(outputc_cnv_file(outputs + i, path, caches + i,
+                                              arguments.timer,
+                                              arguments.cpus[i]),
+                             "Error while creating the .cnv file.");
+            } else {
+                char name[16];
+                snprintf(name, sizeof(name), "cpu%u", arguments.cpus[i]);
+                EXIT_ON_FAIL(outputc_hd5_group(outputs + i, &output, name),
+                             "Error while creating output group for "
+                             "HDF5.");
             }
 
+            EXIT_ON_FAIL(output_set_mask(cores[i].output, arguments.sets,
+                                         arguments.set_count, arguments.ways,
+                                         arguments.way_count),
+                         "Error while recording the probed sets and ways");
+        }
+
+        if (arguments.bind) {
             EXIT_ON_FAIL(
-                profile(&cache, arguments.cpu, arguments.iter, buffer, &output),
-                "Error while profiling");
-        } else {
-            fprintf(stderr, "Unknown operation mode %s.\n", arguments.mode);
-            goto FINALIZE;
+                focus_cpu_core(this_pid, arguments.cpus[0]),
+                "Error while setting CPU affinity of this process");
+        }
+
+        if (arguments.program && !arguments.pid) {
+            printf("Starting external program.\n");
+            EXIT_ON_FAIL(run_program(arguments.program,
+                                     arguments.program_args, environ,
+                                     &(arguments.pid)),
+                         "Error while starting external program");
+            printf("Started external program with PID %d.\n",
+                   arguments.pid);
         }
 
         if (arguments.pid) {
-            if (arguments.program) {
-                printf("Sending SIGKILL to external process with PID %d.\n",
-                       arguments.pid);
-                kill(arguments.pid, SIGKILL);
+            printf("Binding the process(%d) to CPU", arguments.pid);
+            for (uint32_t i = 0; i < workload_count; i++) {
+                printf(i ? ",%u" : " %u", workload[i]);
             }
+            printf(".\n");
+            EXIT_ON_FAIL(
+                focus_cpu_cores(arguments.pid, workload, workload_count),
+                "Error while setting CPU affinity of the given process");
         }
 
-        printf("Finished. Bye :)\n");
+        if (arguments.seconds > 0) {
+            alarm(arguments.seconds);
+        }
+
+        if (arguments.writer_cpu > -1) {
+            printf("Writing the output on CPU %d.\n", arguments.writer_cpu);
+        } else {
+            printf("WARNING: the output is not written on a separate CPU "
+                   "core.\n");
+        }
+
+        profile_config_t config;
+        config.bind = arguments.bind;
+        config.iterations = arguments.iter;
+        config.writer_cpu = arguments.writer_cpu;
+        config.ring_size = arguments.ring_size;
+        config.timer = arguments.timer;
+        config.arena = plan_arena;
+        config.classify = arguments.classify;
+        config.histograms = arguments.histograms;
+        config.aggregate = arguments.aggregate;
+        config.stats = arguments.stats;
+        config.fused = arguments.fused;
+        config.stats_interval = arguments.stats_interval;
+
+        EXIT_ON_FAIL(profile(cores, arguments.cpu_count, &config),
+                     "Error while profiling");
+
+        if (plan_arena != NULL) {
+            printf("Arena: %lu of %lu bytes used, %lu bytes padding "
+                   "(%.1lf%% fragmentation), %u allocations, %u on "
+                   "probed sets.\n",
+                   arena.stats.used, arena.stats.size,
+                   arena.stats.padding, 100 * arena_fragmentation(&arena),
+                   arena.stats.allocations, arena.stats.conflicts);
+        }
+    } else {
+        fprintf(stderr, "Unknown operation mode %s.\n", arguments.mode);
+        goto FINALIZE;
+    }
+
+    if (arguments.pid) {
+        if (arguments.program) {
+            printf("Sending SIGKILL to external process with PID %d.\n",
+                   arguments.pid);
+            kill(arguments.pid, SIGKILL);
+        }
     }
 
-FINALIZE:
-    output_close(&output);
+    printf("Finished. Bye :)\n");
+
+FINALIZE:;
     error_t error_code;
-    if (buffer != NULL && (error_code = free_aligned(buffer, &cache))) {
-        fprintf(stderr, "Error while freeing buffer, %s(%d) ",
+    for (uint32_t i = 0; plans != NULL && i < arguments.cpu_count; i++) {
+        probe_plan_free(plans + i);
+    }
+
+    arena_free(&arena);
+
+    // the groups have to be closed before the file
+    for (uint32_t i = 0; outputs != NULL && i < arguments.cpu_count; i++) {
+        if ((error_code = output_close(outputs + i))) {
+            fprintf(stderr, "Error while closing the output, %s(%d)\n",
+                    decode_error(error_code), error_code);
+        }
+    }
+    if ((error_code = output_close(&output))) {
+        fprintf(stderr, "Error while closing the output, %s(%d)\n",
                 decode_error(error_code), error_code);
-        if (errno) {
-            fprintf(stderr, ":%s(%d)", strerror(errno), errno);
+    }
+
+    for (uint32_t i = 0; pools != NULL && i < arguments.cpu_count; i++) {
+        llc_pool_free(pools + i);
+    }
+
+    for (uint32_t i = 0; evsets != NULL && i < arguments.cpu_count; i++) {
+        evset_pool_free(evsets + i);
+    }
+
+    for (uint32_t i = 0; colors != NULL && i < arguments.cpu_count; i++) {
+        color_pool_free(colors + i);
+    }
+
+    for (uint32_t i = 0; buffers != NULL && i < arguments.cpu_count; i++) {
+        if (buffers[i] != NULL &&
+            (error_code = free_aligned(buffers[i], caches + i))) {
+            fprintf(stderr, "Error while freeing buffer, %s(%d) ",
+                    decode_error(error_code), error_code);
+            if (errno) {
+                fprintf(stderr, ":%s(%d)", strerror(errno), errno);
+            }
+            fprintf(stderr, "\n");
         }
-        fprintf(stderr, "\n");
     }
 
+    free(workload);
+    free(calibrations);
+    topology_free(&topology);
+    free(cores);
+    free(outputs);
+    free(colors);
+    free(evsets);
+    free(pools);
+    free(plans);
+    free(buffers);
+    free(caches);
+    free(arguments.cpus);
+    free(arguments.sets);
+    free(arguments.ways);
+
     return EXIT_SUCCESS;
 }
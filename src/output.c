@@ -6,75 +6,1289 @@
  */
 
 #include "output.h"
+#include "classify.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// the .cnv records are written in the native byte order
+_Static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+               "the .cnv format is little endian");
+
+/**
+ * @brief Returns the size of one frame of an output in bytes.
+ *
+ * @param output Holds data about the output stream, with the shape of the
+ * frames
+ */
+static uintptr_t output_frame_size(const output_t *output) {
+    if (output->bits == 1) {
+        return classify_bitmap_size(output->dim_x * output->dim_y);
+    }
+    return sizeof(uint32_t) * output->dim_x * output->dim_y;
+}
+
+/**
+ * @brief Returns the dimensions of the frames dataset of a HDF5 output.
+ *
+ * @param output Holds data about the output stream, with the shape of the
+ * frames
+ * @param frames the first dimension (amount of frames)
+ * @param dims writes up to three dimensions into
+ *
+ * The last dimension is left out for vectors. A bitmap is one row of bytes.
+ *
+ * @return The rank of the dataset.
+ */
+static int hd5_frame_dims(const output_t *output, hsize_t frames,
+                          hsize_t *dims) {
+    dims[0] = frames;
+    if (output->bits == 1) {
+        dims[1] = output_frame_size(output);
+        return 2;
+    }
+
+    dims[1] = output->dim_y;
+    dims[2] = output->dim_x;
+    return output->rank + 1;
+}
+
+/**
+ * @brief Writes a scalar or one dimensional attribute of a dataset.
+ *
+ * @param dataset the dataset
+ * @param name name of the attribute
+ * @param type native type of the values
+ * @param values the values
+ * @param count amount of values, 0 for a scalar
+ *
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_NONE
+ */
+static error_t hd5_attribute(hid_t dataset, const char *name, hid_t type,
+                             const void *values, hsize_t count) {
+    hid_t space = count ? H5Screate_simple(1, &count, NULL)
+                        : H5Screate(H5S_SCALAR);
+    if (space == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    hid_t attribute =
+        H5Acreate(dataset, name, type, space, H5P_DEFAULT, H5P_DEFAULT);
+    herr_t status = attribute == -1 ? -1 : H5Awrite(attribute, type, values);
+
+    if (attribute != -1) {
+        H5Aclose(attribute);
+    }
+    H5Sclose(space);
+
+    return status < 0 ? ERROR_HDF5_ERROR : ERROR_NONE;
+}
+
+/**
+ * @brief Writes the unpacked shape and the threshold of a bitmaps dataset.
+ *
+ * @param output Holds data about the output stream
+ *
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_NONE
+ */
+static error_t hd5_bitmap_attributes(output_t *output) {
+    uint64_t shape[2] = {output->dim_y, output->dim_x};
+
+    FORWARD_ON_FAIL(hd5_attribute(output->frames, "shape", H5T_NATIVE_UINT64,
+                                  shape, output->rank));
+    return hd5_attribute(output->frames, "threshold", H5T_NATIVE_UINT32,
+                         &output->threshold, 0);
+}
+
+/**
+ * @brief Creates the extendible frames and clock datasets of a HDF5 output.
+ *
+ * @param output Holds data about the output stream
+ * @param rank 2 for matrices and 1 for vectors
+ * @param dim_x dimension of one frame (x-axis), 1 for vectors
+ * @param dim_y dimension of one frame (y-axis)
+ *
+ * The dataset has an unlimited first dimension and is chunked across as many
+ * frames as fit into OUTPUT_HD5_CHUNK_SIZE bytes. The values are stored in the
+ * native byte order, so no conversion is done while writing. The clock
+ * dataset holds one timestamp per frame and uses the same chunking.
+ *
+ * Bitmaps are stored in the dataset OUTPUT_HD5_BITMAPS instead, with their
+ * unpacked shape and threshold as attributes.
+ *
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t hd5_frames_create(output_t *output, uint8_t rank,
+                                 uintptr_t dim_x, uintptr_t dim_y) {
+    output->rank = rank;
+    output->dim_x = dim_x;
+    output->dim_y = dim_y;
+
+    uintptr_t frame_size = output_frame_size(output);
+    uintptr_t chunk_size = OUTPUT_HD5_CHUNK_SIZE / frame_size;
+    if (chunk_size < 1) {
+        chunk_size = 1;
+    }
+
+    output->chunk = malloc(frame_size * chunk_size);
+    output->chunk_clock = malloc(sizeof(uint64_t) * chunk_size);
+    if (output->chunk == NULL || output->chunk_clock == NULL) {
+        return ERROR_ALLOCATION;
+    }
+
+    hsize_t dims[3];
+    hsize_t max_dims[3];
+    hsize_t chunk_dims[3];
+    int dataset_rank = hd5_frame_dims(output, 0, dims);
+    hd5_frame_dims(output, H5S_UNLIMITED, max_dims);
+    hd5_frame_dims(output, chunk_size, chunk_dims);
+
+    hid_t dataspace_id = H5Screate_simple(dataset_rank, dims, max_dims);
+    if (dataspace_id == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    hid_t properties = H5Pcreate(H5P_DATASET_CREATE);
+    if (properties == -1 ||
+        H5Pset_chunk(properties, dataset_rank, chunk_dims) < 0) {
+        H5Sclose(dataspace_id);
+        return ERROR_HDF5_ERROR;
+    }
+
+    if (output->bits == 1) {
+        output->frames =
+            H5Dcreate(output->h5, OUTPUT_HD5_BITMAPS, H5T_NATIVE_UINT8,
+                      dataspace_id, H5P_DEFAULT, properties, H5P_DEFAULT);
+    } else {
+        output->frames =
+            H5Dcreate(output->h5, OUTPUT_HD5_FRAMES, H5T_NATIVE_UINT32,
+                      dataspace_id, H5P_DEFAULT, properties, H5P_DEFAULT);
+    }
+
+    H5Pclose(properties);
+    H5Sclose(dataspace_id);
+
+    if (output->frames == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    if (output->bits == 1) {
+        FORWARD_ON_FAIL(hd5_bitmap_attributes(output));
+    }
+
+    dataspace_id = H5Screate_simple(1, dims, max_dims);
+    if (dataspace_id == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    properties = H5Pcreate(H5P_DATASET_CREATE);
+    if (properties == -1 || H5Pset_chunk(properties, 1, chunk_dims) < 0) {
+        H5Sclose(dataspace_id);
+        return ERROR_HDF5_ERROR;
+    }
+
+    output->clock =
+        H5Dcreate(output->h5, OUTPUT_HD5_CLOCK, H5T_NATIVE_UINT64,
+                  dataspace_id, H5P_DEFAULT, properties, H5P_DEFAULT);
+
+    H5Pclose(properties);
+    H5Sclose(dataspace_id);
+
+    if (output->clock == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    output->chunk_size = chunk_size;
+    output->chunk_fill = 0;
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Appends the timestamps of all buffered frames to the clock dataset.
+ *
+ * @param output Holds data about the output stream
+ *
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_NONE
+ */
+static error_t hd5_clock_flush(output_t *output) {
+    hsize_t start = output->iter;
+    hsize_t count = output->chunk_fill;
+    hsize_t dims = output->iter + output->chunk_fill;
+
+    if (H5Dset_extent(output->clock, &dims) < 0) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    hid_t file_space = H5Dget_space(output->clock);
+    if (file_space == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    hid_t memory_space = H5Screate_simple(1, &count, NULL);
+    if (memory_space == -1) {
+        H5Sclose(file_space);
+        return ERROR_HDF5_ERROR;
+    }
+
+    herr_t status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, &start,
+                                        NULL, &count, NULL);
+
+    if (status >= 0) {
+        status = H5Dwrite(output->clock, H5T_NATIVE_UINT64, memory_space,
+                          file_space, H5P_DEFAULT, output->chunk_clock);
+    }
+
+    H5Sclose(memory_space);
+    H5Sclose(file_space);
+
+    if (status < 0) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Appends all buffered frames to the frames dataset.
+ *
+ * @param output Holds data about the output stream
+ *
+ * Extends the datasets by the amount of buffered frames and writes the frames
+ * and their timestamps with one hyperslab write each.
+ *
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_NONE
+ */
+static error_t hd5_frames_flush(output_t *output) {
+    if (output->chunk_fill == 0) {
+        return ERROR_NONE;
+    }
+
+    hsize_t start[3] = {output->iter, 0, 0};
+    hsize_t count[3];
+    hsize_t dims[3];
+    int dataset_rank = hd5_frame_dims(output, output->chunk_fill, count);
+    hd5_frame_dims(output, output->iter + output->chunk_fill, dims);
+
+    if (H5Dset_extent(output->frames, dims) < 0) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    hid_t file_space = H5Dget_space(output->frames);
+    if (file_space == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    hid_t memory_space = H5Screate_simple(dataset_rank, count, NULL);
+    if (memory_space == -1) {
+        H5Sclose(file_space);
+        return ERROR_HDF5_ERROR;
+    }
+
+    herr_t status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start,
+                                        NULL, count, NULL);
+
+    if (status >= 0) {
+        status = H5Dwrite(output->frames,
+                          output->bits == 1 ? H5T_NATIVE_UINT8
+                                            : H5T_NATIVE_UINT32,
+                          memory_space, file_space, H5P_DEFAULT,
+                          output->chunk);
+    }
+
+    H5Sclose(memory_space);
+    H5Sclose(file_space);
+
+    if (status < 0) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    FORWARD_ON_FAIL(hd5_clock_flush(output));
+
+    output->iter += output->chunk_fill;
+    output->chunk_fill = 0;
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief The decimal digits of all numbers below 100.
+ */
+static const char digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/**
+ * @brief Writes the decimal digits of a number.
+ *
+ * @param text the position in the text buffer
+ * @param value the number
+ *
+ * @return The position behind the last digit.
+ */
+static char *text_uint(char *text, uint64_t value) {
+    char digits[20];
+    char *end = digits + sizeof(digits);
+    char *start = end;
+
+    while (value >= 100) {
+        start -= 2;
+        memcpy(start, digit_pairs + 2 * (value % 100), 2);
+        value /= 100;
+    }
+    if (value >= 10) {
+        start -= 2;
+        memcpy(start, digit_pairs + 2 * value, 2);
+    } else {
+        *--start = '0' + value;
+    }
+
+    memcpy(text, start, end - start);
+    return text + (end - start);
+}
+
+/**
+ * @brief Writes a possibly negative number.
+ */
+static char *text_int(char *text, int64_t value) {
+    if (value < 0) {
+        *text++ = '-';
+        return text_uint(text, -(uint64_t)value);
+    }
+    return text_uint(text, value);
+}
+
+/**
+ * @brief Appends a string without the terminating zero.
+ */
+static char *text_str(char *text, const char *str) {
+    size_t length = strlen(str);
+    memcpy(text, str, length);
+    return text + length;
+}
+
+/**
+ * @brief Writes the text buffer of a stream output.
+ *
+ * @param output Holds data about the output stream
+ *
+ * @retval ERROR_IO
+ * @retval ERROR_NONE
+ */
+static error_t text_flush(output_t *output) {
+    if (!output->text_fill) {
+        return ERROR_NONE;
+    }
+
+    // the stream may still hold text which was printed before
+    if (fflush(output->std)) {
+        return ERROR_IO;
+    }
+
+    int fd = fileno(output->std);
+    const char *text = output->text;
+    uintptr_t length = output->text_fill;
+    output->text_fill = 0;
+
+    while (length) {
+        ssize_t written = write(fd, text, length);
+        if (written <= 0) {
+            return ERROR_IO;
+        }
+        text += written;
+        length -= written;
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Returns the id of the set of a row, see output_set_mask.
+ *
+ * @param output Holds data about the output stream
+ * @param row index of the row in the frame
+ */
+static uint64_t text_set_id(const output_t *output, uintptr_t row) {
+    return output->sets != NULL ? output->sets[row] : row;
+}
+
+/**
+ * @brief Formats a single frame into the text buffer of a stream output.
+ *
+ * @param output Holds data about the output stream
+ * @param data the frame, a bitmap if output_t#bits is 1
+ * @param clock timestamp counter at the start of the frame
+ * @param rank 2 for matrices and 1 for vectors
+ * @param dim_x dimension (x-axis), 1 for vectors
+ * @param dim_y dimension (y-axis)
+ *
+ * The buffer is written first if the frame may not fit into it. The bits of
+ * a bitmap are printed as 0 and 1.
+ *
+ * @retval ERROR_IO
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t text_frame(output_t *output, const void *data, uint64_t clock,
+                          uint8_t rank, uintptr_t dim_x, uintptr_t dim_y) {
+    // a value has at most 10 digits and a separator, a row has at most 64
+    // other characters (label, cpu, clock and set)
+    uintptr_t bound = 64 + dim_y * (64 + 11 * dim_x);
+
+    if (output->text_size - output->text_fill < bound) {
+        FORWARD_ON_FAIL(text_flush(output));
+    }
+    if (output->text_size < bound) {
+        uintptr_t size =
+            bound > OUTPUT_TEXT_BUFFER ? bound : OUTPUT_TEXT_BUFFER;
+        char *text = realloc(output->text, size);
+        if (text == NULL) {
+            return ERROR_ALLOCATION;
+        }
+        output->text = text;
+        output->text_size = size;
+    }
+
+    char *pos = output->text + output->text_fill;
+
+    if (output->format == OUTPUT_FORMAT_NDJSON) {
+        pos = text_str(pos, "{\"cpu\":");
+        pos = text_int(pos, output->cpu);
+        pos = text_str(pos, ",\"clock\":");
+        pos = text_uint(pos, clock);
+        pos = text_str(pos, ",\"frame\":[");
+    }
+
+    for (uintptr_t set = 0; set < dim_y; set++) {
+        if (output->format == OUTPUT_FORMAT_NDJSON) {
+            if (set) {
+                *pos++ = ',';
+            }
+            if (rank == 2) {
+                *pos++ = '[';
+            }
+        } else if (output->format == OUTPUT_FORMAT_CSV) {
+            pos = text_int(pos, output->cpu);
+            *pos++ = ',';
+            pos = text_uint(pos, clock);
+            *pos++ = ',';
+            pos = text_uint(pos, text_set_id(output, set));
+            *pos++ = ',';
+        } else {
+            pos = text_str(pos, output->label);
+            pos = text_str(pos, "set ");
+            pos = text_uint(pos, text_set_id(output, set));
+            pos = text_str(pos, ": ");
+        }
+
+        if (output->bits == 1) {
+            const uint8_t *bitmap = data;
+            for (uintptr_t i = set * dim_x; i < (set + 1) * dim_x; i++) {
+                *pos++ = '0' + (bitmap[i / 8] >> (i % 8) & 1);
+                *pos++ = ',';
+            }
+            pos--;
+        } else {
+            const uint32_t *row = (const uint32_t *)data + set * dim_x;
+            pos = text_uint(pos, row[0]);
+            for (uintptr_t way = 1; way < dim_x; way++) {
+                *pos++ = ',';
+                pos = text_uint(pos, row[way]);
+            }
+        }
+
+        if (output->format != OUTPUT_FORMAT_NDJSON) {
+            *pos++ = '\n';
+        } else if (rank == 2) {
+            *pos++ = ']';
+        }
+    }
+
+    if (output->format == OUTPUT_FORMAT_NDJSON) {
+        pos = text_str(pos, "]}\n");
+    }
+
+    output->text_fill = pos - output->text;
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Writes the header of a .cnv file.
+ *
+ * @param output Holds data about the output stream
+ *
+ * @retval ERROR_IO_CNV
+ * @retval ERROR_NONE
+ */
+static error_t cnv_header_write(output_t *output) {
+    // a copy, since gcc confuses the header with its first member magic
+    cnv_header_t header = output->cnv;
+    if (pwrite(output->fd, &header, sizeof(cnv_header_t), 0) !=
+        sizeof(cnv_header_t)) {
+        return ERROR_IO_CNV;
+    }
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Writes a whole vector of buffers, also if pwritev writes less.
+ *
+ * @param fd the file
+ * @param iov the buffers, which are changed while writing
+ * @param count amount of buffers
+ * @param offset offset in the file
+ *
+ * @retval ERROR_IO_CNV
+ * @retval ERROR_NONE
+ */
+static error_t cnv_pwritev(int fd, struct iovec *iov, int count,
+                           off_t offset) {
+    while (count) {
+        ssize_t written = pwritev(fd, iov, count, offset);
+        if (written <= 0) {
+            return ERROR_IO_CNV;
+        }
+        offset += written;
+
+        while (count && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count) {
+            iov->iov_base = (uint8_t *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Appends frames to a .cnv file.
+ *
+ * @param output Holds data about the output stream
+ * @param data count frames, or bitmaps if output_t#bits is 1
+ * @param clock timestamp counter at the start of every frame or NULL
+ * @param count amount of frames
+ * @param rank 2 for matrices and 1 for vectors
+ * @param dim_x dimension (x-axis), 1 for vectors
+ * @param dim_y dimension (y-axis)
+ *
+ * The timestamps and frames are written straight from the ring, a record is
+ * two entries of the io vector.
+ *
+ * @retval ERROR_IO_CNV
+ * @retval ERROR_FRAME_SHAPE
+ * @retval ERROR_NONE
+ */
+static error_t cnv_frames_write(output_t *output, const void *data,
+                                uint64_t *clock, uintptr_t count,
+                                uint8_t rank, uintptr_t dim_x,
+                                uintptr_t dim_y) {
+    static uint64_t zero = 0;
+
+    if (!output->cnv.rank) {
+        output->rank = rank;
+        output->dim_x = dim_x;
+        output->dim_y = dim_y;
+        output->cnv.rank = rank;
+        output->cnv.dim_x = dim_x;
+        output->cnv.dim_y = dim_y;
+        output->cnv.bits = output->bits;
+        output->cnv.threshold = output->threshold;
+        output->cnv.record_size = sizeof(uint64_t) + output_frame_size(output);
+        FORWARD_ON_FAIL(cnv_header_write(output));
+    } else if (output->cnv.rank != rank || output->cnv.dim_x != dim_x ||
+               output->cnv.dim_y != dim_y) {
+        return ERROR_FRAME_SHAPE;
+    }
+
+    uintptr_t frame_size = output->cnv.record_size - sizeof(uint64_t);
+    struct iovec iov[2 * OUTPUT_CNV_BATCH];
+    for (uintptr_t first = 0; first < count; first += OUTPUT_CNV_BATCH) {
+        uintptr_t batch = count - first < OUTPUT_CNV_BATCH ? count - first
+                                                           : OUTPUT_CNV_BATCH;
+
+        for (uintptr_t i = 0; i < batch; i++) {
+            iov[2 * i].iov_base = clock ? clock + first + i : &zero;
+            iov[2 * i].iov_len = sizeof(uint64_t);
+            iov[2 * i + 1].iov_base =
+                (uint8_t *)data + (first + i) * frame_size;
+            iov[2 * i + 1].iov_len = frame_size;
+        }
+
+        FORWARD_ON_FAIL(cnv_pwritev(
+            output->fd, iov, 2 * batch,
+            output->cnv.header_size +
+                output->cnv.frame_count * output->cnv.record_size));
+        output->cnv.frame_count += batch;
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Writes a single frame to the output.
+ *
+ * @param output Holds data about the output stream
+ * @param data the frame, a bitmap if output_t#bits is 1
+ * @param clock timestamp counter at the start of the frame
+ * @param rank 2 for matrices and 1 for vectors
+ * @param dim_x dimension (x-axis), 1 for vectors
+ * @param dim_y dimension (y-axis)
+ *
+ * Frames of a stream are only formatted, see text_flush.
+ *
+ * @retval ERROR_IO
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_FRAME_SHAPE
+ * @retval ERROR_NOT_SUPPORTED_OUTPUT
+ * @retval ERROR_NONE
+ */
+static error_t output_frame(output_t *output, const void *data,
+                            uint64_t clock, uint8_t rank, uintptr_t dim_x,
+                            uintptr_t dim_y) {
+    if (output->type == OUTPUT_STDOUT) {
+        FORWARD_ON_FAIL(text_frame(output, data, clock, rank, dim_x, dim_y));
+    } else if (output->type == OUTPUT_CNV_FILE) {
+        FORWARD_ON_FAIL(
+            cnv_frames_write(output, data, &clock, 1, rank, dim_x, dim_y));
+    } else if (output->type == OUTPUT_HD5_FILE) {
+        if (output->frames == -1) {
+            FORWARD_ON_FAIL(hd5_frames_create(output, rank, dim_x, dim_y));
+        } else if (output->rank != rank || output->dim_x != dim_x ||
+                   output->dim_y != dim_y) {
+            return ERROR_FRAME_SHAPE;
+        }
+
+        uintptr_t frame_size = output_frame_size(output);
+        memcpy(output->chunk + output->chunk_fill * frame_size, data,
+               frame_size);
+        output->chunk_clock[output->chunk_fill] = clock;
+        output->chunk_fill++;
+
+        if (output->chunk_fill == output->chunk_size) {
+            FORWARD_ON_FAIL(hd5_frames_flush(output));
+        }
+    } else {
+        return ERROR_NOT_SUPPORTED_OUTPUT;
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Records whether an output holds values or bitmaps.
+ *
+ * @param output Holds data about the output stream
+ * @param bits 32 for values and 1 for bitmaps
+ * @param threshold threshold of the bitmaps
+ *
+ * @retval ERROR_FRAME_SHAPE if the output already holds other frames
+ * @retval ERROR_NONE
+ */
+static error_t output_values(output_t *output, uint8_t bits,
+                             uint32_t threshold) {
+    if (!output->bits) {
+        output->bits = bits;
+        output->threshold = threshold;
+    } else if (output->bits != bits || output->threshold != threshold) {
+        return ERROR_FRAME_SHAPE;
+    }
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Writes the formatted frames of a stream at the end of a call.
+ *
+ * @param output Holds data about the output stream
+ * @param err the result of formatting the frames
+ *
+ * @return @p err or the error of text_flush.
+ */
+static error_t output_finish(output_t *output, error_t err) {
+    if (output->type == OUTPUT_STDOUT) {
+        error_t flush_err = text_flush(output);
+        if (err == ERROR_NONE) {
+            err = flush_err;
+        }
+    }
+    return err;
+}
 
 error_t outputw_mat_ui32(output_t *output, uint32_t *data, uintptr_t dim_x,
                          uintptr_t dim_y) {
-    if (output->type == OUTPUT_STDOUT) {
-        for (uintptr_t set = 0; set < dim_y; set++) {
-            if (fprintf(output->std, "set %lu: ", set) < 0) {
-                return ERROR_IO_HDF;
-            }
+    FORWARD_ON_FAIL(output_values(output, 32, 0));
+    return output_finish(output,
+                         output_frame(output, data, 0, 2, dim_x, dim_y));
+}
+
+error_t outputw_mats_ui32(output_t *output, uint32_t *data, uint64_t *clock,
+                          uintptr_t count, uintptr_t dim_x, uintptr_t dim_y) {
+    FORWARD_ON_FAIL(output_values(output, 32, 0));
+    if (output->type == OUTPUT_CNV_FILE) {
+        return cnv_frames_write(output, data, clock, count, 2, dim_x, dim_y);
+    }
+
+    error_t err = ERROR_NONE;
+    for (uintptr_t i = 0; i < count && err == ERROR_NONE; i++) {
+        err = output_frame(output, data + i * dim_x * dim_y,
+                           clock ? clock[i] : 0, 2, dim_x, dim_y);
+    }
+
+    return output_finish(output, err);
+}
+
+error_t outputw_vec_ui32(output_t *output, uint32_t *data, uintptr_t dim) {
+    FORWARD_ON_FAIL(output_values(output, 32, 0));
+    return output_finish(output, output_frame(output, data, 0, 1, 1, dim));
+}
+
+error_t outputw_vecs_ui32(output_t *output, uint32_t *data, uint64_t *clock,
+                          uintptr_t count, uintptr_t dim) {
+    FORWARD_ON_FAIL(output_values(output, 32, 0));
+    if (output->type == OUTPUT_CNV_FILE) {
+        return cnv_frames_write(output, data, clock, count, 1, 1, dim);
+    }
+
+    error_t err = ERROR_NONE;
+    for (uintptr_t i = 0; i < count && err == ERROR_NONE; i++) {
+        err = output_frame(output, data + i * dim, clock ? clock[i] : 0, 1, 1,
+                           dim);
+    }
+
+    return output_finish(output, err);
+}
+
+/**
+ * @brief Writes consecutive bitmaps to an output.
+ *
+ * @see outputw_mats_bits
+ */
+static error_t output_bitmaps(output_t *output, uint8_t *bitmaps,
+                              uint64_t *clock, uintptr_t count, uint8_t rank,
+                              uintptr_t dim_x, uintptr_t dim_y,
+                              uint32_t threshold) {
+    FORWARD_ON_FAIL(output_values(output, 1, threshold));
 
-            if (fprintf(output->std, "%u", data[set * dim_x]) < 0) {
-                return ERROR_IO_HDF;
-            }
+    if (output->type == OUTPUT_CNV_FILE) {
+        return cnv_frames_write(output, bitmaps, clock, count, rank, dim_x,
+                                dim_y);
+    }
 
-            for (uintptr_t way = 1; way < dim_x; way++) {
-                if (fprintf(output->std, ",%u", data[set * dim_x + way]) < 0) {
-                    return ERROR_IO_HDF;
-                }
-            }
+    uintptr_t frame_size = classify_bitmap_size(dim_x * dim_y);
+    error_t err = ERROR_NONE;
+    for (uintptr_t i = 0; i < count && err == ERROR_NONE; i++) {
+        err = output_frame(output, bitmaps + i * frame_size,
+                           clock ? clock[i] : 0, rank, dim_x, dim_y);
+    }
+
+    return output_finish(output, err);
+}
+
+error_t outputw_mats_bits(output_t *output, uint8_t *bitmaps, uint64_t *clock,
+                          uintptr_t count, uintptr_t dim_x, uintptr_t dim_y,
+                          uint32_t threshold) {
+    return output_bitmaps(output, bitmaps, clock, count, 2, dim_x, dim_y,
+                          threshold);
+}
+
+error_t outputw_vecs_bits(output_t *output, uint8_t *bitmaps, uint64_t *clock,
+                          uintptr_t count, uintptr_t dim, uint32_t threshold) {
+    return output_bitmaps(output, bitmaps, clock, count, 1, 1, dim,
+                          threshold);
+}
+
+/**
+ * @brief Fills the summary of one set.
+ *
+ * @param histogram the histogram of the set
+ * @param row writes the OUTPUT_SUMMARY_COLUMNS into
+ */
+static void summary_row(const stats_t *histogram, double *row) {
+    static const double fractions[] = {0.5, 0.9, 0.99, 0.999};
+
+    row[0] = histogram->count;
+    row[1] = histogram->mean;
+    row[2] = stats_variance(histogram);
+    row[3] = histogram->min;
+    row[4] = histogram->max;
+    for (int i = 0; i < 4; i++) {
+        uint32_t value = stats_percentile(histogram, fractions[i]);
+        row[5 + i] = value == STATS_OVERFLOW ? INFINITY : value;
+    }
+}
+
+/**
+ * @brief Writes a complete two dimensional dataset.
+ *
+ * @param h5 the file or group of the dataset
+ * @param name name of the dataset
+ * @param type native type of the values
+ * @param rows amount of rows
+ * @param columns amount of columns
+ * @param values rows * columns values
+ *
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_NONE
+ */
+static error_t hd5_matrix(hid_t h5, const char *name, hid_t type,
+                          hsize_t rows, hsize_t columns, const void *values) {
+    hsize_t dims[2] = {rows, columns};
+    hid_t space = H5Screate_simple(2, dims, NULL);
+    if (space == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    hid_t dataset =
+        H5Dcreate(h5, name, type, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    herr_t status = dataset == -1 ? -1
+                                  : H5Dwrite(dataset, type, H5S_ALL, H5S_ALL,
+                                             H5P_DEFAULT, values);
+
+    if (dataset != -1) {
+        H5Dclose(dataset);
+    }
+    H5Sclose(space);
+
+    return status < 0 ? ERROR_HDF5_ERROR : ERROR_NONE;
+}
+
+/**
+ * @brief Writes the histograms and summaries of all sets to a HDF5 output.
+ *
+ * @see outputw_histograms
+ */
+static error_t hd5_histograms(output_t *output, const stats_t *histograms,
+                              uintptr_t count) {
+    uintptr_t columns = histograms[0].bins + 1;
+    uint64_t *counts = malloc(sizeof(uint64_t) * count * columns);
+    double *summary = malloc(sizeof(double) * count * OUTPUT_SUMMARY_COLUMNS);
+    if (counts == NULL || summary == NULL) {
+        free(counts);
+        free(summary);
+        return ERROR_ALLOCATION;
+    }
+
+    for (uintptr_t set = 0; set < count; set++) {
+        uint64_t *row = counts + set * columns;
+        memcpy(row, histograms[set].histogram,
+               sizeof(uint64_t) * histograms[set].bins);
+        row[columns - 1] = histograms[set].overflow;
+        summary_row(histograms + set, summary + set * OUTPUT_SUMMARY_COLUMNS);
+    }
+
+    error_t err = hd5_matrix(output->h5, OUTPUT_HD5_HISTOGRAMS,
+                             H5T_NATIVE_UINT64, count, columns, counts);
+    if (err == ERROR_NONE) {
+        err = hd5_matrix(output->h5, OUTPUT_HD5_SUMMARY, H5T_NATIVE_DOUBLE,
+                         count, OUTPUT_SUMMARY_COLUMNS, summary);
+    }
+
+    free(counts);
+    free(summary);
+    return err;
+}
+
+/**
+ * @brief Prints the summaries of all sets to a stream output.
+ *
+ * @see outputw_histograms
+ */
+static error_t text_histograms(output_t *output, const stats_t *histograms,
+                               uintptr_t count) {
+    static const char *names[OUTPUT_SUMMARY_COLUMNS] = {
+        "count", "mean", "variance", "min", "max",
+        "p50",   "p90",  "p99",      "p99.9"};
+
+    // the formatted frames are written before
+    FORWARD_ON_FAIL(text_flush(output));
+
+    for (uintptr_t set = 0; set < count; set++) {
+        double row[OUTPUT_SUMMARY_COLUMNS];
+        summary_row(histograms + set, row);
+
+        if (output->format == OUTPUT_FORMAT_NDJSON) {
+            fprintf(output->std, "{\"cpu\":%d,\"set\":%lu", output->cpu,
+                    text_set_id(output, set));
+        } else if (output->format == OUTPUT_FORMAT_CSV) {
+            fprintf(output->std, "%d,%lu", output->cpu,
+                    text_set_id(output, set));
+        } else {
+            fprintf(output->std, "%sset %lu:", output->label,
+                    text_set_id(output, set));
+        }
 
-            if (fprintf(output->std, "\n") < 0) {
-                return ERROR_IO_HDF;
+        for (int i = 0; i < OUTPUT_SUMMARY_COLUMNS; i++) {
+            int overflow = isinf(row[i]);
+            if (output->format == OUTPUT_FORMAT_NDJSON) {
+                fprintf(output->std, overflow ? ",\"%s\":null" : ",\"%s\":%g",
+                        names[i], row[i]);
+            } else if (output->format == OUTPUT_FORMAT_CSV) {
+                fprintf(output->std, overflow ? "," : ",%g", row[i]);
+            } else if (overflow) {
+                fprintf(output->std, "%s %s >%u", i ? "," : "", names[i],
+                        histograms[set].bins - 1);
+            } else {
+                fprintf(output->std, "%s %s %g", i ? "," : "", names[i],
+                        row[i]);
             }
         }
 
+        fputs(output->format == OUTPUT_FORMAT_NDJSON ? "}\n" : "\n",
+              output->std);
+    }
+
+    return fflush(output->std) ? ERROR_IO : ERROR_NONE;
+}
+
+error_t outputw_histograms(output_t *output, const stats_t *histograms,
+                           uintptr_t count) {
+    if (!count) {
+        return ERROR_NONE;
+    }
+
+    if (output->type == OUTPUT_STDOUT) {
+        return text_histograms(output, histograms, count);
     } else if (output->type == OUTPUT_HD5_FILE) {
-        hid_t dataset_id, dataspace_id;
-        herr_t status;
-        hsize_t dims[2];
+        return hd5_histograms(output, histograms, count);
+    }
+    return ERROR_NOT_SUPPORTED_OUTPUT;
+}
+
+/**
+ * @brief Appends records to an extendible dataset of a group.
+ *
+ * @param group the group of the dataset
+ * @param name name of the dataset, which is created on the first record
+ * @param type native type of the values
+ * @param rank rank of one record, 0 for scalars
+ * @param shape dimensions of one record
+ * @param count amount of records
+ * @param records the values of the records
+ *
+ * Records with values are chunked one by one, scalars by
+ * OUTPUT_HD5_RECORD_CHUNK.
+ *
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_NONE
+ */
+static error_t hd5_append(hid_t group, const char *name, hid_t type,
+                          int rank, const hsize_t *shape, uintptr_t count,
+                          const void *records) {
+    hsize_t dims[3] = {0};
+    hsize_t max_dims[3] = {H5S_UNLIMITED};
+    hsize_t chunk_dims[3] = {rank ? 1 : OUTPUT_HD5_RECORD_CHUNK};
+    for (int i = 0; i < rank; i++) {
+        dims[i + 1] = max_dims[i + 1] = chunk_dims[i + 1] = shape[i];
+    }
 
-        dims[0] = dim_y;
-        dims[1] = dim_x;
+    hid_t dataset;
+    if (H5Lexists(group, name, H5P_DEFAULT) > 0) {
+        dataset = H5Dopen(group, name, H5P_DEFAULT);
+    } else {
+        hid_t space = H5Screate_simple(rank + 1, dims, max_dims);
+        hid_t properties = H5Pcreate(H5P_DATASET_CREATE);
+        dataset = -1;
+        if (space != -1 && properties != -1 &&
+            H5Pset_chunk(properties, rank + 1, chunk_dims) >= 0) {
+            dataset = H5Dcreate(group, name, type, space, H5P_DEFAULT,
+                                properties, H5P_DEFAULT);
+        }
+        if (properties != -1) {
+            H5Pclose(properties);
+        }
+        if (space != -1) {
+            H5Sclose(space);
+        }
+    }
+    if (dataset == -1) {
+        return ERROR_HDF5_ERROR;
+    }
 
-        dataspace_id = H5Screate_simple(2, dims, NULL);
+    hid_t file_space = H5Dget_space(dataset);
+    herr_t status = file_space == -1 ? -1
+                                     : H5Sget_simple_extent_dims(file_space,
+                                                                 dims, NULL);
+    if (file_space != -1) {
+        H5Sclose(file_space);
+    }
 
-        char id[256];
+    // the records go behind the last one
+    hsize_t start[3] = {dims[0]};
+    hsize_t memory_dims[3] = {count};
+    for (int i = 0; i < rank; i++) {
+        memory_dims[i + 1] = shape[i];
+    }
+    dims[0] += count;
 
-        sprintf(id, "%lu", output->iter++);
+    file_space = -1;
+    if (status >= 0 && H5Dset_extent(dataset, dims) >= 0) {
+        file_space = H5Dget_space(dataset);
+    }
+    hid_t memory_space = H5Screate_simple(rank + 1, memory_dims, NULL);
 
-        dataset_id = H5Dcreate(output->h5, id, H5T_STD_U32BE, dataspace_id,
-                               H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    status = file_space == -1 || memory_space == -1 ? -1 : 0;
+    if (status >= 0) {
+        status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL,
+                                     memory_dims, NULL);
+    }
+    if (status >= 0) {
+        status = H5Dwrite(dataset, type, memory_space, file_space,
+                          H5P_DEFAULT, records);
+    }
 
-        if (dataset_id == -1) {
-            return ERROR_HDF5_ERROR;
+    if (memory_space != -1) {
+        H5Sclose(memory_space);
+    }
+    if (file_space != -1) {
+        H5Sclose(file_space);
+    }
+    H5Dclose(dataset);
+
+    return status < 0 ? ERROR_HDF5_ERROR : ERROR_NONE;
+}
+
+error_t outputw_timing(output_t *output, const frame_timing_t *timing,
+                       uintptr_t count) {
+    if (output->type != OUTPUT_HD5_FILE || !count) {
+        return ERROR_NONE;
+    }
+
+    hid_t type = H5Tcreate(H5T_COMPOUND, sizeof(frame_timing_t));
+    if (type == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+    herr_t status = 0;
+    status |= H5Tinsert(type, "tsc_start", HOFFSET(frame_timing_t, tsc_start),
+                        H5T_NATIVE_UINT64);
+    status |= H5Tinsert(type, "tsc_end", HOFFSET(frame_timing_t, tsc_end),
+                        H5T_NATIVE_UINT64);
+    status |= H5Tinsert(type, "monotonic_start",
+                        HOFFSET(frame_timing_t, monotonic_start),
+                        H5T_NATIVE_UINT64);
+    status |= H5Tinsert(type, "monotonic_end",
+                        HOFFSET(frame_timing_t, monotonic_end),
+                        H5T_NATIVE_UINT64);
+    status |= H5Tinsert(type, "prime", HOFFSET(frame_timing_t, prime),
+                        H5T_NATIVE_UINT32);
+    status |= H5Tinsert(type, "yield", HOFFSET(frame_timing_t, yield),
+                        H5T_NATIVE_UINT32);
+    status |= H5Tinsert(type, "probe", HOFFSET(frame_timing_t, probe),
+                        H5T_NATIVE_UINT32);
+
+    error_t err = ERROR_HDF5_ERROR;
+    if (status >= 0) {
+        err = hd5_append(output->h5, OUTPUT_HD5_TIMING, type, 0, NULL, count,
+                         timing);
+    }
+    H5Tclose(type);
+    return err;
+}
+
+/**
+ * @brief Appends a window to the group OUTPUT_HD5_WINDOWS of a HDF5 output.
+ *
+ * @see outputw_window
+ */
+static error_t hd5_window(output_t *output, const aggregate_t *aggregate,
+                          uint8_t rank, uintptr_t dim_x, uintptr_t dim_y,
+                          uint32_t threshold) {
+    uintptr_t length = aggregate->length;
+    float *mean = malloc(sizeof(float) * length);
+    float *miss_rate = malloc(sizeof(float) * length);
+    if (mean == NULL || miss_rate == NULL) {
+        free(mean);
+        free(miss_rate);
+        return ERROR_ALLOCATION;
+    }
+    for (uintptr_t i = 0; i < length; i++) {
+        mean[i] = (double)aggregate->sum[i] / aggregate->frames;
+        miss_rate[i] = (double)aggregate->misses[i] / aggregate->frames;
+    }
+
+    hid_t group;
+    int created = H5Lexists(output->h5, OUTPUT_HD5_WINDOWS, H5P_DEFAULT) <= 0;
+    if (created) {
+        group = H5Gcreate(output->h5, OUTPUT_HD5_WINDOWS, H5P_DEFAULT,
+                          H5P_DEFAULT, H5P_DEFAULT);
+    } else {
+        group = H5Gopen(output->h5, OUTPUT_HD5_WINDOWS, H5P_DEFAULT);
+    }
+
+    error_t err = group == -1 ? ERROR_HDF5_ERROR : ERROR_NONE;
+    if (err == ERROR_NONE && created) {
+        err = hd5_attribute(group, "window", H5T_NATIVE_UINT32,
+                            &aggregate->window, 0);
+        if (err == ERROR_NONE) {
+            err = hd5_attribute(group, "threshold", H5T_NATIVE_UINT32,
+                                &threshold, 0);
         }
+    }
+
+    hsize_t shape[2] = {dim_y, dim_x};
+    if (err == ERROR_NONE) {
+        err = hd5_append(group, "mean", H5T_NATIVE_FLOAT, rank, shape, 1,
+                         mean);
+    }
+    if (err == ERROR_NONE) {
+        err = hd5_append(group, "max", H5T_NATIVE_UINT32, rank, shape, 1,
+                         aggregate->max);
+    }
+    if (err == ERROR_NONE) {
+        err = hd5_append(group, "miss_rate", H5T_NATIVE_FLOAT, rank, shape, 1,
+                         miss_rate);
+    }
+    if (err == ERROR_NONE) {
+        err = hd5_append(group, "clock", H5T_NATIVE_UINT64, 0, NULL, 1,
+                         &aggregate->clock);
+    }
+    if (err == ERROR_NONE) {
+        err = hd5_append(group, "frames", H5T_NATIVE_UINT32, 0, NULL, 1,
+                         &aggregate->frames);
+    }
 
-        status = H5Dwrite(dataset_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL,
-                          H5P_DEFAULT, data);
+    if (group != -1) {
+        H5Gclose(group);
+    }
+    free(mean);
+    free(miss_rate);
+    return err;
+}
 
-        if (status == -1) {
-            return ERROR_HDF5_ERROR;
+/**
+ * @brief Prints one quantity of a set of a window.
+ *
+ * @param output Holds data about the output stream
+ * @param aggregate the accumulators of the window
+ * @param quantity 0 for the mean, 1 for the max and 2 for the miss rate
+ * @param from index of the first value of the set
+ * @param count amount of values of the set
+ */
+static void text_window_values(output_t *output, const aggregate_t *aggregate,
+                               int quantity, uintptr_t from,
+                               uintptr_t count) {
+    for (uintptr_t i = from; i < from + count; i++) {
+        if (i > from) {
+            fputc(',', output->std);
         }
+        if (quantity == 0) {
+            fprintf(output->std, "%g",
+                    (double)aggregate->sum[i] / aggregate->frames);
+        } else if (quantity == 1) {
+            fprintf(output->std, "%u", aggregate->max[i]);
+        } else {
+            fprintf(output->std, "%g",
+                    (double)aggregate->misses[i] / aggregate->frames);
+        }
+    }
+}
+
+/**
+ * @brief Prints a window to a stream output.
+ *
+ * @see outputw_window
+ */
+static error_t text_window(output_t *output, const aggregate_t *aggregate,
+                           uint8_t rank, uintptr_t dim_x, uintptr_t dim_y) {
+    static const char *names[3] = {"mean", "max", "miss_rate"};
 
-        status = H5Dclose(dataset_id);
+    // the formatted frames are written before
+    FORWARD_ON_FAIL(text_flush(output));
 
-        if (status == -1) {
-            return ERROR_HDF5_ERROR;
+    if (output->format == OUTPUT_FORMAT_NDJSON) {
+        fprintf(output->std, "{\"cpu\":%d,\"clock\":%lu,\"frames\":%u",
+                output->cpu, aggregate->clock, aggregate->frames);
+        for (int quantity = 0; quantity < 3; quantity++) {
+            fprintf(output->std, ",\"%s\":[", names[quantity]);
+            for (uintptr_t set = 0; set < dim_y; set++) {
+                fputs(set ? (rank == 2 ? ",[" : ",") : (rank == 2 ? "[" : ""),
+                      output->std);
+                text_window_values(output, aggregate, quantity, set * dim_x,
+                                   dim_x);
+                fputs(rank == 2 ? "]" : "", output->std);
+            }
+            fputc(']', output->std);
+        }
+        fputs("}\n", output->std);
+    } else if (output->format == OUTPUT_FORMAT_CSV) {
+        for (uintptr_t set = 0; set < dim_y; set++) {
+            for (int quantity = 0; quantity < 3; quantity++) {
+                fprintf(output->std, "%d,%lu,%lu,%s,", output->cpu,
+                        aggregate->clock, text_set_id(output, set),
+                        names[quantity]);
+                text_window_values(output, aggregate, quantity, set * dim_x,
+                                   dim_x);
+                fputc('\n', output->std);
+            }
         }
     } else {
-        return ERROR_NOT_SUPPORTED_OUTPUT;
+        fprintf(output->std, "%swindow clock %lu frames %u\n", output->label,
+                aggregate->clock, aggregate->frames);
+        for (uintptr_t set = 0; set < dim_y; set++) {
+            fprintf(output->std, "%sset %lu: ", output->label,
+                    text_set_id(output, set));
+            for (int quantity = 0; quantity < 3; quantity++) {
+                fprintf(output->std, "%s%s ", quantity ? "; " : "",
+                        quantity == 2 ? "miss" : names[quantity]);
+                text_window_values(output, aggregate, quantity, set * dim_x,
+                                   dim_x);
+            }
+            fputc('\n', output->std);
+        }
     }
 
-    return ERROR_NONE;
+    return fflush(output->std) ? ERROR_IO : ERROR_NONE;
 }
 
-error_t outputc_stdout(output_t *output, FILE *file) {
+error_t outputw_window(output_t *output, const aggregate_t *aggregate,
+                       uint8_t rank, uintptr_t dim_x, uintptr_t dim_y,
+                       uint32_t threshold) {
+    if (output->type == OUTPUT_STDOUT) {
+        return text_window(output, aggregate, rank, dim_x, dim_y);
+    } else if (output->type == OUTPUT_HD5_FILE) {
+        return hd5_window(output, aggregate, rank, dim_x, dim_y, threshold);
+    }
+    return ERROR_NOT_SUPPORTED_OUTPUT;
+}
+
+/**
+ * @brief Resets all fields of an output.
+ *
+ * @param output the output
+ * @param type OUTPUT_STDOUT, OUTPUT_HD5_FILE or OUTPUT_CNV_FILE
+ *
+ * The constructors only set the fields which differ afterwards.
+ */
+static void output_init(output_t *output, uint8_t type) {
+    memset(output, 0, sizeof(output_t));
+    output->type = type;
     output->h5 = -1;
-    output->iter = 0;
+    output->frames = -1;
+    output->clock = -1;
+    output->format = OUTPUT_FORMAT_TEXT;
+    output->cpu = -1;
+    output->fd = -1;
+}
+
+error_t outputc_stdout(output_t *output, FILE *file) {
+    output_init(output, OUTPUT_STDOUT);
     output->std = file;
-    output->type = OUTPUT_STDOUT;
 
     return ERROR_NONE;
 }
@@ -92,17 +1306,350 @@ error_t outputc_hd5_file(output_t *output, char *file) {
         return ERROR_HDF5_ERROR;
     }
 
-    output->std = NULL;
+    output_init(output, OUTPUT_HD5_FILE);
     output->h5 = file_id;
-    output->iter = 0;
-    output->type = OUTPUT_HD5_FILE;
 
     return ERROR_NONE;
 }
 
+error_t outputc_hd5_group(output_t *output, output_t *parent,
+                          const char *name) {
+    if (parent->type != OUTPUT_HD5_FILE) {
+        return ERROR_NOT_SUPPORTED_OUTPUT;
+    }
+
+    hid_t group_id =
+        H5Gcreate(parent->h5, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    if (group_id == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    output_init(output, OUTPUT_HD5_FILE);
+    output->h5 = group_id;
+    output->group = 1;
+
+    return ERROR_NONE;
+}
+
+error_t outputc_cnv_file(output_t *output, const char *file,
+                         const cache_info_t *cache, timer_type_t timer,
+                         uint32_t cpu) {
+    int fd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) {
+        return ERROR_IO_CNV;
+    }
+
+    if (fchmod(fd, 0666)) {
+        close(fd);
+        return ERROR_CHMOD;
+    }
+
+    // the frames start behind the zero padded header
+    if (ftruncate(fd, OUTPUT_CNV_HEADER_SIZE)) {
+        close(fd);
+        return ERROR_IO_CNV;
+    }
+
+    output_init(output, OUTPUT_CNV_FILE);
+    output->cpu = cpu;
+    output->fd = fd;
+
+    memcpy(output->cnv.magic, OUTPUT_CNV_MAGIC, sizeof(output->cnv.magic));
+    output->cnv.version = OUTPUT_CNV_VERSION;
+    output->cnv.header_size = OUTPUT_CNV_HEADER_SIZE;
+    output->cnv.cpu = cpu;
+    output->cnv.timer = timer;
+    output->cnv.level = cache->level;
+    output->cnv.type = cache->type;
+    output->cnv.line_size = cache->line_size;
+    output->cnv.total_size = cache->total_size;
+    output->cnv.set_count = cache->set_count;
+    output->cnv.way_count = cache->ways_of_associativity;
+
+    error_t err = cnv_header_write(output);
+    if (err) {
+        close(fd);
+        output->fd = -1;
+        output->type = 0;
+    }
+    return err;
+}
+
+/**
+ * @brief Checks the header of a .cnv file before its records are read.
+ *
+ * @param header the header at the start of the mapped file
+ * @param file_size size of the file
+ *
+ * The ids behind the header have to fit into it and a record has to hold
+ * exactly the timestamp and one frame of the stored shape, so no record is
+ * read past the end of the file. A file without frames has neither a shape
+ * nor a record size.
+ *
+ * @return Not zero if the file can be read.
+ */
+static int cnv_header_valid(const cnv_header_t *header, uint64_t file_size) {
+    uint64_t id_size =
+        ((uint64_t)header->mask_sets + header->mask_ways) * sizeof(uint32_t);
+    if (memcmp(header->magic, OUTPUT_CNV_MAGIC, sizeof(header->magic)) ||
+        !header->version || header->version > OUTPUT_CNV_VERSION ||
+        header->header_size < OUTPUT_CNV_HEADER_SIZE ||
+        header->header_size > file_size ||
+        sizeof(cnv_header_t) + id_size > header->header_size) {
+        return 0;
+    }
+
+    if (!header->rank) {
+        return !header->record_size;
+    }
+
+    if ((header->rank != 1 && header->rank != 2) ||
+        (header->rank == 1 && header->dim_x != 1) || !header->dim_x ||
+        !header->dim_y ||
+        (header->bits != 0 && header->bits != 1 && header->bits != 32)) {
+        return 0;
+    }
+
+    uint64_t values = (uint64_t)header->dim_x * header->dim_y;
+    uint64_t frame_size = header->bits == 1 ? classify_bitmap_size(values)
+                                            : sizeof(uint32_t) * values;
+    return header->record_size == sizeof(uint64_t) + frame_size;
+}
+
+error_t output_cnv_convert(const char *path, output_t *output) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return ERROR_IO_CNV;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) || info.st_size < OUTPUT_CNV_HEADER_SIZE) {
+        close(fd);
+        return ERROR_IO_CNV;
+    }
+
+    uint8_t *map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return ERROR_IO_CNV;
+    }
+
+    // the ids of the probed sets and ways follow the header, version 1
+    // files have none
+    const cnv_header_t *header = (const cnv_header_t *)map;
+    const uint32_t *ids = (const uint32_t *)(header + 1);
+    error_t err = cnv_header_valid(header, info.st_size) ? ERROR_NONE
+                                                         : ERROR_IO_CNV;
+
+    if (!err) {
+        err = output_set_mask(
+            output, header->mask_sets ? ids : NULL, header->mask_sets,
+            header->mask_ways ? ids + header->mask_sets : NULL,
+            header->mask_ways);
+    }
+
+    // files without classification have zero bits
+    if (!err) {
+        err = header->bits == 1 ? output_values(output, 1, header->threshold)
+                                : output_values(output, 32, 0);
+    }
+
+    // the frame count of an unclean exit is derived from the file size
+    uintptr_t count = 0;
+    if (!err && header->record_size) {
+        count = (info.st_size - header->header_size) / header->record_size;
+    }
+
+    for (uintptr_t i = 0; i < count && !err; i++) {
+        const uint8_t *record =
+            map + header->header_size + i * header->record_size;
+        uint64_t clock;
+        memcpy(&clock, record, sizeof(uint64_t));
+
+        err = output_frame(output, record + sizeof(uint64_t), clock,
+                           header->rank, header->dim_x, header->dim_y);
+    }
+
+    munmap(map, info.st_size);
+    return err;
+}
+
+void output_set_label(output_t *output, const char *label) {
+    snprintf(output->label, sizeof(output->label), "%s", label);
+}
+
+void output_set_format(output_t *output, output_format_t format) {
+    output->format = format;
+}
+
+void output_set_cpu(output_t *output, uint32_t cpu) { output->cpu = cpu; }
+
+/**
+ * @brief Writes a one dimensional dataset of ids to a HDF5 output.
+ *
+ * @param h5 the file or group
+ * @param name name of the dataset
+ * @param ids the ids
+ * @param count amount of ids
+ *
+ * @retval ERROR_HDF5_ERROR
+ * @retval ERROR_NONE
+ */
+static error_t hd5_ids(hid_t h5, const char *name, const uint32_t *ids,
+                       hsize_t count) {
+    hid_t space = H5Screate_simple(1, &count, NULL);
+    if (space == -1) {
+        return ERROR_HDF5_ERROR;
+    }
+
+    hid_t dataset = H5Dcreate(h5, name, H5T_NATIVE_UINT32, space,
+                              H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    herr_t status = dataset == -1 ? -1
+                                  : H5Dwrite(dataset, H5T_NATIVE_UINT32,
+                                             H5S_ALL, H5S_ALL, H5P_DEFAULT,
+                                             ids);
+
+    if (dataset != -1) {
+        H5Dclose(dataset);
+    }
+    H5Sclose(space);
+
+    return status < 0 ? ERROR_HDF5_ERROR : ERROR_NONE;
+}
+
+/**
+ * @brief Stores the ids of the probed sets and ways behind the header of a
+ * .cnv file.
+ *
+ * @see output_set_mask
+ */
+static error_t cnv_mask(output_t *output, const uint32_t *sets,
+                        uint32_t set_count, const uint32_t *ways,
+                        uint32_t way_count) {
+    uint64_t size = sizeof(cnv_header_t) +
+                    ((uint64_t)set_count + way_count) * sizeof(uint32_t);
+    uint64_t header_size = (size + OUTPUT_CNV_HEADER_SIZE - 1) /
+                           OUTPUT_CNV_HEADER_SIZE * OUTPUT_CNV_HEADER_SIZE;
+    if (header_size > UINT32_MAX) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    output->cnv.header_size = header_size;
+    output->cnv.mask_sets = set_count;
+    output->cnv.mask_ways = way_count;
+    if (ftruncate(output->fd, header_size)) {
+        return ERROR_IO_CNV;
+    }
+
+    struct iovec iov[2] = {
+        {(void *)sets, sizeof(uint32_t) * set_count},
+        {(void *)ways, sizeof(uint32_t) * way_count},
+    };
+    FORWARD_ON_FAIL(
+        cnv_pwritev(output->fd, iov, 2, sizeof(cnv_header_t)));
+    return cnv_header_write(output);
+}
+
+error_t output_set_mask(output_t *output, const uint32_t *sets,
+                        uint32_t set_count, const uint32_t *ways,
+                        uint32_t way_count) {
+    if (sets == NULL) {
+        set_count = 0;
+    }
+    if (ways == NULL) {
+        way_count = 0;
+    }
+    if (!set_count && !way_count) {
+        return ERROR_NONE;
+    }
+
+    if (output->type == OUTPUT_STDOUT && set_count) {
+        // the rows of a stream are labeled, the ways are not
+        free(output->sets);
+        output->sets = malloc(sizeof(uint32_t) * set_count);
+        if (output->sets == NULL) {
+            return ERROR_ALLOCATION;
+        }
+        memcpy(output->sets, sets, sizeof(uint32_t) * set_count);
+    } else if (output->type == OUTPUT_CNV_FILE) {
+        if (output->cnv.rank) {
+            return ERROR_INVALID_ARGUMENT;
+        }
+        FORWARD_ON_FAIL(cnv_mask(output, sets, set_count, ways, way_count));
+    } else if (output->type == OUTPUT_HD5_FILE) {
+        if (output->frames != -1) {
+            return ERROR_INVALID_ARGUMENT;
+        }
+        if (set_count) {
+            FORWARD_ON_FAIL(hd5_ids(output->h5, OUTPUT_HD5_SETS, sets,
+                                    set_count));
+        }
+        if (way_count) {
+            FORWARD_ON_FAIL(hd5_ids(output->h5, OUTPUT_HD5_WAYS, ways,
+                                    way_count));
+        }
+    }
+
+    return ERROR_NONE;
+}
+
+error_t output_format_from(const char *name, output_format_t *format) {
+    if (!strcmp(name, "text")) {
+        *format = OUTPUT_FORMAT_TEXT;
+    } else if (!strcmp(name, "csv")) {
+        *format = OUTPUT_FORMAT_CSV;
+    } else if (!strcmp(name, "ndjson")) {
+        *format = OUTPUT_FORMAT_NDJSON;
+    } else {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    return ERROR_NONE;
+}
+
+const char *output_format_name(output_format_t format) {
+    return format == OUTPUT_FORMAT_CSV      ? "csv"
+           : format == OUTPUT_FORMAT_NDJSON ? "ndjson"
+                                            : "text";
+}
+
 error_t output_close(output_t *output) {
-    if (output->type == OUTPUT_HD5_FILE) {
-        if (H5Fclose(output->h5) == -1) {
+    if (output->type == OUTPUT_STDOUT) {
+        error_t err = text_flush(output);
+        free(output->text);
+        free(output->sets);
+        output->text = NULL;
+        output->text_size = 0;
+        output->sets = NULL;
+        FORWARD_ON_FAIL(err);
+    } else if (output->type == OUTPUT_CNV_FILE && output->fd != -1) {
+        error_t err = cnv_header_write(output);
+        if (close(output->fd)) {
+            err = ERROR_IO_CNV;
+        }
+        output->fd = -1;
+        FORWARD_ON_FAIL(err);
+    } else if (output->type == OUTPUT_HD5_FILE) {
+        if (output->frames != -1) {
+            error_t err = hd5_frames_flush(output);
+
+            free(output->chunk);
+            free(output->chunk_clock);
+            output->chunk = NULL;
+            output->chunk_clock = NULL;
+
+            if (H5Dclose(output->frames) == -1 ||
+                H5Dclose(output->clock) == -1) {
+                return ERROR_HDF5_ERROR;
+            }
+            output->frames = -1;
+            output->clock = -1;
+            FORWARD_ON_FAIL(err);
+        }
+
+        herr_t status =
+            output->group ? H5Gclose(output->h5) : H5Fclose(output->h5);
+        if (status == -1) {
             return ERROR_HDF5_ERROR;
         }
     }
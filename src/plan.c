@@ -0,0 +1,290 @@
+/**
+ * @file plan.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains all functions to build the address plans of the kernels.
+ */
+
+#include "plan.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Alignment of the entry table.
+ */
+#define PLAN_ALIGNMENT 64
+
+/**
+ * @brief Returns a random number in [0, bound).
+ *
+ * @param seed state of the random number generator
+ * @param bound upper bound
+ */
+static uintptr_t random_below(unsigned int *seed, uintptr_t bound) {
+    return ((uintptr_t)rand_r(seed) * (RAND_MAX + 1UL) + rand_r(seed)) % bound;
+}
+
+/**
+ * @brief Reorders the entries of a plan.
+ *
+ * @param plan plan with entries in the linear order
+ * @param order the new order
+ */
+static void plan_reorder(probe_plan_t *plan, plan_order_t order) {
+    if (order == PLAN_ORDER_REVERSE) {
+        for (uintptr_t i = 0; i < plan->count / 2; i++) {
+            plan_entry_t tmp = plan->entries[i];
+            plan->entries[i] = plan->entries[plan->count - 1 - i];
+            plan->entries[plan->count - 1 - i] = tmp;
+        }
+    } else if (order == PLAN_ORDER_RANDOM) {
+        // Fisher-Yates shuffle
+        unsigned int seed = time(NULL) ^ getpid();
+        for (uintptr_t i = plan->count - 1; i > 0; i--) {
+            uintptr_t j = random_below(&seed, i + 1);
+            plan_entry_t tmp = plan->entries[i];
+            plan->entries[i] = plan->entries[j];
+            plan->entries[j] = tmp;
+        }
+    }
+
+    plan->order = order;
+}
+
+/**
+ * @brief Links all cache lines of every set and replaces the entries by the
+ * first cache line of each set.
+ *
+ * @param plan plan with the cache lines in the linear order
+ * @param order the traversal order, the lists are shuffled if it is random
+ */
+static void plan_link_sets(probe_plan_t *plan, plan_order_t order) {
+    unsigned int seed = time(NULL) ^ getpid();
+
+    for (uint32_t set = 0; set < plan->set_count; set++) {
+        plan_entry_t *ways = plan->entries + set * plan->way_count;
+
+        if (order == PLAN_ORDER_RANDOM) {
+            for (uint32_t i = plan->way_count - 1; i > 0; i--) {
+                uintptr_t j = random_below(&seed, i + 1);
+                plan_entry_t tmp = ways[i];
+                ways[i] = ways[j];
+                ways[j] = tmp;
+            }
+        }
+
+        for (uint32_t way = 0; way < plan->way_count; way++) {
+            uintptr_t *links = (uintptr_t *)ways[way].line;
+            links[0] = way + 1 < plan->way_count ? ways[way + 1].line : 0;
+            links[1] = way ? ways[way - 1].line : 0;
+        }
+
+        // entries of the first sets are not read again, so the list heads
+        // can be stored in place
+        plan->entries[set].line = ways[0].line;
+        plan->entries[set].slot = set;
+    }
+
+    plan->count = plan->set_count;
+}
+
+/**
+ * @brief Allocates the entries of a plan.
+ *
+ * @param plan the plan
+ * @param set_count amount of sets
+ * @param way_count amount of ways
+ * @param granularity measure every cache line or every set
+ * @param arena the arena of the entries or NULL
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_ARENA
+ * @retval ERROR_NONE
+ */
+static error_t plan_alloc(probe_plan_t *plan, uint32_t set_count,
+                          uint32_t way_count, plan_granularity_t granularity,
+                          arena_t *arena) {
+    plan->set_count = set_count;
+    plan->way_count = way_count;
+    plan->count = (uintptr_t)set_count * way_count;
+    plan->granularity = granularity;
+
+    // aligned_alloc requires a multiple of the alignment
+    size_t size = plan->count * sizeof(plan_entry_t);
+    size = (size + PLAN_ALIGNMENT - 1) / PLAN_ALIGNMENT * PLAN_ALIGNMENT;
+
+    plan->in_arena = arena != NULL;
+    if (arena != NULL) {
+        return arena_alloc(arena, size, (void **)&plan->entries);
+    }
+
+    plan->entries = aligned_alloc(PLAN_ALIGNMENT, size);
+    if (plan->entries == NULL) {
+        return ERROR_ALLOCATION;
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Links the sets and reorders a plan with entries in the linear order.
+ *
+ * @param plan the plan
+ * @param order the traversal order
+ *
+ * The list tails of a plan with PLAN_GRANULARITY_SET are stored behind the
+ * list heads, where the entries of the other ways were.
+ */
+static void plan_finish(probe_plan_t *plan, plan_order_t order) {
+    if (plan->granularity == PLAN_GRANULARITY_SET) {
+        plan_link_sets(plan, order);
+    }
+
+    plan_reorder(plan, order);
+
+    plan->reverse = plan->entries;
+    if (plan->granularity == PLAN_GRANULARITY_SET && plan->way_count > 1) {
+        plan->reverse = plan->entries + plan->count;
+        for (uintptr_t i = 0; i < plan->count; i++) {
+            uintptr_t line = plan->entries[i].line;
+            while (*(uintptr_t *)line) {
+                line = *(uintptr_t *)line;
+            }
+            plan->reverse[i].line = line;
+            plan->reverse[i].slot = plan->entries[i].slot;
+        }
+    }
+}
+
+/**
+ * @brief Checks that all ids of a selection are below a bound.
+ *
+ * @param ids the selected ids or NULL for all
+ * @param count amount of selected ids
+ * @param bound amount of available ids
+ *
+ * @return Not zero if an id is out of range.
+ */
+static int plan_out_of_range(const uint32_t *ids, uint32_t count,
+                             uint32_t bound) {
+    for (uint32_t i = 0; ids != NULL && i < count; i++) {
+        if (ids[i] >= bound) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+error_t probe_plan_new(probe_plan_t *plan, const cache_info_t *cache,
+                       void *buffer, const uint32_t *sets, uint32_t set_count,
+                       const uint32_t *ways, uint32_t way_count,
+                       plan_order_t order, plan_granularity_t granularity,
+                       arena_t *arena) {
+    if (sets == NULL) {
+        set_count = cache->set_count;
+    }
+    if (ways == NULL) {
+        way_count = cache->ways_of_associativity;
+    }
+
+    if (plan_out_of_range(sets, set_count, cache->set_count) ||
+        plan_out_of_range(ways, way_count, cache->ways_of_associativity)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    FORWARD_ON_FAIL(
+        plan_alloc(plan, set_count, way_count, granularity, arena));
+
+    for (uint32_t i = 0; i < plan->set_count; i++) {
+        uint32_t set = sets != NULL ? sets[i] : i;
+
+        for (uint32_t j = 0; j < plan->way_count; j++) {
+            uint32_t way = ways != NULL ? ways[j] : j;
+            plan_entry_t *entry = plan->entries + i * plan->way_count + j;
+            entry->line =
+                (uintptr_t)buffer +
+                ((uintptr_t)way * cache->set_count + set) * cache->line_size;
+            entry->slot = i * plan->way_count + j;
+        }
+    }
+
+    plan_finish(plan, order);
+
+    return ERROR_NONE;
+}
+
+error_t probe_plan_from_lines(probe_plan_t *plan, const uintptr_t *lines,
+                              uint32_t set_count, uint32_t way_count,
+                              const uint32_t *ways, uint32_t selected,
+                              plan_order_t order,
+                              plan_granularity_t granularity,
+                              arena_t *arena) {
+    if (ways == NULL) {
+        selected = way_count;
+    }
+    if (plan_out_of_range(ways, selected, way_count)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    FORWARD_ON_FAIL(
+        plan_alloc(plan, set_count, selected, granularity, arena));
+
+    for (uint32_t set = 0; set < plan->set_count; set++) {
+        for (uint32_t j = 0; j < plan->way_count; j++) {
+            uint32_t way = ways != NULL ? ways[j] : j;
+            uintptr_t i = (uintptr_t)set * plan->way_count + j;
+            plan->entries[i].line = lines[(uintptr_t)set * way_count + way];
+            plan->entries[i].slot = i;
+        }
+    }
+
+    plan_finish(plan, order);
+
+    return ERROR_NONE;
+}
+
+uintptr_t probe_plan_frame_length(const probe_plan_t *plan) {
+    if (plan->granularity == PLAN_GRANULARITY_SET) {
+        return plan->set_count;
+    }
+    return (uintptr_t)plan->set_count * plan->way_count;
+}
+
+void probe_plan_free(probe_plan_t *plan) {
+    if (!plan->in_arena) {
+        free(plan->entries);
+    }
+    plan->entries = NULL;
+    plan->reverse = NULL;
+    plan->count = 0;
+}
+
+error_t plan_order_from(const char *name, plan_order_t *order) {
+    if (!strcmp(name, "linear")) {
+        *order = PLAN_ORDER_LINEAR;
+    } else if (!strcmp(name, "reverse")) {
+        *order = PLAN_ORDER_REVERSE;
+    } else if (!strcmp(name, "random")) {
+        *order = PLAN_ORDER_RANDOM;
+    } else {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    return ERROR_NONE;
+}
+
+error_t plan_granularity_from(const char *name,
+                              plan_granularity_t *granularity) {
+    if (!strcmp(name, "line")) {
+        *granularity = PLAN_GRANULARITY_LINE;
+    } else if (!strcmp(name, "set")) {
+        *granularity = PLAN_GRANULARITY_SET;
+    } else {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    return ERROR_NONE;
+}
@@ -5,248 +5,1828 @@
  * @brief Contains all functions which are necessary for the profiling process.
  */
 #include "profile.h"
+#include "aggregate.h"
+#include "alloc.h"
+#include "classify.h"
+#include "counters.h"
+#include "ring.h"
+#include "stats.h"
 #include "sys_action.h"
+#include "timer.h"
 
 #include <math.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <asm/unistd.h>
 #include <linux/perf_event.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <x86intrin.h>
 
-void prime(uint64_t line_size, uint64_t set_count, uint64_t way_count,
-           uint64_t total_size, const void *buffer) {
-
-    volatile uint64_t buffer_offset = 0;
-    volatile uint64_t set = 0;
-    volatile uint64_t way = 0;
+/**
+ * @brief Loads every cache line of a plan with PLAN_GRANULARITY_LINE and
+ * serializes every load.
+ *
+ * @param plan the plan which is walked backwards
+ *
+ * This is the reference of the faster prime kernels in benchmark_prime.
+ */
+static void prime_lines_fenced(const probe_plan_t *plan) {
+    const plan_entry_t *entry = plan->entries + plan->count;
 
     asm volatile(
-        //---------------------- load buffer set wise
-        //---------------------------
+        //---------------------- load the plan backwards ---------------------
+        "primeloop%=:;"
 
-        "primeouterloop%=:;"
+        "sub $16, %[entry];"        // entry--
+        "mov (%[entry]), %%rax;"    // rax = entry->line
 
-        // way = way_count - 1
-        "mov %[way_count],%[way];"
-        "dec %[way];"
+        "mfence;"
+        "mov (%%rax), %%rax;" // access the memory
+        "mfence;"
 
-        "primeinnerloop%=:;"
+        // if plan->entries < entry goto primeloop
+        "cmp %[first], %[entry];"
+        "ja primeloop%=;"
+        : [entry] "+r"(entry)
+        : [first] "r"(plan->entries)
+        : "memory", "rax");
+}
 
-        // buffer_offset = (way * cache->set_count+ set) * cache->line_size;
-        "xor %[buffer_offset], %[buffer_offset];"
-        "add %[way], %[buffer_offset];"
-        "imulq %[set_count],%[buffer_offset];"
-        "add %[set],%[buffer_offset];"
-        "imulq %[line_size],%[buffer_offset];"
+/**
+ * @brief Loads every cache line of a plan with PLAN_GRANULARITY_LINE.
+ *
+ * @param plan the plan which is walked backwards
+ *
+ * The loads are issued back to back, so the misses overlap. A single fence
+ * at the end waits until all lines are loaded.
+ */
+static void prime_lines(const probe_plan_t *plan) {
+    const plan_entry_t *entry = plan->entries + plan->count;
 
+    asm volatile(
+        "primeloop%=:;"
+
+        "sub $16, %[entry];"     // entry--
+        "mov (%[entry]), %%rax;" // rax = entry->line
+        "mov (%%rax), %%rax;"    // access the memory
+
+        // if plan->entries < entry goto primeloop
+        "cmp %[first], %[entry];"
+        "ja primeloop%=;"
         "mfence;"
-        "mov (%[buffer],%[buffer_offset],1), %%rax;" // access the memory
-        "mfence;"
+        : [entry] "+r"(entry)
+        : [first] "r"(plan->entries)
+        : "memory", "rax");
+}
+
+/**
+ * @brief Defines a prime kernel which is unrolled by the amount of ways.
+ *
+ * @param name name of the kernel
+ * @param ways amount of ways, the plan has to hold a multiple of it
+ *
+ * Like prime_lines, but every iteration loads the @p ways entries below the
+ * current one, so the loop overhead is paid once per set of a linear plan.
+ */
+#define DEFINE_PRIME_LINES(name, ways)                                         \
+    static void name(const probe_plan_t *plan) {                               \
+        const plan_entry_t *entry = plan->entries + plan->count;               \
+                                                                               \
+        asm volatile(                                                          \
+            "primeloop%=:;"                                                    \
+                                                                               \
+            "sub $16 * " #ways ", %[entry];" /* entry -= ways */               \
+                                                                               \
+            /* load the entries from the last to the first */                  \
+            ".set primeoffset%=, 16 * (" #ways " - 1);"                        \
+            ".rept " #ways ";"                                                 \
+            "mov primeoffset%=(%[entry]), %%rax;"                              \
+            "mov (%%rax), %%rax;"                                              \
+            ".set primeoffset%=, primeoffset%= - 16;"                          \
+            ".endr;"                                                           \
+                                                                               \
+            /* if plan->entries < entry goto primeloop */                      \
+            "cmp %[first], %[entry];"                                          \
+            "ja primeloop%=;"                                                  \
+            "mfence;"                                                          \
+            : [entry] "+r"(entry)                                              \
+            : [first] "r"(plan->entries)                                       \
+            : "memory", "rax");                                                \
+    }
 
-        "dec %[way];" // way--
+DEFINE_PRIME_LINES(prime_lines_8, 8)
+DEFINE_PRIME_LINES(prime_lines_12, 12)
+DEFINE_PRIME_LINES(prime_lines_16, 16)
 
-        // if 0 < way go to innerloop
-        "cmp $0, %[way];"
-        "jnl primeinnerloop%=;"
+/**
+ * @brief Loads every cache line of a plan with PLAN_GRANULARITY_SET.
+ *
+ * @param plan the plan which is walked backwards
+ *
+ * Follows the linked list of every set until its end. A single fence at the
+ * end waits until all lines are loaded.
+ */
+static void prime_sets(const probe_plan_t *plan) {
+    const plan_entry_t *entry = plan->entries + plan->count;
+
+    asm volatile(
+        "primeloop%=:;"
 
-        "inc  %[set];" // set++
+        "sub $16, %[entry];"     // entry--
+        "mov (%[entry]), %%rax;" // rax = entry->line
 
-        // if set < set_cout goto outerloop
-        "cmp %[set_count],%[set];"
-        "jl primeouterloop%=;"
-        : // no output
-        : [buffer] "r"(buffer), [set] "r"(set), [way] "r"(way),
-          [total_size] "r"(total_size), [buffer_offset] "r"(buffer_offset),
-          [set_count] "r"(set_count), [line_size] "r"(line_size),
-          [way_count] "r"(way_count)
-        : "memory", "eax", "ebx", "ecx", "edx", "rax", "rdx", "r8");
+        "primechase%=:;"
+        "mov (%%rax), %%rax;" // rax = next cache line of the set
+        "test %%rax, %%rax;"
+        "jnz primechase%=;"
+
+        // if plan->entries < entry goto primeloop
+        "cmp %[first], %[entry];"
+        "ja primeloop%=;"
+        "mfence;"
+        : [entry] "+r"(entry)
+        : [first] "r"(plan->entries)
+        : "memory", "rax");
 }
 
-void probe(uint64_t line_size, uint64_t set_count, uint64_t way_count,
-           const void *buffer, const uint32_t *result) {
+/**
+ * @brief A prime kernel which loads every cache line of a plan.
+ */
+typedef void (*prime_kernel_t)(const probe_plan_t *plan);
+
+/**
+ * @brief Returns the fastest prime kernel of a plan.
+ *
+ * @param plan the plan
+ *
+ * @return An unrolled kernel if one matches the amount of ways of the plan,
+ * otherwise the generic kernel of its granularity.
+ */
+static prime_kernel_t prime_kernel(const probe_plan_t *plan) {
+    if (plan->granularity == PLAN_GRANULARITY_SET) {
+        return prime_sets;
+    }
+    if (plan->count % plan->way_count) {
+        return prime_lines;
+    }
 
-    volatile uint64_t buffer_offset = 0;
-    volatile uint64_t result_index = 0;
-    volatile uint64_t set = 0;
-    volatile uint64_t way = 0;
+    switch (plan->way_count) {
+    case 8:
+        return prime_lines_8;
+    case 12:
+        return prime_lines_12;
+    case 16:
+        return prime_lines_16;
+    default:
+        return prime_lines;
+    }
+}
 
-    asm volatile(
-        "outerloop%=:;"
+/**
+ * @brief Loads every cache line of a plan.
+ *
+ * @param plan the plan
+ */
+static void prime(const probe_plan_t *plan) {
+    prime_kernel(plan)(plan);
+}
 
-        "xor %[way],%[way];" // way = 0
-        "innerloop%=:;"
+/**
+ * @brief Defines a probe kernel for a timer backend.
+ *
+ * @param name name of the kernel
+ * @param start START fragment of the timer backend
+ * @param stop STOP fragment of the timer backend
+ * @param serialize SERIALIZE fragment of the timer backend
+ * @param backward 0 to walk probe_plan_t#entries forwards, 1 to walk
+ * probe_plan_t#reverse backwards
+ *
+ * The kernel walks the plan, measures the time of every access, subtracts
+ * the overhead of the timer and writes the result to the slot of the plan
+ * entry.
+ */
+#define DEFINE_PROBE(name, start, stop, serialize, backward)                   \
+    static void name(const probe_plan_t *plan, uint32_t *result,               \
+                     uint32_t overhead) {                                      \
+        const plan_entry_t *entry =                                            \
+            backward ? plan->reverse + plan->count - 1 : plan->entries;        \
+        uintptr_t count = plan->count;                                         \
+                                                                               \
+        asm volatile(                                                          \
+            "probeloop%=:;"                                                    \
+                                                                               \
+            "mov (%[entry]), %%r9;" /* r9 = entry->line */                     \
+                                                                               \
+            start "mov (%%r9), %%rax;" /* access the memory */                 \
+            stop TIMER_SUBTRACT_OVERHEAD                                       \
+                                                                               \
+            /* write result into result buffer at entry->slot */               \
+            /* (nontemporal hint -> doesn't modify the cache) */               \
+            "mov 8(%[entry]), %%r9;"                                           \
+            "movnti %%eax, (%[result],%%r9,4);" serialize                      \
+                                                                               \
+            "add %[step], %[entry];" /* next entry */                          \
+                                                                               \
+            /* if --count goto probeloop */                                    \
+            "dec %[count];"                                                    \
+            "jnz probeloop%=;"                                                 \
+            : [entry] "+r"(entry), [count] "+r"(count)                         \
+            : [result] "r"(result), [step] "i"(backward ? -16 : 16),           \
+              [overhead] "r"(overhead)                                         \
+            : "memory", "rax", "rbx", "rcx", "rdx", "r8", "r9");               \
+    }
 
-        /* buffer_offset = (way * cache->set_count+ set) * cache->line_size;*/
-        // buffer_offset = 0
-        "xor %[buffer_offset], %[buffer_offset];"
+DEFINE_PROBE(probe_rdpmc, TIMER_RDPMC_START, TIMER_RDPMC_STOP,
+             TIMER_RDPMC_SERIALIZE, 0)
+DEFINE_PROBE(probe_rdtscp, TIMER_RDTSCP_START, TIMER_RDTSCP_STOP,
+             TIMER_RDTSCP_SERIALIZE, 0)
+DEFINE_PROBE(probe_rdtsc, TIMER_RDTSC_START, TIMER_RDTSC_STOP,
+             TIMER_RDTSC_SERIALIZE, 0)
+DEFINE_PROBE(probe_back_rdpmc, TIMER_RDPMC_START, TIMER_RDPMC_STOP,
+             TIMER_RDPMC_SERIALIZE, 1)
+DEFINE_PROBE(probe_back_rdtscp, TIMER_RDTSCP_START, TIMER_RDTSCP_STOP,
+             TIMER_RDTSCP_SERIALIZE, 1)
+DEFINE_PROBE(probe_back_rdtsc, TIMER_RDTSC_START, TIMER_RDTSC_STOP,
+             TIMER_RDTSC_SERIALIZE, 1)
 
-        // buffer_offset = buffer_offset + way = way
-        "add %[way], %[buffer_offset];"
+/**
+ * @brief Defines a set-granular probe kernel for a timer backend.
+ *
+ * @param name name of the kernel
+ * @param start START fragment of the timer backend
+ * @param stop STOP fragment of the timer backend
+ * @param serialize SERIALIZE fragment of the timer backend
+ * @param backward 0 to walk probe_plan_t#entries forwards and follow the
+ * lists to the next cache line, 1 to walk probe_plan_t#reverse backwards and
+ * follow the lists to the previous cache line
+ *
+ * The kernel walks the plan and measures the time it takes to follow the
+ * linked list of a whole set with a single timer start and stop.
+ */
+#define DEFINE_PROBE_SET(name, start, stop, serialize, backward)               \
+    static void name(const probe_plan_t *plan, uint32_t *result,               \
+                     uint32_t overhead) {                                      \
+        const plan_entry_t *entry =                                            \
+            backward ? plan->reverse + plan->count - 1 : plan->entries;        \
+        uintptr_t count = plan->count;                                         \
+                                                                               \
+        asm volatile(                                                          \
+            "probeloop%=:;"                                                    \
+                                                                               \
+            "mov (%[entry]), %%r9;" /* r9 = entry->line */                     \
+                                                                               \
+            start "probechase%=:;"                                             \
+            "mov %c[link](%%r9), %%r9;" /* r9 = next cache line of the set */  \
+            "test %%r9, %%r9;"                                                 \
+            "jnz probechase%=;" stop TIMER_SUBTRACT_OVERHEAD                   \
+                                                                               \
+            /* write result into result buffer at entry->slot */               \
+            "mov 8(%[entry]), %%r9;"                                           \
+            "movnti %%eax, (%[result],%%r9,4);" serialize                      \
+                                                                               \
+            "add %[step], %[entry];" /* next entry */                          \
+                                                                               \
+            /* if --count goto probeloop */                                    \
+            "dec %[count];"                                                    \
+            "jnz probeloop%=;"                                                 \
+            : [entry] "+r"(entry), [count] "+r"(count)                         \
+            : [result] "r"(result), [step] "i"(backward ? -16 : 16),           \
+              [link] "i"(backward ? 8 : 0), [overhead] "r"(overhead)           \
+            : "memory", "rax", "rbx", "rcx", "rdx", "r8", "r9");               \
+    }
 
-        // buffer_offset = buffer_offset * set_count = way * set_count
-        "imulq %[set_count],%[buffer_offset];"
+DEFINE_PROBE_SET(probe_set_rdpmc, TIMER_RDPMC_START, TIMER_RDPMC_STOP,
+                 TIMER_RDPMC_SERIALIZE, 0)
+DEFINE_PROBE_SET(probe_set_rdtscp, TIMER_RDTSCP_START, TIMER_RDTSCP_STOP,
+                 TIMER_RDTSCP_SERIALIZE, 0)
+DEFINE_PROBE_SET(probe_set_rdtsc, TIMER_RDTSC_START, TIMER_RDTSC_STOP,
+                 TIMER_RDTSC_SERIALIZE, 0)
+DEFINE_PROBE_SET(probe_set_back_rdpmc, TIMER_RDPMC_START, TIMER_RDPMC_STOP,
+                 TIMER_RDPMC_SERIALIZE, 1)
+DEFINE_PROBE_SET(probe_set_back_rdtscp, TIMER_RDTSCP_START, TIMER_RDTSCP_STOP,
+                 TIMER_RDTSCP_SERIALIZE, 1)
+DEFINE_PROBE_SET(probe_set_back_rdtsc, TIMER_RDTSC_START, TIMER_RDTSC_STOP,
+                 TIMER_RDTSC_SERIALIZE, 1)
 
-        // buffer_offset = buffer_offset + set = way * set_count + set
-        "add %[set],%[buffer_offset];"
+/**
+ * @brief A probe kernel which walks a plan.
+ */
+typedef void (*probe_kernel_t)(const probe_plan_t *plan, uint32_t *result,
+                               uint32_t overhead);
 
-        // buffer_offset = buffer_offset * line_size = (way * set_count + set) *
-        // line_size
-        "imulq %[line_size],%[buffer_offset];"
+/**
+ * @brief The probe kernels, indexed by plan_granularity_t and timer_type_t.
+ */
+static const probe_kernel_t probe_kernels[][TIMER_COUNT] = {
+    [PLAN_GRANULARITY_LINE] = {probe_rdpmc, probe_rdtscp, probe_rdtsc},
+    [PLAN_GRANULARITY_SET] = {probe_set_rdpmc, probe_set_rdtscp,
+                              probe_set_rdtsc}};
 
-        /* ---------------------- measurement --------------------------------*/
-        "cpuid;" // serialize execution
-        "mov $1073741825, %%ecx;"
-        "rdpmc;"            // load timestamps into edx:eax
-        "mov %%eax, %%r8d;" // save the lower 32 bit of the first timestamp
+/**
+ * @brief The backward probe kernels of a fused probe, indexed like
+ * probe_kernels.
+ */
+static const probe_kernel_t probe_back_kernels[][TIMER_COUNT] = {
+    [PLAN_GRANULARITY_LINE] = {probe_back_rdpmc, probe_back_rdtscp,
+                               probe_back_rdtsc},
+    [PLAN_GRANULARITY_SET] = {probe_set_back_rdpmc, probe_set_back_rdtscp,
+                              probe_set_back_rdtsc}};
 
-        "mfence;"
-        "mov (%[buffer],%[buffer_offset],1), %%rax;" // access the memory
-        "mfence;"
+/**
+ * @brief Releases all probe threads at the same time.
+ */
+typedef struct start_gate_s {
+    atomic_uint arrived; /**< Amount of threads which wait at the gate. */
+    atomic_int open;     /**< Set by the main thread to release them. */
+} start_gate_t;
 
-        "mov $1073741825, %%ecx;"
-        "rdpmc;"            // load timestamps into edx:eax
-        "sub %%r8d, %%eax;" // r8 = eax-r8 (end - start)
+/**
+ * @brief Time the main thread sleeps while it waits for the probe threads.
+ */
+#define START_GATE_POLL_NS 50000
 
-        // write result into result buffer
-        // (nontemporal hint -> doesn't modify the cache)
-        "movnti %%eax, (%[result],%[result_index],4);"
+/**
+ * @brief Time the main thread sleeps between two checks of the periodic
+ * statistics.
+ */
+#define STATS_POLL_NS 100000000
 
-        "mfence;"
-        "cpuid;" // serialize execution
-        /* -------------------------------------------------------------------*/
+/**
+ * @brief A frame whose probe takes more than this factor times the fastest
+ * probe counts as interrupted.
+ */
+#define PROFILE_INTERRUPT_FACTOR 2
 
-        "inc %[way];"          // way++
-        "inc %[result_index];" // result_index++
+/**
+ * @brief State of the probe thread of one CPU core.
+ */
+typedef struct probe_thread_s {
+    const profile_core_t *core;     /**< The profiled core. */
+    const profile_config_t *config; /**< Settings of the run. */
+    frame_ring_t ring;              /**< Ring to the writer thread. */
+    uint32_t *scratch; /**< Result buffer if the ring is full. */
+    start_gate_t *start; /**< Gate of the common start. */
+    uint32_t *threshold; /**< Threshold of the classification in the writer
+                            channel. */
+    frame_timing_report_t timing; /**< Breakdown of the time of the loop. */
+    probe_counters_t counters; /**< Counters which may be read while the
+                                  thread runs. */
+    atomic_int done;   /**< Set when the thread is finished. */
+    atomic_int *abort; /**< Set if any probe thread failed. */
+    pthread_t thread;  /**< The probe thread. */
+    error_t error;     /**< Error code of the probe thread. */
+} probe_thread_t;
 
-        // if way < associativity goto innerloop
-        "cmp %[way_count],%[way];"
-        "jl innerloop%=;"
+/**
+ * @brief Calibrates the threshold of the classification on a plan.
+ *
+ * @param plan the probed plan
+ * @param probe the probe kernel
+ * @param overhead overhead of the timer
+ * @param result room for one frame
+ *
+ * @return The threshold in cycles.
+ */
+static uint32_t calibrate_threshold(const probe_plan_t *plan,
+                                    probe_kernel_t probe, uint32_t overhead,
+                                    uint32_t *result) {
+    uint64_t histogram[CLASSIFY_HISTOGRAM_SIZE] = {0};
+    uintptr_t length = probe_plan_frame_length(plan);
 
-        "inc  %[set];" // set++
+    for (int i = 0; i < CLASSIFY_CALIBRATION_FRAMES; i++) {
+        prime(plan);
+        probe(plan, result, overhead);
+        classify_histogram_add(histogram, result, length);
+    }
 
-        // if set < set_count goto outerloop
-        "cmp %[set_count],%[set];"
-        "jl outerloop%=;"
-        : // no output
-        : [buffer] "r"(buffer), [result] "r"(result), [set] "r"(set),
-          [result_index] "r"(result_index), [way] "r"(way),
-          [buffer_offset] "r"(buffer_offset), [set_count] "r"(set_count),
-          [line_size] "r"(line_size), [way_count] "r"(way_count)
-        // "r" = stored in registers
-        : "memory", "eax", "ebx", "ecx", "edx", "rax", "rdx", "r8");
+    return classify_threshold(histogram);
 }
 
-error_t profile(const cache_info_t *cache, uint32_t cpu, uint32_t iterations,
-                const void *buffer, output_t *output) {
+/**
+ * @brief Main function of a probe thread.
+ *
+ * @param arg pointer to the probe_thread_t
+ *
+ * Binds the thread to its core, enables the cycle counter and calibrates the
+ * timer. Every thread reaches the start gate, even if it failed, so the main
+ * thread does not wait forever.
+ */
+static void *probe_run(void *arg) {
+    probe_thread_t *thread = arg;
+    const profile_config_t *config = thread->config;
+    const probe_plan_t *plan = thread->core->plan;
+    uint32_t cpu = thread->core->cpu;
+
+    error_t err = ERROR_NONE;
+    if (config->bind) {
+        err = focus_cpu_core(0, cpu);
+    }
 
-    uint32_t result[cache->total_size / cache->line_size];
     uint32_t fd_cycle;
-    FORWARD_ON_FAIL(enable_cpu_cycle_counter(&fd_cycle, cpu));
+    int counter = 0;
+    if (err == ERROR_NONE && config->timer == TIMER_RDPMC) {
+        err = enable_cpu_cycle_counter(&fd_cycle, cpu);
+        counter = err == ERROR_NONE;
+    }
+
+    cycle_timer_t timer = {config->timer, 0, 0};
+    if (err == ERROR_NONE) {
+        err = timer_calibrate(&timer, config->timer,
+                              TIMER_CALIBRATION_SAMPLES);
+    }
+
+    probe_kernel_t probe = probe_kernels[plan->granularity][timer.type];
+    probe_kernel_t probe_back =
+        probe_back_kernels[plan->granularity][timer.type];
+    prime_kernel_t prime_plan = prime_kernel(plan);
+
+    if (err != ERROR_NONE) {
+        atomic_store(thread->abort, 1);
+    } else {
+        printf("Using the %s timer on CPU %u (overhead %u cycles, jitter "
+               "%.2lf cycles).\n",
+               timer_name(timer.type), cpu, timer.overhead, timer.jitter);
+
+        // the writer reads the threshold after the first committed frame
+        int threshold = config->classify || config->aggregate;
+        if (threshold && !*thread->threshold) {
+            *thread->threshold = calibrate_threshold(
+                plan, probe, timer.overhead, thread->scratch);
+        }
+        if (threshold) {
+            printf("Classifying accesses above %u cycles on CPU %u as "
+                   "misses.\n",
+                   *thread->threshold, cpu);
+        }
+    }
+
+    // spin instead of sleeping, so all threads leave the gate at once
+    atomic_fetch_add(&thread->start->arrived, 1);
+    while (!atomic_load_explicit(&thread->start->open, memory_order_acquire)) {
+        _mm_pause();
+    }
+
+    // a fused probe primes the cache for the next frame, so only the first
+    // frame is primed
+    if (config->fused) {
+        prime_plan(plan);
+    }
 
-    for (int j = 0; (j < iterations || !iterations) && !terminated;
+    frame_timing_report_init(&thread->timing);
+    uint64_t frame = 0;
+    uint32_t iterations = config->iterations;
+    for (int j = 0; (j < iterations || !iterations) && !terminated &&
+                    !atomic_load_explicit(thread->abort,
+                                          memory_order_relaxed) &&
+                    !atomic_load_explicit(&thread->ring.failed,
+                                          memory_order_relaxed);
          j += (iterations ? 1 : 0)) {
-        prime(cache->line_size, cache->set_count, cache->ways_of_associativity,
-              cache->total_size, buffer);
+        uint32_t *result = frame_ring_reserve(&thread->ring);
+        if (result == NULL) {
+            result = thread->scratch;
+        }
+
+        frame_timing_t timing;
+        timing.monotonic_start = frame_timing_monotonic();
+        timing.tsc_start = __rdtsc();
+
+        if (!config->fused) {
+            prime_plan(plan);
+        }
+        uint64_t primed = __rdtsc();
         sched_yield();
-        probe(cache->line_size, cache->set_count, cache->ways_of_associativity,
-              buffer, result);
-        FORWARD_ON_FAIL(outputw_mat_ui32(
-            output, result, cache->ways_of_associativity, cache->set_count));
+        uint64_t yielded = __rdtsc();
+        // the direction alternates, so a probe starts with the cache lines
+        // which the previous probe loaded last
+        if (config->fused && frame++ % 2) {
+            probe_back(plan, result, timer.overhead);
+        } else {
+            probe(plan, result, timer.overhead);
+        }
+
+        timing.tsc_end = __rdtsc();
+        timing.monotonic_end = frame_timing_monotonic();
+        timing.prime = primed - timing.tsc_start;
+        timing.yield = yielded - primed;
+        timing.probe = timing.tsc_end - yielded;
+        frame_timing_report_add(&thread->timing, &timing);
+        counter_add(&thread->counters.frames, 1);
+        if (timing.probe >
+            (uint64_t)PROFILE_INTERRUPT_FACTOR * thread->timing.probe.min) {
+            counter_add(&thread->counters.interrupted, 1);
+        }
+
+        if (result != thread->scratch) {
+            frame_ring_commit(&thread->ring, &timing);
+        }
+    }
+
+    frame_ring_close(&thread->ring);
+
+    if (counter) {
+        error_t disable_err = disable_cpu_cycle_counter(fd_cycle);
+        if (err == ERROR_NONE) {
+            err = disable_err;
+        }
     }
 
-    FORWARD_ON_FAIL(disable_cpu_cycle_counter(fd_cycle));
+    thread->error = err;
+    atomic_store_explicit(&thread->done, 1, memory_order_release);
+    return NULL;
+}
+
+/**
+ * @brief Prints a line with the rates of all threads to stderr every
+ * interval until all probe threads are finished.
+ *
+ * @param threads the probe threads
+ * @param count amount of probe threads
+ * @param writer the writer thread
+ * @param interval seconds between two lines
+ *
+ * The rates cover the time since the previous line. The counters are read
+ * without a lock while the threads run.
+ */
+static void stats_follow(probe_thread_t *threads, uint32_t count,
+                         writer_t *writer, uint32_t interval) {
+    const struct timespec poll = {0, STATS_POLL_NS};
+    uint64_t start = frame_timing_monotonic();
+    uint64_t last = start;
+
+    // the previous frames of every probe thread and of the writer
+    uint64_t *previous = calloc(count + 1, sizeof(uint64_t));
+    uint64_t previous_busy = 0;
+    if (previous == NULL) {
+        return;
+    }
+
+    for (;;) {
+        int running = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            running |= !atomic_load_explicit(&threads[i].done,
+                                             memory_order_acquire);
+        }
+        if (!running) {
+            break;
+        }
+
+        nanosleep(&poll, NULL);
+        uint64_t now = frame_timing_monotonic();
+        if (now - last < interval * 1000000000ull) {
+            continue;
+        }
+
+        double seconds = (now - last) / 1e9;
+        fprintf(stderr, "[%.1lf s]", (now - start) / 1e9);
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t frames = counter_read(&threads[i].counters.frames);
+            fprintf(stderr, " CPU %u: %.0lf frames/s, %lu dropped, %lu "
+                            "interrupted |",
+                    threads[i].core->cpu, (frames - previous[i]) / seconds,
+                    atomic_load(&threads[i].ring.dropped),
+                    counter_read(&threads[i].counters.interrupted));
+            previous[i] = frames;
+        }
 
+        uint64_t frames = counter_read(&writer->counters.frames);
+        uint64_t busy = counter_read(&writer->counters.busy_ns);
+        fprintf(stderr, " writer: %.0lf frames/s, busy %.1lf%%\n",
+                (frames - previous[count]) / seconds,
+                100 * (busy - previous_busy) / 1e9 / seconds);
+        previous[count] = frames;
+        previous_busy = busy;
+        last = now;
+    }
+
+    free(previous);
+}
+
+/**
+ * @brief Frees the histograms of histograms_new.
+ *
+ * @param histograms the histograms or NULL
+ * @param count amount of histograms
+ */
+static void histograms_free(stats_t *histograms, uintptr_t count) {
+    if (histograms == NULL) {
+        return;
+    }
+    for (uintptr_t i = 0; i < count; i++) {
+        stats_free(histograms + i);
+    }
+    free(histograms);
+}
+
+/**
+ * @brief Allocates one empty histogram per set.
+ *
+ * @param histograms writes a pointer to the histograms into
+ * @param count amount of sets
+ * @param bins amount of bins of every histogram
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t histograms_new(stats_t **histograms, uintptr_t count,
+                              uint32_t bins) {
+    *histograms = calloc(count, sizeof(stats_t));
+    if (*histograms == NULL) {
+        return ERROR_ALLOCATION;
+    }
+
+    for (uintptr_t i = 0; i < count; i++) {
+        if (stats_new(*histograms + i, bins) != ERROR_NONE) {
+            histograms_free(*histograms, i);
+            *histograms = NULL;
+            return ERROR_ALLOCATION;
+        }
+    }
     return ERROR_NONE;
 }
 
-int cmpfunc(const void *a, const void *b) { return (*(int *)a - *(int *)b); }
+error_t profile(const profile_core_t *cores, uint32_t core_count,
+                const profile_config_t *config) {
+    probe_thread_t *threads = calloc(core_count, sizeof(probe_thread_t));
+    writer_channel_t *channels = calloc(core_count, sizeof(writer_channel_t));
+    if (threads == NULL || channels == NULL) {
+        free(threads);
+        free(channels);
+        return ERROR_ALLOCATION;
+    }
+
+    atomic_int abort;
+    atomic_init(&abort, 0);
+
+    error_t err = ERROR_NONE;
+    uint32_t ready = 0;
+    for (; ready < core_count; ready++) {
+        const probe_plan_t *plan = cores[ready].plan;
+        uintptr_t frame_length = probe_plan_frame_length(plan);
+        uintptr_t ring_size = config->ring_size;
+        if (!ring_size) {
+            ring_size = RING_DEFAULT_SIZE / core_count /
+                        (frame_length * sizeof(uint32_t));
+        }
+
+        probe_thread_t *thread = threads + ready;
+        thread->core = cores + ready;
+        thread->config = config;
+        thread->abort = &abort;
+        probe_counters_init(&thread->counters);
+        atomic_init(&thread->done, 0);
+
+        if ((err = frame_ring_new(&thread->ring, frame_length, ring_size,
+                                  config->arena))) {
+            break;
+        }
+
+        // the probe still runs if the ring is full, so the timing of the loop
+        // stays the same
+        thread->scratch = malloc(frame_length * sizeof(uint32_t));
+        if (thread->scratch == NULL) {
+            frame_ring_free(&thread->ring);
+            err = ERROR_ALLOCATION;
+            break;
+        }
+
+        writer_channel_t *channel = channels + ready;
+        if (config->classify && !config->aggregate) {
+            channel->bitmaps = malloc(classify_bitmap_size(frame_length) *
+                                      thread->ring.capacity);
+            if (channel->bitmaps == NULL) {
+                free(thread->scratch);
+                frame_ring_free(&thread->ring);
+                err = ERROR_ALLOCATION;
+                break;
+            }
+        }
+        channel->threshold = cores[ready].threshold;
+        channel->limit = cores[ready].limit;
+        thread->threshold = &channel->threshold;
+        channel->ring = &thread->ring;
+        channel->output = cores[ready].output;
+        channel->dim_y = plan->set_count;
+        if (plan->granularity == PLAN_GRANULARITY_SET) {
+            channel->rank = 1;
+            channel->dim_x = 1;
+        } else {
+            channel->rank = 2;
+            channel->dim_x = plan->way_count;
+        }
+
+        if (config->histograms != HISTOGRAMS_OFF) {
+            uint32_t bins = channel->rank == 1 ? PROFILE_HISTOGRAM_SET_BINS
+                                               : PROFILE_HISTOGRAM_BINS;
+            if ((err = histograms_new(&channel->histograms, channel->dim_y,
+                                      bins))) {
+                free(channel->bitmaps);
+                free(thread->scratch);
+                frame_ring_free(&thread->ring);
+                break;
+            }
+            channel->skip_frames = config->histograms == HISTOGRAMS_ONLY;
+        }
+
+        if (config->aggregate) {
+            channel->aggregate = malloc(sizeof(aggregate_t));
+            err = channel->aggregate == NULL
+                      ? ERROR_ALLOCATION
+                      : aggregate_new(channel->aggregate, frame_length,
+                                      config->aggregate);
+            if (err != ERROR_NONE) {
+                free(channel->aggregate);
+                histograms_free(channel->histograms, channel->dim_y);
+                free(channel->bitmaps);
+                free(thread->scratch);
+                frame_ring_free(&thread->ring);
+                break;
+            }
+        }
+    }
+
+    writer_t writer;
+    if (err == ERROR_NONE) {
+        err = writer_start(&writer, channels, core_count, config->writer_cpu);
+    }
+
+    if (err == ERROR_NONE) {
+        start_gate_t start;
+        atomic_init(&start.arrived, 0);
+        atomic_init(&start.open, 0);
+
+        uint32_t started = 0;
+        for (; started < core_count; started++) {
+            threads[started].start = &start;
+            err = thread_start_masked(&threads[started].thread, probe_run,
+                                      threads + started);
+            if (err != ERROR_NONE) {
+                atomic_store(&abort, 1);
+                break;
+            }
+        }
+
+        const struct timespec poll = {0, START_GATE_POLL_NS};
+        while (atomic_load(&start.arrived) < started) {
+            nanosleep(&poll, NULL);
+        }
+        atomic_store_explicit(&start.open, 1, memory_order_release);
+        uint64_t started_ns = frame_timing_monotonic();
+
+        if (config->stats_interval && err == ERROR_NONE) {
+            stats_follow(threads, started, &writer, config->stats_interval);
+        }
+
+        for (uint32_t i = 0; i < started; i++) {
+            pthread_join(threads[i].thread, NULL);
+            if (err == ERROR_NONE) {
+                err = threads[i].error;
+            }
+        }
+
+        error_t writer_err = writer_stop(&writer);
+        if (err == ERROR_NONE) {
+            err = writer_err;
+        }
+
+        if (config->stats) {
+            double seconds = (frame_timing_monotonic() - started_ns) / 1e9;
+            fprintf(stderr, "Profiler statistics after %.3lf s:\n", seconds);
+            for (uint32_t i = 0; i < started; i++) {
+                probe_counters_print(&threads[i].counters, cores[i].cpu,
+                                     atomic_load(&threads[i].ring.dropped),
+                                     seconds, stderr);
+            }
+            writer_counters_print(&writer.counters, seconds, stderr);
+        }
+
+        // the writer has stopped, so the main thread may use the outputs
+        for (uint32_t i = 0; i < core_count && err == ERROR_NONE; i++) {
+            writer_channel_t *channel = channels + i;
+            if (channel->aggregate != NULL && channel->aggregate->frames) {
+                err = outputw_window(channel->output, channel->aggregate,
+                                     channel->rank, channel->dim_x,
+                                     channel->dim_y, channel->threshold);
+            }
+        }
+        for (uint32_t i = 0; i < core_count && err == ERROR_NONE; i++) {
+            if (channels[i].histograms != NULL) {
+                err = outputw_histograms(channels[i].output,
+                                         channels[i].histograms,
+                                         channels[i].dim_y);
+            }
+        }
+
+        for (uint32_t i = 0; i < core_count; i++) {
+            frame_timing_report_print(&threads[i].timing, cores[i].cpu,
+                                      stdout);
+
+            frame_ring_t *ring = &threads[i].ring;
+            uintptr_t dropped = atomic_load(&ring->dropped);
+            if (dropped) {
+                printf("Dropped %lu of %lu frames on CPU %u, because the "
+                       "output could not keep up. Increase the ring size "
+                       "with --ring.\n",
+                       dropped, dropped + atomic_load(&ring->head),
+                       cores[i].cpu);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < ready; i++) {
+        free(threads[i].scratch);
+        free(channels[i].bitmaps);
+        histograms_free(channels[i].histograms, channels[i].dim_y);
+        if (channels[i].aggregate != NULL) {
+            aggregate_free(channels[i].aggregate);
+            free(channels[i].aggregate);
+        }
+        frame_ring_free(&threads[i].ring);
+    }
+    free(threads);
+    free(channels);
+
+    return err;
+}
+
+/**
+ * @brief Amount of measurements which are buffered at once by benchmark.
+ */
+#define BENCHMARK_BATCH 65536
+
+error_t benchmark(uint64_t iterations, uint32_t cpu) {
+    uint64_t batch = iterations < BENCHMARK_BATCH ? iterations
+                                                  : BENCHMARK_BATCH;
+    uint32_t *result = malloc(batch * sizeof(uint32_t));
+    stats_t stats;
+    if (result == NULL || stats_new(&stats, STATS_DEFAULT_BINS)) {
+        free(result);
+        return ERROR_ALLOCATION;
+    }
 
-error_t benchmark(uint64_t iterations) {
-    uint32_t *result = malloc(iterations * sizeof(uint32_t));
     uint32_t fd_cycle;
+    int has_rdpmc = can_use_rdpmc() == ERROR_NONE;
+    if (has_rdpmc) {
+        error_t err = enable_cpu_cycle_counter(&fd_cycle, cpu);
+        if (err != ERROR_NONE) {
+            stats_free(&stats);
+            free(result);
+            return err;
+        }
+    }
 
-    FORWARD_ON_FAIL(enable_cpu_cycle_counter(&fd_cycle, 0));
-    uint64_t buffer[1];
+    uint64_t buffer[8] __attribute__((aligned(64))) = {0};
+    error_t err = ERROR_NONE;
 
-    for (uint64_t result_index = 0; result_index < iterations; result_index++) {
-        asm volatile(
-            "cpuid;" // serialize execution
-            "mov $1073741825, %%ecx;"
-            "rdpmc;" // pseudo serialize and load timestamps into edx:eax
-            "mov %%eax, %%r8d;" // save the lower 32 bit of the first timestamp
+    for (timer_type_t type = 0; type < TIMER_COUNT; type++) {
+        if (type == TIMER_RDPMC && !has_rdpmc) {
+            printf("%s timer: not available in userspace\n", timer_name(type));
+            continue;
+        }
 
-            "mfence;"
-            "mov (%[buffer]), %%rax;" // access the memory
-            "mfence;"
+        cycle_timer_t timer;
+        if ((err = timer_calibrate(&timer, type, iterations))) {
+            break;
+        }
+
+        printf("%s timer:\n", timer_name(type));
+        printf("  overhead: %u cycles\n", timer.overhead);
+        printf("  jitter: %lf cycles\n", timer.jitter);
+
+        uint32_t median[2];
+        for (int flush = 0; flush < 2; flush++) {
+            printf(" cache %s (overhead subtracted):\n",
+                   flush ? "miss" : "hit");
+
+            stats_reset(&stats);
+            for (uint64_t done = 0; done < iterations; done += batch) {
+                uint64_t count =
+                    iterations - done < batch ? iterations - done : batch;
+                timer_measure_load(type, timer.overhead, buffer, flush, count,
+                                   result);
+                stats_add_values(&stats, result, count);
+            }
+            stats_print(&stats, stdout);
+            median[flush] = stats_percentile(&stats, 0.5);
+        }
+
+        printf(" hit and miss are %s (median %u vs. %u cycles)\n\n",
+               median[0] < median[1] ? "separable" : "NOT separable",
+               median[0], median[1]);
+    }
+
+    if (has_rdpmc) {
+        error_t disable_err = disable_cpu_cycle_counter(fd_cycle);
+        if (err == ERROR_NONE) {
+            err = disable_err;
+        }
+    }
+
+    stats_free(&stats);
+    free(result);
+    return err;
+}
+
+/**
+ * @brief Amount of frames in one batch of benchmark_output.
+ */
+#define BENCHMARK_OUTPUT_BATCH 64
+
+/**
+ * @brief Duration of the benchmark of one format in nanoseconds.
+ */
+#define BENCHMARK_OUTPUT_NS 500000000UL
+
+/**
+ * @brief Returns the monotonic time in nanoseconds.
+ */
+static uint64_t benchmark_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000UL + now.tv_nsec;
+}
 
-            "mov $1073741825, %%ecx;"
-            "rdpmc;" // pseudo serialize and load timestamps into edx:eax
-            "sub %%r8d, %%eax;" // r8 = eax-r8 (end - start)
+error_t benchmark_output(const cache_info_t *cache) {
+    uintptr_t frame_size =
+        (uintptr_t)cache->set_count * cache->ways_of_associativity;
+    uint32_t *frames =
+        malloc(sizeof(uint32_t) * frame_size * BENCHMARK_OUTPUT_BATCH);
+    uint64_t *clocks = malloc(sizeof(uint64_t) * BENCHMARK_OUTPUT_BATCH);
+    if (frames == NULL || clocks == NULL) {
+        free(frames);
+        free(clocks);
+        return ERROR_ALLOCATION;
+    }
 
-            // write result into result buffer
-            // (nontemporal hint -> doesn't modify the cache)
-            "movnti %%eax, (%[result],%[result_index],4);"
+    FILE *null = fopen("/dev/null", "w");
+    if (null == NULL) {
+        free(frames);
+        free(clocks);
+        return ERROR_IO;
+    }
 
-            "mfence;"
-            "cpuid;" // serialize execution
-            :        // no output
-            : [buffer] "r"(buffer), [result] "r"(result),
-              [result_index] "r"(result_index)
-            // "r" = stored in registers
-            : "memory", "eax", "ebx", "ecx", "edx", "rax", "rdx", "r8");
+    // plausible access times: mostly hits and a few misses
+    srand(0);
+    for (uintptr_t i = 0; i < frame_size * BENCHMARK_OUTPUT_BATCH; i++) {
+        frames[i] = rand() % 16 ? 30 + rand() % 20 : 150 + rand() % 200;
     }
 
-    FORWARD_ON_FAIL(disable_cpu_cycle_counter(fd_cycle));
+    printf("output of %u sets x %u ways per frame:\n", cache->set_count,
+           cache->ways_of_associativity);
 
-    // sort all results
-    qsort(result, iterations, sizeof(uint32_t), cmpfunc);
+    error_t err = ERROR_NONE;
+    for (output_format_t format = OUTPUT_FORMAT_TEXT;
+         format <= OUTPUT_FORMAT_NDJSON && err == ERROR_NONE; format++) {
+        output_t output;
+        if ((err = outputc_stdout(&output, null))) {
+            break;
+        }
+        output_set_format(&output, format);
+        output_set_cpu(&output, cache->cpu_id);
+
+        uint64_t count = 0;
+        uint64_t start = benchmark_now();
+        uint64_t elapsed = 0;
 
-    // calculate median
-    double middle = iterations / 2;
-    uint32_t median = 0;
-    if (floor(middle) == ceil(middle)) {
-        median = result[(size_t)middle];
+        while (err == ERROR_NONE && elapsed < BENCHMARK_OUTPUT_NS) {
+            for (uint32_t i = 0; i < BENCHMARK_OUTPUT_BATCH; i++) {
+                clocks[i] = count + i;
+            }
+            err = outputw_mats_ui32(&output, frames, clocks,
+                                    BENCHMARK_OUTPUT_BATCH,
+                                    cache->ways_of_associativity,
+                                    cache->set_count);
+            count += BENCHMARK_OUTPUT_BATCH;
+            elapsed = benchmark_now() - start;
+        }
+
+        error_t close_err = output_close(&output);
+        if (err == ERROR_NONE) {
+            err = close_err;
+        }
+
+        if (err == ERROR_NONE) {
+            printf("  %s: %.0lf frames/s\n", output_format_name(format),
+                   count * 1e9 / elapsed);
+        }
+    }
+
+    fclose(null);
+    free(frames);
+    free(clocks);
+    return err;
+}
+
+/**
+ * @brief Smallest working set of benchmark_latency.
+ */
+#define LADDER_MIN_SIZE 4096UL
+
+/**
+ * @brief Largest working set of benchmark_latency.
+ */
+#define LADDER_MAX_SIZE (1UL << 30)
+
+/**
+ * @brief Amount of timed loads per working set of benchmark_latency.
+ */
+#define LADDER_LOADS (1UL << 22)
+
+/**
+ * @brief Factor by which the latency has to rise across the size of a cache
+ * so benchmark_latency confirms the cache.
+ */
+#define LADDER_STEP 1.2
+
+/**
+ * @brief Reads the cycle counter of benchmark_latency.
+ *
+ * @param has_rdpmc if not zero the cycle counter of the performance
+ * monitoring unit is read, otherwise the timestamp counter
+ */
+static uint64_t ladder_cycles(int has_rdpmc) {
+    uint32_t low, high;
+    if (has_rdpmc) {
+        asm volatile("lfence;"
+                     "mov " TIMER_RDPMC_COUNTER ", %%ecx;"
+                     "rdpmc;"
+                     : "=a"(low), "=d"(high)
+                     : /* no input */
+                     : "rcx");
     } else {
-        median = result[((size_t)floor(middle)) + 1];
+        asm volatile("rdtscp;" : "=a"(low), "=d"(high) : : "rcx");
+    }
+    return (uint64_t)high << 32 | low;
+}
+
+/**
+ * @brief Links the cache lines of a working set into one random cycle.
+ *
+ * @param buffer start of the working set
+ * @param count amount of cache lines
+ * @param line_size size of a cache line
+ * @param order scratch space for @p count indexes
+ *
+ * The first 8 bytes of every cache line hold the address of the next one.
+ * The random order keeps the prefetchers from predicting the next line.
+ */
+static void ladder_link(uint8_t *buffer, uint32_t count, uint32_t line_size,
+                        uint32_t *order) {
+    unsigned int seed = time(NULL) ^ getpid();
+    for (uint32_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    // Fisher-Yates shuffle
+    for (uint32_t i = count - 1; i > 0; i--) {
+        uint32_t j =
+            ((uint64_t)rand_r(&seed) * (RAND_MAX + 1UL) + rand_r(&seed)) %
+            (i + 1);
+        uint32_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t *next = buffer + (uintptr_t)order[(i + 1) % count] * line_size;
+        *(uint8_t **)(buffer + (uintptr_t)order[i] * line_size) = next;
+    }
+}
+
+/**
+ * @brief Follows a pointer chain.
+ *
+ * @param start the first cache line
+ * @param loads amount of loads
+ *
+ * Every load depends on the previous one, so the loads can not overlap.
+ *
+ * @return The last cache line, which keeps the chain from being optimized
+ * out.
+ */
+static uint8_t *ladder_chase(uint8_t *start, uint64_t loads) {
+    uint8_t *line = start;
+    for (uint64_t i = 0; i < loads; i++) {
+        line = *(uint8_t *volatile *)line;
+    }
+    return line;
+}
+
+/**
+ * @brief Formats a size with the largest binary unit which divides it.
+ *
+ * @param text the buffer of the text
+ * @param length size of @p text
+ * @param size the size in bytes
+ *
+ * @return @p text
+ */
+static const char *ladder_size(char *text, size_t length, uint64_t size) {
+    if (size >= (1UL << 30) && !(size % (1UL << 30))) {
+        snprintf(text, length, "%lu GiB", size >> 30);
+    } else if (size >= (1UL << 20) && !(size % (1UL << 20))) {
+        snprintf(text, length, "%lu MiB", size >> 20);
+    } else {
+        snprintf(text, length, "%lu KiB", size >> 10);
+    }
+    return text;
+}
+
+error_t benchmark_latency(const cache_info_t *caches, uint32_t level_count,
+                          uint32_t cpu) {
+    uint32_t line_size = level_count ? caches[0].line_size : 64;
+
+    // the ladder ends at the largest working set with enough hugepages
+    uint64_t max_size = LADDER_MAX_SIZE;
+    uint8_t *buffer = NULL;
+    error_t err = ERROR_NONE;
+    while (max_size >= LADDER_MIN_SIZE &&
+           (err = alloc_huge((void **)&buffer, max_size)) != ERROR_NONE) {
+        if (err != ERROR_NO_HUGEPAGES && err != ERROR_MMAP) {
+            return err;
+        }
+        max_size /= 2;
+    }
+    if (max_size < LADDER_MIN_SIZE) {
+        printf("latency ladder: no hugepages reserved\n");
+        return ERROR_NONE;
+    }
+    char text[2][24];
+    if (max_size < LADDER_MAX_SIZE) {
+        printf("WARNING: the reserved hugepages limit the latency ladder to "
+               "%s.\n",
+               ladder_size(text[0], sizeof(text[0]), max_size));
+    }
+
+    uint32_t size_count = 0;
+    for (uint64_t size = LADDER_MIN_SIZE; size <= max_size; size *= 2) {
+        size_count++;
+    }
+    uint32_t *order = malloc(sizeof(uint32_t) * (max_size / line_size));
+    double *latency = malloc(sizeof(double) * size_count);
+    if (order == NULL || latency == NULL) {
+        free(order);
+        free(latency);
+        free_huge(buffer, max_size);
+        return ERROR_ALLOCATION;
     }
-    printf("median: %u\n", median);
 
-    // calculate arithmetic_mean
-    uint64_t accumulator = 0;
-    for (uint32_t i = 0; i < iterations; i++) {
-        accumulator += result[i];
+    uint32_t fd_cycle;
+    int has_rdpmc = can_use_rdpmc() == ERROR_NONE;
+    if (has_rdpmc && (err = enable_cpu_cycle_counter(&fd_cycle, cpu))) {
+        free(order);
+        free(latency);
+        free_huge(buffer, max_size);
+        return err;
     }
-    double arithmetic_mean = accumulator / ((double)(iterations));
-    printf("arithmetic mean: %lf\n", arithmetic_mean);
 
-    // calculate the empirical variance
-    double s2 = 0;
-    for (uint32_t i = 0; i < iterations; i++) {
-        s2 = pow(((double)result[i]) - arithmetic_mean, 2);
+    printf("latency ladder (%s cycles per load):\n",
+           has_rdpmc ? "rdpmc" : "rdtscp");
+    uint64_t size = LADDER_MIN_SIZE;
+    for (uint32_t i = 0; i < size_count; i++, size *= 2) {
+        uint32_t count = size / line_size;
+        ladder_link(buffer, count, line_size, order);
+
+        // one pass over the chain loads the working set into the caches
+        uint8_t *line = ladder_chase(
+            buffer, count < LADDER_LOADS ? count : LADDER_LOADS);
+
+        uint64_t start = ladder_cycles(has_rdpmc);
+        line = ladder_chase(line, LADDER_LOADS);
+        uint64_t end = ladder_cycles(has_rdpmc);
+        latency[i] = (double)(end - start) / LADDER_LOADS;
+        asm volatile("" : : "r"(line));
+
+        printf("  %8s: %.2lf\n", ladder_size(text[0], sizeof(text[0]), size),
+               latency[i]);
     }
-    s2 = s2 / (((double)(iterations)) - 1.0);
-    printf("empirical variance: %lf\n", s2);
 
-    int over_1000_counter = 0;
-    int other_median_counter = 0;
-    for (int i = 0; i < iterations; i++) {
-        if (result[i] != median) {
-            other_median_counter++;
+    // every cache should hold a working set of half its size and add a step
+    // at twice its size
+    printf("cache geometry:\n");
+    for (uint32_t l = 0; l < level_count; l++) {
+        uint64_t total = caches[l].total_size;
+        int inside = -1;
+        int outside = -1;
+        size = LADDER_MIN_SIZE;
+        for (uint32_t i = 0; i < size_count; i++, size *= 2) {
+            if (size <= total / 2) {
+                inside = i;
+            }
+            if (size >= 2 * total && outside < 0) {
+                outside = i;
+            }
         }
-        if (result[i] > 1000) {
-            over_1000_counter++;
+
+        printf("  L%u (%s): ", caches[l].level,
+               ladder_size(text[0], sizeof(text[0]), total));
+        if (inside < 0 || outside < 0) {
+            printf("not covered by the latency ladder\n");
+            continue;
+        }
+
+        ladder_size(text[0], sizeof(text[0]), LADDER_MIN_SIZE << inside);
+        ladder_size(text[1], sizeof(text[1]), LADDER_MIN_SIZE << outside);
+        if (latency[outside] >= LADDER_STEP * latency[inside]) {
+            printf("%.2lf cycles at %s, %.2lf cycles at %s, matches\n",
+                   latency[inside], text[0], latency[outside], text[1]);
+        } else {
+            printf("WARNING no latency step between %s and %s, the reported "
+                   "geometry does not match\n",
+                   text[0], text[1]);
         }
     }
-    printf("%d values are bigger than 1000 (probably reschedules)\n",
-           over_1000_counter);
-    printf("%d values differ from the median(%%%lf)\n", other_median_counter,
-           other_median_counter / (double)iterations);
 
-    free(result);
-    return ERROR_NONE;
+    if (has_rdpmc) {
+        err = disable_cpu_cycle_counter(fd_cycle);
+    }
+
+    free(order);
+    free(latency);
+    error_t free_err = free_huge(buffer, max_size);
+    return err != ERROR_NONE ? err : free_err;
+}
+
+/**
+ * @brief Amount of frames of every mode of benchmark_fused.
+ */
+#define FUSED_FRAMES 2000
+
+/**
+ * @brief Every this many sets are touched by the victim of benchmark_fused.
+ */
+#define FUSED_VICTIM_STRIDE 4
+
+/**
+ * @brief Largest difference of the detection rates of both modes of
+ * benchmark_fused which still counts as a match.
+ */
+#define FUSED_TOLERANCE 0.1
+
+/**
+ * @brief Loads half of the ways of every FUSED_VICTIM_STRIDE-th set.
+ */
+static void fused_victim(const uint8_t *victim, const cache_info_t *cache) {
+    uint32_t ways = (cache->ways_of_associativity + 1) / 2;
+    uintptr_t way_size = (uintptr_t)cache->set_count * cache->line_size;
+    for (uint32_t way = 0; way < ways; way++) {
+        const uint8_t *lines = victim + way * way_size;
+        for (uint32_t set = 0; set < cache->set_count;
+             set += FUSED_VICTIM_STRIDE) {
+            *(volatile const uint8_t *)(lines + set * cache->line_size);
+        }
+    }
+}
+
+/**
+ * @brief Allocates the probe buffer and the victim buffer of a benchmark.
+ *
+ * @param cache the cache which the buffers correspond to
+ * @param buffer writes the probe buffer into
+ * @param victim writes the victim buffer into
+ * @param name name of the benchmark, which is printed if it is skipped
+ *
+ * Without enough hugepages the benchmark is skipped like the latency ladder,
+ * so the other benchmarks still run on hosts without hugepages.
+ *
+ * @retval ERROR_NO_HUGEPAGES if the benchmark is skipped
+ * @retval ERROR_NONE
+ * @return The other errors of alloc_aligned.
+ */
+static error_t bench_buffers(const cache_info_t *cache, void **buffer,
+                             void **victim, const char *name) {
+    error_t err = alloc_aligned(buffer, cache);
+    if (err == ERROR_NONE && (err = alloc_aligned(victim, cache))) {
+        free_aligned(*buffer, cache);
+    }
+
+    if (err == ERROR_NO_HUGEPAGES || err == ERROR_MMAP) {
+        printf("%s: no hugepages reserved\n", name);
+        return ERROR_NO_HUGEPAGES;
+    }
+    return err;
+}
+
+error_t benchmark_fused(const cache_info_t *cache, timer_type_t type,
+                        uint32_t cpu) {
+    void *buffer;
+    void *victim;
+    error_t err = bench_buffers(cache, &buffer, &victim, "fused probe");
+    if (err != ERROR_NONE) {
+        return err == ERROR_NO_HUGEPAGES ? ERROR_NONE : err;
+    }
+
+    probe_plan_t plan;
+    if ((err = probe_plan_new(&plan, cache, buffer, NULL, 0, NULL, 0,
+                              PLAN_ORDER_LINEAR, PLAN_GRANULARITY_LINE,
+                              NULL))) {
+        free_aligned(victim, cache);
+        free_aligned(buffer, cache);
+        return err;
+    }
+
+    uint32_t ways = cache->ways_of_associativity;
+    uint32_t *samples = malloc(sizeof(uint32_t) * plan.count);
+    // frames with a miss in a set, [0] separate and [1] fused
+    uint64_t *detected = calloc(2 * (uintptr_t)cache->set_count,
+                                sizeof(uint64_t));
+    if (samples == NULL || detected == NULL) {
+        err = ERROR_ALLOCATION;
+    }
+
+    // without a usable cycle counter the timestamp counter is used
+    uint32_t fd_cycle;
+    int counter = 0;
+    if (type == TIMER_RDPMC && can_use_rdpmc() != ERROR_NONE) {
+        type = TIMER_RDTSCP;
+    }
+    if (err == ERROR_NONE && type == TIMER_RDPMC) {
+        err = enable_cpu_cycle_counter(&fd_cycle, cpu);
+        counter = err == ERROR_NONE;
+    }
+
+    cycle_timer_t timer;
+    if (err == ERROR_NONE) {
+        err = timer_calibrate(&timer, type, TIMER_CALIBRATION_SAMPLES);
+    }
+
+    double rate[2] = {0};
+    uint32_t threshold = 0;
+    if (err == ERROR_NONE) {
+        probe_kernel_t probe = probe_kernels[PLAN_GRANULARITY_LINE][type];
+        probe_kernel_t probe_back =
+            probe_back_kernels[PLAN_GRANULARITY_LINE][type];
+        threshold =
+            calibrate_threshold(&plan, probe, timer.overhead, samples);
+
+        for (int fused = 0; fused < 2; fused++) {
+            uint64_t *sets = detected + fused * cache->set_count;
+            uint64_t elapsed = 0;
+
+            if (fused) {
+                prime(&plan);
+            }
+            for (uint32_t frame = 0; frame < FUSED_FRAMES; frame++) {
+                uint64_t start = benchmark_now();
+                if (!fused) {
+                    prime(&plan);
+                }
+                elapsed += benchmark_now() - start;
+
+                fused_victim(victim, cache);
+
+                start = benchmark_now();
+                if (fused && frame % 2) {
+                    probe_back(&plan, samples, timer.overhead);
+                } else {
+                    probe(&plan, samples, timer.overhead);
+                }
+                elapsed += benchmark_now() - start;
+
+                for (uint32_t set = 0; set < cache->set_count; set++) {
+                    uint32_t miss = 0;
+                    for (uint32_t way = 0; way < ways; way++) {
+                        miss |= samples[set * ways + way] > threshold;
+                    }
+                    sets[set] += miss;
+                }
+            }
+            rate[fused] = FUSED_FRAMES * 1e9 / elapsed;
+        }
+    }
+
+    if (counter) {
+        error_t disable_err = disable_cpu_cycle_counter(fd_cycle);
+        if (err == ERROR_NONE) {
+            err = disable_err;
+        }
+    }
+
+    if (err == ERROR_NONE) {
+        // the detection rates of the victim sets and of the idle sets
+        double victim_rate[2] = {0};
+        double idle_rate[2] = {0};
+        double max_diff = 0;
+        uint32_t victim_sets = 0;
+        for (uint32_t set = 0; set < cache->set_count; set++) {
+            double separate = (double)detected[set] / FUSED_FRAMES;
+            double fused =
+                (double)detected[cache->set_count + set] / FUSED_FRAMES;
+            if (set % FUSED_VICTIM_STRIDE) {
+                idle_rate[0] += separate;
+                idle_rate[1] += fused;
+            } else {
+                victim_rate[0] += separate;
+                victim_rate[1] += fused;
+                victim_sets++;
+            }
+            double diff = fabs(separate - fused);
+            max_diff = diff > max_diff ? diff : max_diff;
+        }
+        uint32_t idle_sets = cache->set_count - victim_sets;
+
+        printf("fused prime+probe of %u sets x %u ways (threshold %u "
+               "cycles, a victim in half of the ways of every %u. set):\n",
+               cache->set_count, ways, threshold, FUSED_VICTIM_STRIDE);
+        for (int fused = 0; fused < 2; fused++) {
+            printf("  %-8s %.0lf frames/s, detected %.1lf%% of the victim "
+                   "sets and %.1lf%% of the idle sets\n",
+                   fused ? "fused:" : "separate:", rate[fused],
+                   100 * victim_rate[fused] / victim_sets,
+                   idle_sets ? 100 * idle_rate[fused] / idle_sets : 0);
+        }
+        double gap = fabs(victim_rate[0] - victim_rate[1]) / victim_sets;
+        if (idle_sets) {
+            double idle_gap = fabs(idle_rate[0] - idle_rate[1]) / idle_sets;
+            gap = idle_gap > gap ? idle_gap : gap;
+        }
+        printf("  the detection rates of a set differ by at most %.1lf%%\n",
+               100 * max_diff);
+        // without a visible victim both modes only measure noise
+        double visible = victim_rate[0] / victim_sets;
+        if (idle_sets) {
+            visible -= idle_rate[0] / idle_sets;
+        }
+        if (visible < FUSED_TOLERANCE) {
+            printf("  WARNING: the separate prime+probe does not see the "
+                   "victim, the comparison is inconclusive\n");
+        } else if (gap <= FUSED_TOLERANCE) {
+            printf("  the fused probe matches the separate prime+probe\n");
+        } else {
+            printf("  WARNING: the fused probe does not match the separate "
+                   "prime+probe, use it only with care\n");
+        }
+    }
+
+    free(samples);
+    free(detected);
+    probe_plan_free(&plan);
+    free_aligned(victim, cache);
+    free_aligned(buffer, cache);
+    return err;
+}
+
+/**
+ * @brief Amount of primes which are timed per kernel in benchmark_prime.
+ */
+#define PRIME_ROUNDS 256
+
+/**
+ * @brief Amount of primes after a victim per kernel in benchmark_prime.
+ */
+#define PRIME_EVICTION_ROUNDS 32
+
+/**
+ * @brief Share of the victim lines which has to be evicted by a prime.
+ */
+#define PRIME_EVICTION_MIN 0.9
+
+error_t benchmark_prime(const cache_info_t *cache, timer_type_t type,
+                        uint32_t cpu) {
+    void *buffer;
+    void *victim;
+    error_t err = bench_buffers(cache, &buffer, &victim, "prime");
+    if (err != ERROR_NONE) {
+        return err == ERROR_NO_HUGEPAGES ? ERROR_NONE : err;
+    }
+
+    probe_plan_t plan;
+    probe_plan_t victim_plan;
+    if ((err = probe_plan_new(&plan, cache, buffer, NULL, 0, NULL, 0,
+                              PLAN_ORDER_LINEAR, PLAN_GRANULARITY_LINE,
+                              NULL))) {
+        free_aligned(victim, cache);
+        free_aligned(buffer, cache);
+        return err;
+    }
+    if ((err = probe_plan_new(&victim_plan, cache, victim, NULL, 0, NULL,
+                              0, PLAN_ORDER_LINEAR, PLAN_GRANULARITY_LINE,
+                              NULL))) {
+        probe_plan_free(&plan);
+        free_aligned(victim, cache);
+        free_aligned(buffer, cache);
+        return err;
+    }
+
+    uint32_t *samples = malloc(sizeof(uint32_t) * plan.count);
+    stats_t victims;
+    stats_t primed;
+    int has_stats = 0;
+    if (samples == NULL) {
+        err = ERROR_ALLOCATION;
+    } else if (stats_new(&victims, STATS_DEFAULT_BINS)) {
+        err = ERROR_ALLOCATION;
+    } else if (stats_new(&primed, STATS_DEFAULT_BINS)) {
+        stats_free(&victims);
+        err = ERROR_ALLOCATION;
+    } else {
+        has_stats = 1;
+    }
+
+    // without a usable cycle counter the timestamp counter is used
+    uint32_t fd_cycle;
+    int counter = 0;
+    if (type == TIMER_RDPMC && can_use_rdpmc() != ERROR_NONE) {
+        type = TIMER_RDTSCP;
+    }
+    if (err == ERROR_NONE && type == TIMER_RDPMC) {
+        err = enable_cpu_cycle_counter(&fd_cycle, cpu);
+        counter = err == ERROR_NONE;
+    }
+
+    cycle_timer_t timer;
+    if (err == ERROR_NONE) {
+        err = timer_calibrate(&timer, type, TIMER_CALIBRATION_SAMPLES);
+    }
+
+    if (err == ERROR_NONE) {
+        probe_kernel_t probe = probe_kernels[PLAN_GRANULARITY_LINE][type];
+        uint32_t threshold =
+            calibrate_threshold(&plan, probe, timer.overhead, samples);
+
+        const struct {
+            const char *name;
+            prime_kernel_t kernel;
+        } kernels[] = {{"fenced", prime_lines_fenced},
+                       {"generic", prime_lines},
+                       {"unrolled", prime_kernel(&plan)}};
+        uint32_t kernel_count = kernels[2].kernel != prime_lines ? 3 : 2;
+
+        printf("prime of %u sets x %u ways (threshold %u cycles):\n",
+               cache->set_count, cache->ways_of_associativity, threshold);
+        for (uint32_t i = 0; i < kernel_count; i++) {
+            prime_kernel_t kernel = kernels[i].kernel;
+
+            kernel(&plan);
+            uint64_t start = __rdtsc();
+            for (int round = 0; round < PRIME_ROUNDS; round++) {
+                kernel(&plan);
+            }
+            uint64_t cycles = __rdtsc() - start;
+
+            // the victim fills the cache, the prime has to evict all of it
+            stats_reset(&victims);
+            stats_reset(&primed);
+            uint64_t evicted = 0;
+            for (int round = 0; round < PRIME_EVICTION_ROUNDS; round++) {
+                prime_lines_fenced(&victim_plan);
+                kernel(&plan);
+                probe(&victim_plan, samples, timer.overhead);
+                stats_add_values(&victims, samples, plan.count);
+                for (uintptr_t j = 0; j < plan.count; j++) {
+                    evicted += samples[j] > threshold;
+                }
+
+                kernel(&plan);
+                probe(&plan, samples, timer.overhead);
+                stats_add_values(&primed, samples, plan.count);
+            }
+            double share =
+                (double)evicted / (PRIME_EVICTION_ROUNDS * plan.count);
+            uint32_t victim_median = stats_percentile(&victims, 0.5);
+            uint32_t primed_median = stats_percentile(&primed, 0.5);
+
+            // if the victim is as fast as the primed lines, the timer can
+            // not tell the levels apart
+            const char *verdict = "full eviction";
+            if (victim_median <= primed_median) {
+                verdict = "inconclusive";
+            } else if (share < PRIME_EVICTION_MIN) {
+                verdict = "WARNING: incomplete eviction";
+            }
+
+            printf("  %-9s %.2lf cycles per line, evicted %.1lf%% of a "
+                   "victim (median %u cycles, primed lines %u cycles), "
+                   "%s\n",
+                   kernels[i].name,
+                   (double)cycles / PRIME_ROUNDS / plan.count, 100 * share,
+                   victim_median, primed_median, verdict);
+        }
+    }
+
+    if (counter) {
+        error_t disable_err = disable_cpu_cycle_counter(fd_cycle);
+        if (err == ERROR_NONE) {
+            err = disable_err;
+        }
+    }
+
+    if (has_stats) {
+        stats_free(&victims);
+        stats_free(&primed);
+    }
+    free(samples);
+    probe_plan_free(&victim_plan);
+    probe_plan_free(&plan);
+    free_aligned(victim, cache);
+    free_aligned(buffer, cache);
+    return err;
+}
+
+/**
+ * @brief Amount of frames which are probed per level in calibrate_cpu.
+ */
+#define CALIBRATION_FRAMES 32
+
+/**
+ * @brief Distance of the lines of the DRAM measurement of calibrate_cpu.
+ *
+ * The prefetchers follow even page sized strides, so the flushed lines are
+ * spread further apart.
+ */
+#define CALIBRATION_STRIDE (64 * 1024)
+
+/**
+ * @brief Amount of lines of the DRAM measurement of calibrate_cpu.
+ */
+#define CALIBRATION_DRAM_LINES 64
+
+/**
+ * @brief Reads every cache line of a buffer twice, which flushes a cache of
+ * half the size.
+ */
+static void calibrate_walk(const uint8_t *buffer, uintptr_t size,
+                           uint32_t line_size) {
+    for (int pass = 0; pass < 2; pass++) {
+        for (uintptr_t offset = 0; offset < size; offset += line_size) {
+            *(volatile const uint8_t *)(buffer + offset);
+        }
+    }
+}
+
+/**
+ * @brief Measures the median access time of one level.
+ *
+ * @param plan the probed lines
+ * @param probe the probe kernel
+ * @param overhead overhead of the timer
+ * @param flush buffer which flushes the closer levels or NULL
+ * @param flush_size size of @p flush
+ * @param line_size line size of the closer levels
+ * @param dram if not zero, the lines are flushed from all levels
+ * @param samples room for one frame
+ * @param stats statistics which collect the accesses
+ *
+ * @return The median of all accesses.
+ */
+static uint32_t calibrate_level(const probe_plan_t *plan, probe_kernel_t probe,
+                                uint32_t overhead, const uint8_t *flush,
+                                uintptr_t flush_size, uint32_t line_size,
+                                int dram, uint32_t *samples, stats_t *stats) {
+    uintptr_t length = probe_plan_frame_length(plan);
+    stats_reset(stats);
+
+    for (int i = 0; i < CALIBRATION_FRAMES; i++) {
+        prime(plan);
+        if (flush != NULL) {
+            calibrate_walk(flush, flush_size, line_size);
+        }
+        if (dram) {
+            for (uintptr_t j = 0; j < plan->count; j++) {
+                _mm_clflush((const void *)plan->entries[j].line);
+            }
+            _mm_mfence();
+        }
+        probe(plan, samples, overhead);
+        stats_add_values(stats, samples, length);
+    }
+
+    uint32_t median = stats_percentile(stats, 0.5);
+    return median != STATS_OVERFLOW ? median : stats->mean;
+}
+
+error_t calibrate_cpu(const cache_info_t *caches, uint32_t level_count,
+                      timer_type_t type, uint32_t cpu,
+                      calibration_t *calibration) {
+    if (!level_count || level_count > CALIBRATION_MAX_LEVELS) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    // level i is probed in target[i] bytes after walking flush[i] bytes,
+    // which evicts them from the closer levels but not from level i
+    uintptr_t target[CALIBRATION_MAX_LEVELS];
+    uintptr_t flush[CALIBRATION_MAX_LEVELS];
+    uintptr_t target_max = 0;
+    uintptr_t flush_max = 0;
+    for (uint32_t i = 0; i < level_count; i++) {
+        target[i] = caches[i].total_size / 2;
+        flush[i] = 0;
+        if (i) {
+            target[i] = caches[i].total_size / 4 < caches[i - 1].total_size
+                            ? caches[i].total_size / 4
+                            : caches[i - 1].total_size;
+            flush[i] = 2 * caches[i - 1].total_size;
+        }
+        target_max = target[i] > target_max ? target[i] : target_max;
+        flush_max = flush[i] > flush_max ? flush[i] : flush_max;
+    }
+
+    uint32_t line_size = caches[0].line_size;
+    uintptr_t size = target_max + flush_max;
+    if (size < CALIBRATION_DRAM_LINES * CALIBRATION_STRIDE) {
+        size = CALIBRATION_DRAM_LINES * CALIBRATION_STRIDE;
+    }
+    uint8_t *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        return ERROR_MMAP;
+    }
+    // transparent hugepages keep the page walks out of the LLC latency
+    madvise(buffer, size, MADV_HUGEPAGE);
+    memset(buffer, 1, size);
+
+    uintptr_t line_max = target_max / line_size;
+    uintptr_t *lines = malloc(sizeof(uintptr_t) * line_max);
+    uint32_t *samples = malloc(sizeof(uint32_t) * line_max);
+    stats_t stats;
+    if (lines == NULL || samples == NULL ||
+        stats_new(&stats, STATS_DEFAULT_BINS)) {
+        free(lines);
+        free(samples);
+        munmap(buffer, size);
+        return ERROR_ALLOCATION;
+    }
+    for (uintptr_t i = 0; i < line_max; i++) {
+        lines[i] = (uintptr_t)buffer + i * line_size;
+    }
+
+    uint32_t fd_cycle;
+    int counter = 0;
+    error_t err = ERROR_NONE;
+    if (type == TIMER_RDPMC) {
+        err = enable_cpu_cycle_counter(&fd_cycle, cpu);
+        counter = err == ERROR_NONE;
+    }
+
+    cycle_timer_t timer;
+    if (err == ERROR_NONE) {
+        err = timer_calibrate(&timer, type, TIMER_CALIBRATION_SAMPLES);
+    }
+
+    memset(calibration, 0, sizeof(calibration_t));
+    calibration_model(calibration->model);
+    calibration->cpu = cpu;
+    calibration->timer = type;
+    calibration->level_count = level_count;
+
+    probe_kernel_t probe = probe_kernels[PLAN_GRANULARITY_LINE][type];
+
+    for (uint32_t i = 0; i <= level_count && err == ERROR_NONE; i++) {
+        int dram = i == level_count;
+        uintptr_t count = dram ? 0 : target[i] / line_size;
+
+        // the last round measures DRAM with flushed lines which are far
+        // apart and walked linearly, a random order or shorter strides let
+        // the prefetchers turn a part of the misses into hits
+        if (dram) {
+            for (; count < CALIBRATION_DRAM_LINES; count++) {
+                lines[count] = (uintptr_t)buffer + count * CALIBRATION_STRIDE +
+                               count * line_size % CALIBRATION_STRIDE;
+            }
+        }
+
+        // in the cache levels the random order keeps the prefetchers from
+        // hiding misses of the closer levels
+        plan_order_t order = dram ? PLAN_ORDER_LINEAR : PLAN_ORDER_RANDOM;
+        probe_plan_t plan;
+        err = probe_plan_from_lines(&plan, lines, count, 1, NULL, 0,
+                                    order, PLAN_GRANULARITY_LINE, NULL);
+        if (err != ERROR_NONE) {
+            break;
+        }
+
+        calibration->median[i] = calibrate_level(
+            &plan, probe, timer.overhead,
+            !dram && flush[i] ? buffer + target_max : NULL,
+            dram ? 0 : flush[i], line_size, dram, samples, &stats);
+        probe_plan_free(&plan);
+    }
+
+    if (err == ERROR_NONE) {
+        uint32_t inseparable = calibration_derive(calibration);
+        if (inseparable) {
+            printf("WARNING: hits in L%u can not be separated from the next "
+                   "level on CPU %u.\n",
+                   inseparable, cpu);
+        }
+    }
+
+    if (counter) {
+        error_t disable_err = disable_cpu_cycle_counter(fd_cycle);
+        if (err == ERROR_NONE) {
+            err = disable_err;
+        }
+    }
+
+    stats_free(&stats);
+    free(lines);
+    free(samples);
+    munmap(buffer, size);
+    return err;
 }
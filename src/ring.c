@@ -0,0 +1,322 @@
+/**
+ * @file ring.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the frame ring and the writer thread.
+ */
+
+#define _GNU_SOURCE /* needed for pthread_sigmask */
+
+#include "ring.h"
+#include "classify.h"
+#include "sys_action.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief Time the writer thread sleeps if the ring is empty.
+ */
+#define WRITER_IDLE_NS 50000
+
+error_t frame_ring_new(frame_ring_t *ring, uintptr_t frame_length,
+                       uintptr_t capacity, arena_t *arena) {
+    uintptr_t power = 2;
+    while (power * 2 <= capacity) {
+        power *= 2;
+    }
+
+    size_t size = sizeof(uint32_t) * frame_length * power;
+    // aligned_alloc requires a multiple of the alignment
+    size = (size + RING_ALIGNMENT - 1) / RING_ALIGNMENT * RING_ALIGNMENT;
+
+    ring->in_arena = arena != NULL;
+    if (arena != NULL) {
+        FORWARD_ON_FAIL(arena_alloc(arena, size, (void **)&ring->frames));
+    } else {
+        ring->frames = aligned_alloc(RING_ALIGNMENT, size);
+        if (ring->frames == NULL) {
+            return ERROR_ALLOCATION;
+        }
+    }
+
+    ring->clock = malloc(sizeof(uint64_t) * power);
+    ring->timing = malloc(sizeof(frame_timing_t) * power);
+    if (ring->clock == NULL || ring->timing == NULL) {
+        if (!ring->in_arena) {
+            free(ring->frames);
+        }
+        free(ring->clock);
+        free(ring->timing);
+        return ERROR_ALLOCATION;
+    }
+
+    ring->frame_length = frame_length;
+    ring->capacity = power;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->closed, 0);
+    atomic_init(&ring->failed, 0);
+
+    return ERROR_NONE;
+}
+
+void frame_ring_free(frame_ring_t *ring) {
+    if (!ring->in_arena) {
+        free(ring->frames);
+    }
+    free(ring->clock);
+    free(ring->timing);
+    ring->frames = NULL;
+    ring->clock = NULL;
+    ring->timing = NULL;
+}
+
+uint32_t *frame_ring_reserve(frame_ring_t *ring) {
+    uintptr_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uintptr_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail == ring->capacity) {
+        atomic_store_explicit(
+            &ring->dropped,
+            atomic_load_explicit(&ring->dropped, memory_order_relaxed) + 1,
+            memory_order_relaxed);
+        return NULL;
+    }
+
+    return ring->frames + (head & (ring->capacity - 1)) * ring->frame_length;
+}
+
+void frame_ring_commit(frame_ring_t *ring, const frame_timing_t *timing) {
+    uintptr_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uintptr_t index = head & (ring->capacity - 1);
+    ring->clock[index] = timing->tsc_start;
+    ring->timing[index] = *timing;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void frame_ring_close(frame_ring_t *ring) {
+    atomic_store_explicit(&ring->closed, 1, memory_order_release);
+}
+
+uintptr_t frame_ring_peek(frame_ring_t *ring, uint32_t **frames,
+                          uint64_t **clock, frame_timing_t **timing) {
+    uintptr_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uintptr_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    uintptr_t index = tail & (ring->capacity - 1);
+    uintptr_t count = head - tail;
+
+    if (index + count > ring->capacity) {
+        count = ring->capacity - index;
+    }
+
+    *frames = ring->frames + index * ring->frame_length;
+    *clock = ring->clock + index;
+    *timing = ring->timing + index;
+    return count;
+}
+
+void frame_ring_release(frame_ring_t *ring, uintptr_t count) {
+    uintptr_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+}
+
+/**
+ * @brief Writes all consecutive committed frames of a channel.
+ *
+ * @param channel the channel
+ * @param written writes the amount of written frames into
+ *
+ * Outliers are clamped, the values are counted in the histograms and
+ * classified channels pack the frames into bitmaps first, so the probe
+ * threads are not slowed down by the filtering. Aggregated channels only
+ * write a summary whenever a window is complete.
+ *
+ * @return The error of the output.
+ */
+static error_t writer_drain(writer_channel_t *channel, uintptr_t *written) {
+    uint32_t *frames;
+    uint64_t *clock;
+    frame_timing_t *timing;
+    uintptr_t count = frame_ring_peek(channel->ring, &frames, &clock, &timing);
+
+    *written = count;
+    if (!count) {
+        return ERROR_NONE;
+    }
+
+    if (channel->limit) {
+        classify_clamp(frames, count * channel->ring->frame_length,
+                       channel->limit);
+    }
+
+    if (channel->histograms != NULL) {
+        uintptr_t length = channel->ring->frame_length;
+        for (uintptr_t i = 0; i < count; i++) {
+            for (uintptr_t set = 0; set < channel->dim_y; set++) {
+                stats_add_values(channel->histograms + set,
+                                 frames + i * length + set * channel->dim_x,
+                                 channel->dim_x);
+            }
+        }
+    }
+
+    if (channel->aggregate != NULL) {
+        uintptr_t length = channel->ring->frame_length;
+        for (uintptr_t i = 0; i < count; i++) {
+            if (aggregate_add(channel->aggregate, frames + i * length,
+                              clock[i], channel->threshold)) {
+                FORWARD_ON_FAIL(outputw_window(
+                    channel->output, channel->aggregate, channel->rank,
+                    channel->dim_x, channel->dim_y, channel->threshold));
+                aggregate_reset(channel->aggregate);
+            }
+        }
+    }
+
+    if (channel->skip_frames || channel->aggregate != NULL) {
+        frame_ring_release(channel->ring, count);
+        return ERROR_NONE;
+    }
+
+    if (channel->bitmaps != NULL) {
+        uintptr_t length = channel->ring->frame_length;
+        uintptr_t size = classify_bitmap_size(length);
+        for (uintptr_t i = 0; i < count; i++) {
+            classify_pack(frames + i * length, length, channel->threshold,
+                          channel->bitmaps + i * size);
+        }
+    }
+
+    if (channel->bitmaps != NULL && channel->rank == 1) {
+        FORWARD_ON_FAIL(outputw_vecs_bits(channel->output, channel->bitmaps,
+                                          clock, count, channel->dim_y,
+                                          channel->threshold));
+    } else if (channel->bitmaps != NULL) {
+        FORWARD_ON_FAIL(outputw_mats_bits(channel->output, channel->bitmaps,
+                                          clock, count, channel->dim_x,
+                                          channel->dim_y, channel->threshold));
+    } else if (channel->rank == 1) {
+        FORWARD_ON_FAIL(outputw_vecs_ui32(channel->output, frames, clock,
+                                          count, channel->dim_y));
+    } else {
+        FORWARD_ON_FAIL(outputw_mats_ui32(channel->output, frames, clock,
+                                          count, channel->dim_x,
+                                          channel->dim_y));
+    }
+    FORWARD_ON_FAIL(outputw_timing(channel->output, timing, count));
+
+    frame_ring_release(channel->ring, count);
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Main function of the writer thread.
+ *
+ * @param arg pointer to the writer_t
+ *
+ * Writes batches of frames into the outputs until all rings are closed and
+ * empty. If an output fails all rings are marked as failed and the thread
+ * stops.
+ */
+static void *writer_run(void *arg) {
+    writer_t *writer = arg;
+
+    if (writer->cpu > -1) {
+        writer->error = focus_cpu_core(0, writer->cpu);
+    }
+
+    const struct timespec idle = {0, WRITER_IDLE_NS};
+
+    while (writer->error == ERROR_NONE) {
+        uintptr_t total = 0;
+        int open = 0;
+
+        for (uint32_t i = 0; i < writer->channel_count; i++) {
+            writer_channel_t *channel = writer->channels + i;
+
+            // read closed before peeking, so no frame committed before the
+            // close gets lost
+            if (!atomic_load_explicit(&channel->ring->closed,
+                                      memory_order_acquire)) {
+                open = 1;
+            }
+
+            uintptr_t written;
+            uint64_t start = frame_timing_monotonic();
+            writer->error = writer_drain(channel, &written);
+            if (writer->error != ERROR_NONE) {
+                break;
+            }
+            if (written) {
+                counter_add(&writer->counters.busy_ns,
+                            frame_timing_monotonic() - start);
+                counter_add(&writer->counters.frames, written);
+                counter_add(&writer->counters.batches, 1);
+            }
+            total += written;
+        }
+
+        if (!total) {
+            if (!open) {
+                break;
+            }
+            uint64_t start = frame_timing_monotonic();
+            nanosleep(&idle, NULL);
+            counter_add(&writer->counters.idle_ns,
+                        frame_timing_monotonic() - start);
+        }
+    }
+
+    if (writer->error != ERROR_NONE) {
+        for (uint32_t i = 0; i < writer->channel_count; i++) {
+            atomic_store(&writer->channels[i].ring->failed, 1);
+        }
+    }
+
+    return NULL;
+}
+
+error_t thread_start_masked(pthread_t *thread, void *(*run)(void *),
+                            void *arg) {
+    // the new thread inherits the signal mask
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+
+    int ret = pthread_create(thread, NULL, run, arg);
+
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if (ret) {
+        return ERROR_THREAD;
+    }
+
+    return ERROR_NONE;
+}
+
+error_t writer_start(writer_t *writer, writer_channel_t *channels,
+                     uint32_t channel_count, int32_t cpu) {
+    writer->channels = channels;
+    writer->channel_count = channel_count;
+    writer->cpu = cpu;
+    writer->error = ERROR_NONE;
+    writer_counters_init(&writer->counters);
+
+    return thread_start_masked(&writer->thread, writer_run, writer);
+}
+
+error_t writer_stop(writer_t *writer) {
+    for (uint32_t i = 0; i < writer->channel_count; i++) {
+        frame_ring_close(writer->channels[i].ring);
+    }
+
+    if (pthread_join(writer->thread, NULL)) {
+        return ERROR_THREAD;
+    }
+
+    return writer->error;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file stats.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains streaming statistics of cycle counts in constant memory.
+ */
+
+#include "stats.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Values above are reported as reschedules by stats_print.
+ */
+#define STATS_RESCHEDULE 1000
+
+error_t stats_new(stats_t *stats, uint32_t bins) {
+    if (!bins) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(stats, 0, sizeof(stats_t));
+    stats->histogram = calloc(bins, sizeof(uint64_t));
+    if (stats->histogram == NULL) {
+        return ERROR_ALLOCATION;
+    }
+    stats->bins = bins;
+
+    return ERROR_NONE;
+}
+
+void stats_reset(stats_t *stats) {
+    memset(stats->histogram, 0, sizeof(uint64_t) * stats->bins);
+    stats->overflow = 0;
+    stats->count = 0;
+    stats->mean = 0;
+    stats->m2 = 0;
+    stats->min = 0;
+    stats->max = 0;
+}
+
+void stats_add_values(stats_t *stats, const uint32_t *values,
+                      uintptr_t length) {
+    for (uintptr_t i = 0; i < length; i++) {
+        stats_add(stats, values[i]);
+    }
+}
+
+uint32_t stats_percentile(const stats_t *stats, double fraction) {
+    if (!stats->count) {
+        return 0;
+    }
+
+    // nearest rank: the value at the rank ceil(fraction * count)
+    uint64_t rank = (uint64_t)ceil(fraction * stats->count);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (uint32_t value = 0; value < stats->bins; value++) {
+        seen += stats->histogram[value];
+        if (seen >= rank) {
+            return value;
+        }
+    }
+
+    return STATS_OVERFLOW;
+}
+
+double stats_variance(const stats_t *stats) {
+    if (stats->count < 2) {
+        return 0;
+    }
+    return stats->m2 / (stats->count - 1);
+}
+
+/**
+ * @brief Prints a percentile or the upper bound of the histogram.
+ */
+static void stats_print_value(const stats_t *stats, const char *name,
+                              uint32_t value, FILE *file) {
+    if (value == STATS_OVERFLOW) {
+        fprintf(file, "  %s: >%u\n", name, stats->bins - 1);
+    } else {
+        fprintf(file, "  %s: %u\n", name, value);
+    }
+}
+
+void stats_print(const stats_t *stats, FILE *file) {
+    uint32_t median = stats_percentile(stats, 0.5);
+    stats_print_value(stats, "median", median, file);
+    fprintf(file, "  arithmetic mean: %lf\n", stats->mean);
+    fprintf(file, "  empirical variance: %lf\n", stats_variance(stats));
+    stats_print_value(stats, "p90", stats_percentile(stats, 0.9), file);
+    stats_print_value(stats, "p99", stats_percentile(stats, 0.99), file);
+    stats_print_value(stats, "p99.9", stats_percentile(stats, 0.999), file);
+    fprintf(file, "  min: %u, max: %u\n", stats->min, stats->max);
+
+    uint64_t reschedules = stats->overflow;
+    for (uint32_t value = STATS_RESCHEDULE + 1; value < stats->bins;
+         value++) {
+        reschedules += stats->histogram[value];
+    }
+    fprintf(file, "  %lu values are bigger than %u (probably reschedules)\n",
+            reschedules, STATS_RESCHEDULE);
+
+    uint64_t other = stats->count;
+    if (median != STATS_OVERFLOW) {
+        other -= stats->histogram[median];
+    }
+    fprintf(file, "  %lu values differ from the median(%%%lf)\n", other,
+            stats->count ? other / (double)stats->count : 0);
+}
+
+void stats_free(stats_t *stats) {
+    free(stats->histogram);
+    stats->histogram = NULL;
+    stats->bins = 0;
+}
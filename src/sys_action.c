@@ -21,9 +21,15 @@
 #include <sys/resource.h>
 
 error_t focus_cpu_core(uint32_t pid, uint32_t cpu) {
+    return focus_cpu_cores(pid, &cpu, 1);
+}
+
+error_t focus_cpu_cores(uint32_t pid, const uint32_t *cpus, uint32_t count) {
     cpu_set_t set;
     CPU_ZERO(&set);
-    CPU_SET(cpu, &set);
+    for (uint32_t i = 0; i < count; i++) {
+        CPU_SET(cpus[i], &set);
+    }
 
     if (sched_setaffinity(pid, sizeof(set), &set)) {
         return ERROR_SET_AFFINITY;
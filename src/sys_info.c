@@ -14,6 +14,7 @@
 
 #include <ctype.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <sched.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -90,6 +91,7 @@ int str_starts_with(const char *pre, const char *str) {
  * On Linux the information are retrieved from the sysfs file system.
  *
  * @retval ERROR_IO
+ * @retval ERROR_IO_SYS_CPU
  * @retval ERROR_FMT
  * @retval ERROR_ALLOCATION
  * @retval ERROR_NONE
@@ -112,17 +114,16 @@ error_t cache_info_fill(cache_info_t *info, uint32_t cache, uint32_t cpu) {
     info->cpu_id = cpu;
     info->cache_id = cache;
 
-    char *type = "type";
-    size_t new_path_size = sizeof(char) * (strlen(cpu_path) + strlen(type) + 1);
-    char *new_path = malloc(new_path_size);
-    strncpy(new_path, cpu_path, new_path_size - 1);
-    strncat(new_path, type, new_path_size - strlen(new_path) - 1);
+    char type_path[sizeof(cpu_path) + sizeof("type")];
+    snprintf(type_path, sizeof(type_path), "%stype", cpu_path);
 
     FILE *file;
-    file = fopen(new_path, "r");
+    file = fopen(type_path, "r");
+    if (!file) {
+        return ERROR_IO_SYS_CPU;
+    }
 
     char c = fgetc(file);
-    free(new_path);
     cache_type_t ctype;
 
     if (c == 'D') {
@@ -228,63 +229,112 @@ error_t cache_info_new(cache_info_t *info, uint8_t cpu, uint8_t level) {
     return ERROR_NONE;
 }
 
-error_t pagemap_entry_from(pagemap_entry_t *entry, const uint64_t offset) {
-    FILE *map = fopen("/proc/self/pagemap", "rb");
-
-    if (map == NULL) {
-        return ERROR_IO_PROC_SELF_PAGEMAP;
-    }
+/**
+ * @brief Decodes a raw entry of the pagemap.
+ *
+ * @param entry writes the decoded entry into
+ * @param data the raw entry
+ */
+static void pagemap_entry_decode(pagemap_entry_t *entry, uint64_t data) {
+    entry->page_frame_number = data & (((uint64_t)1 << 54) - 1);
+    entry->soft_dirty = (data >> 54) & 1;
+    entry->file_page = (data >> 61) & 1;
+    entry->swapped = (data >> 62) & 1;
+    entry->present = (data >> 63) & 1;
+}
 
-    if (fseek(map, offset, SEEK_SET)) {
-        fclose(map);
+error_t pagemap_entry_from(pagemap_entry_t *entry, const uint64_t offset) {
+    int fd = open("/proc/self/pagemap", O_RDONLY);
+    if (fd == -1) {
         return ERROR_IO_PROC_SELF_PAGEMAP;
     }
 
     uint64_t data = 0;
+    ssize_t size = pread(fd, &data, PAGE_ENTRY_SIZE, offset);
+    close(fd);
 
-    if (1 != fread(&data, PAGE_ENTRY_SIZE, 1, map)) {
-        fclose(map);
+    if (size != PAGE_ENTRY_SIZE) {
         return ERROR_IO_PROC_SELF_PAGEMAP;
     }
 
-    entry->page_frame_number = data & (((uint64_t)1 << 54) - 1);
-    entry->soft_dirty = (data >> 54) & 1;
-    entry->file_page = (data >> 61) & 1;
-    entry->swapped = (data >> 62) & 1;
-    entry->present = (data >> 63) & 1;
-
-    fclose(map);
+    pagemap_entry_decode(entry, data);
     return ERROR_NONE;
 }
 
 error_t get_physical_address(const void *addr, uintptr_t *target) {
-    const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    pagemap_t pagemap;
+    FORWARD_ON_FAIL(pagemap_open(&pagemap));
+
+    error_t err = pagemap_translate(&pagemap, addr, 1, target);
+    pagemap_close(&pagemap);
 
+    if (err == ERROR_NONE) {
+        *target += (uintptr_t)addr % pagemap.page_size;
+    }
+
+    return err;
+}
+
+error_t pagemap_open(pagemap_t *pagemap) {
+    const long page_size = sysconf(_SC_PAGESIZE);
+
+    pagemap->fd = -1;
     if (page_size < 1) {
         return ERROR_SYSCONF;
     }
 
-    uint64_t page_shift = 0;
-    for (uint64_t counter = page_size; counter > 1; counter = counter >> 1) {
-        page_shift += 1;
+    pagemap->page_size = page_size;
+    pagemap->page_shift = __builtin_ctzll(page_size);
+
+    pagemap->fd = open("/proc/self/pagemap", O_RDONLY);
+    if (pagemap->fd == -1) {
+        return ERROR_IO_PROC_SELF_PAGEMAP;
     }
 
-    uint64_t offset = ((uint64_t)addr) / page_size * PAGE_ENTRY_SIZE;
+    return ERROR_NONE;
+}
 
-    pagemap_entry_t entry;
+error_t pagemap_translate(const pagemap_t *pagemap, const void *addr,
+                          uintptr_t count, uintptr_t *physical) {
+    // the entries are read in place, an entry has the size of an address
+    _Static_assert(sizeof(uintptr_t) == PAGE_ENTRY_SIZE,
+                   "a pagemap entry has to fit into an address");
 
-    FORWARD_ON_FAIL(pagemap_entry_from(&entry, offset));
+    uint64_t offset = ((uint64_t)addr >> pagemap->page_shift) * PAGE_ENTRY_SIZE;
+    size_t length = count * PAGE_ENTRY_SIZE;
+    uint8_t *data = (uint8_t *)physical;
 
-    if (!entry.present) {
-        return ERROR_PAGE_ENTRY;
+    while (length) {
+        ssize_t size = pread(pagemap->fd, data, length, offset);
+        if (size <= 0) {
+            return ERROR_IO_PROC_SELF_PAGEMAP;
+        }
+        data += size;
+        offset += size;
+        length -= size;
     }
 
-    *target = (entry.page_frame_number << page_shift) +
-              (((uint64_t)addr) % page_size);
+    for (uintptr_t i = 0; i < count; i++) {
+        pagemap_entry_t entry;
+        pagemap_entry_decode(&entry, physical[i]);
+
+        if (!entry.present) {
+            return ERROR_PAGE_ENTRY;
+        }
+
+        physical[i] = (uintptr_t)entry.page_frame_number << pagemap->page_shift;
+    }
 
     return ERROR_NONE;
 }
 
+void pagemap_close(pagemap_t *pagemap) {
+    if (pagemap->fd != -1) {
+        close(pagemap->fd);
+    }
+    pagemap->fd = -1;
+}
+
 error_t get_hugepagenr(uint32_t *nr) {
     READ_PROP_PUT("/proc/sys/vm/", "nr_hugepages", nr, HUGEPAGE_NUMBER);
     return ERROR_NONE;
@@ -335,6 +385,152 @@ error_t get_current_cpu_core(uint32_t *core) {
     return ERROR_NONE;
 }
 
+error_t get_other_cpu_core(const uint32_t *cpus, uint32_t count,
+                           int32_t *other) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set)) {
+        return ERROR_GET_CPU_CORE;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (cpus[i] < CPU_SETSIZE) {
+            CPU_CLR(cpus[i], &set);
+        }
+    }
+
+    *other = -1;
+    for (int32_t i = 0; i < CPU_SETSIZE; i++) {
+        if (CPU_ISSET(i, &set)) {
+            *other = i;
+            break;
+        }
+    }
+
+    return ERROR_NONE;
+}
+
+error_t parse_id_list(const char *list, uint32_t **ids, uint32_t *count) {
+    uint32_t capacity = 16;
+    *count = 0;
+    *ids = malloc(sizeof(uint32_t) * capacity);
+    if (*ids == NULL) {
+        return ERROR_ALLOCATION;
+    }
+
+    const char *pos = list;
+    while (*pos) {
+        char *end;
+        if (!isdigit((unsigned char)*pos)) {
+            goto INVALID;
+        }
+        unsigned long first = strtoul(pos, &end, 10);
+        unsigned long last = first;
+
+        if (*end == '-') {
+            pos = end + 1;
+            if (!isdigit((unsigned char)*pos)) {
+                goto INVALID;
+            }
+            last = strtoul(pos, &end, 10);
+        }
+
+        if (last < first || last > UINT32_MAX || (*end && *end != ',' &&
+                                                  *end != '\n')) {
+            goto INVALID;
+        }
+
+        for (unsigned long id = first; id <= last; id++) {
+            int duplicate = 0;
+            for (uint32_t i = 0; i < *count; i++) {
+                duplicate |= (*ids)[i] == id;
+            }
+            if (duplicate) {
+                continue;
+            }
+
+            if (*count == capacity) {
+                capacity *= 2;
+                uint32_t *grown = realloc(*ids, sizeof(uint32_t) * capacity);
+                if (grown == NULL) {
+                    free(*ids);
+                    *ids = NULL;
+                    return ERROR_ALLOCATION;
+                }
+                *ids = grown;
+            }
+            (*ids)[(*count)++] = id;
+        }
+
+        pos = *end ? end + 1 : end;
+        if (*end == '\n') {
+            break;
+        }
+    }
+
+    if (*count) {
+        return ERROR_NONE;
+    }
+
+INVALID:
+    free(*ids);
+    *ids = NULL;
+    *count = 0;
+    return ERROR_INVALID_ARGUMENT;
+}
+
+/**
+ * @brief Reads a sysfs cpu list from a file.
+ *
+ * @param path path of the file
+ * @param ids writes a pointer to the allocated ids into
+ * @param count writes the amount of ids into
+ *
+ * @retval ERROR_IO_SYS_CPU
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t read_file_id_list(const char *path, uint32_t **ids,
+                                 uint32_t *count) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return ERROR_IO_SYS_CPU;
+    }
+
+    char list[4096];
+    char *ret = fgets(list, sizeof(list), file);
+    fclose(file);
+
+    if (ret == NULL) {
+        return ERROR_IO_SYS_CPU;
+    }
+
+    return parse_id_list(list, ids, count);
+}
+
+error_t get_slice_count(const cache_info_t *info, uint32_t *slices) {
+    char path[100];
+    uint32_t *ids;
+    uint32_t shared, siblings;
+
+    sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list",
+            info->cpu_id, info->cache_id);
+    FORWARD_ON_FAIL(read_file_id_list(path, &ids, &shared));
+    free(ids);
+
+    sprintf(path, "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+            info->cpu_id);
+    FORWARD_ON_FAIL(read_file_id_list(path, &ids, &siblings));
+    free(ids);
+
+    *slices = shared / siblings;
+    if (*slices < 1) {
+        *slices = 1;
+    }
+
+    return ERROR_NONE;
+}
+
 error_t can_use_rdpmc() {
     uint32_t value;
     READ_PROP_PUT("/sys/bus/event_source/devices/cpu/", "rdpmc", &value, RDPMC);
@@ -0,0 +1,160 @@
+/**
+ * @file timer.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the calibration of the timer backends.
+ */
+
+#include "timer.h"
+#include "stats.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Names of the timer backends, indexed by timer_type_t.
+ */
+static const char *timer_names[TIMER_COUNT] = {"rdpmc", "rdtscp", "rdtsc"};
+
+/**
+ * @brief Amount of measurements which are buffered at once by
+ * timer_calibrate.
+ */
+#define TIMER_BATCH 65536
+
+/**
+ * @brief Defines a function which measures an empty region.
+ *
+ * @param name name of the function
+ * @param start START fragment of the timer backend
+ * @param stop STOP fragment of the timer backend
+ * @param serialize SERIALIZE fragment of the timer backend
+ */
+#define DEFINE_MEASURE_EMPTY(name, start, stop, serialize)                     \
+    static void name(uint64_t samples, uint32_t *result) {                     \
+        for (uint64_t i = 0; i < samples; i++) {                               \
+            asm volatile(start stop                                            \
+                         "movnti %%eax, (%[result],%[i],4);" serialize         \
+                         : /* no output */                                     \
+                         : [result] "r"(result), [i] "r"(i)                    \
+                         : "memory", "rax", "rbx", "rcx", "rdx", "r8");        \
+        }                                                                      \
+    }
+
+DEFINE_MEASURE_EMPTY(measure_empty_rdpmc, TIMER_RDPMC_START, TIMER_RDPMC_STOP,
+                     TIMER_RDPMC_SERIALIZE)
+DEFINE_MEASURE_EMPTY(measure_empty_rdtscp, TIMER_RDTSCP_START,
+                     TIMER_RDTSCP_STOP, TIMER_RDTSCP_SERIALIZE)
+DEFINE_MEASURE_EMPTY(measure_empty_rdtsc, TIMER_RDTSC_START, TIMER_RDTSC_STOP,
+                     TIMER_RDTSC_SERIALIZE)
+
+/**
+ * @brief Defines a function which measures a single memory access.
+ *
+ * @param name name of the function
+ * @param start START fragment of the timer backend
+ * @param stop STOP fragment of the timer backend
+ * @param serialize SERIALIZE fragment of the timer backend
+ */
+#define DEFINE_MEASURE_LOAD(name, start, stop, serialize)                      \
+    static void name(uint32_t overhead, const void *addr, int flush,           \
+                     uint64_t samples, uint32_t *result) {                     \
+        for (uint64_t i = 0; i < samples; i++) {                               \
+            if (flush) {                                                       \
+                asm volatile("clflush (%[addr]); mfence;"                      \
+                             : /* no output */                                 \
+                             : [addr] "r"(addr)                                \
+                             : "memory");                                      \
+            }                                                                  \
+            asm volatile(start "mov (%[addr]), %%rax;" stop                    \
+                             TIMER_SUBTRACT_OVERHEAD                           \
+                         "movnti %%eax, (%[result],%[i],4);" serialize         \
+                         : /* no output */                                     \
+                         : [result] "r"(result), [i] "r"(i),                   \
+                           [addr] "r"(addr), [overhead] "r"(overhead)          \
+                         : "memory", "rax", "rbx", "rcx", "rdx", "r8");        \
+        }                                                                      \
+    }
+
+DEFINE_MEASURE_LOAD(measure_load_rdpmc, TIMER_RDPMC_START, TIMER_RDPMC_STOP,
+                    TIMER_RDPMC_SERIALIZE)
+DEFINE_MEASURE_LOAD(measure_load_rdtscp, TIMER_RDTSCP_START, TIMER_RDTSCP_STOP,
+                    TIMER_RDTSCP_SERIALIZE)
+DEFINE_MEASURE_LOAD(measure_load_rdtsc, TIMER_RDTSC_START, TIMER_RDTSC_STOP,
+                    TIMER_RDTSC_SERIALIZE)
+
+error_t timer_type_from(const char *name, timer_type_t *type) {
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        if (!strcmp(name, timer_names[i])) {
+            *type = i;
+            return ERROR_NONE;
+        }
+    }
+
+    return ERROR_INVALID_ARGUMENT;
+}
+
+const char *timer_name(timer_type_t type) {
+    if (type < TIMER_COUNT) {
+        return timer_names[type];
+    }
+    return "unknown";
+}
+
+void timer_measure_empty(timer_type_t type, uint64_t samples,
+                         uint32_t *result) {
+    switch (type) {
+    case TIMER_RDPMC:
+        measure_empty_rdpmc(samples, result);
+        break;
+    case TIMER_RDTSCP:
+        measure_empty_rdtscp(samples, result);
+        break;
+    default:
+        measure_empty_rdtsc(samples, result);
+        break;
+    }
+}
+
+void timer_measure_load(timer_type_t type, uint32_t overhead,
+                        const void *addr, int flush, uint64_t samples,
+                        uint32_t *result) {
+    switch (type) {
+    case TIMER_RDPMC:
+        measure_load_rdpmc(overhead, addr, flush, samples, result);
+        break;
+    case TIMER_RDTSCP:
+        measure_load_rdtscp(overhead, addr, flush, samples, result);
+        break;
+    default:
+        measure_load_rdtsc(overhead, addr, flush, samples, result);
+        break;
+    }
+}
+
+error_t timer_calibrate(cycle_timer_t *timer, timer_type_t type,
+                        uint64_t samples) {
+    uint64_t batch = samples < TIMER_BATCH ? samples : TIMER_BATCH;
+    uint32_t *result = malloc(batch * sizeof(uint32_t));
+    stats_t stats;
+    if (result == NULL || stats_new(&stats, STATS_DEFAULT_BINS)) {
+        free(result);
+        return ERROR_ALLOCATION;
+    }
+
+    for (uint64_t done = 0; done < samples; done += batch) {
+        uint64_t count = samples - done < batch ? samples - done : batch;
+        timer_measure_empty(type, count, result);
+        stats_add_values(&stats, result, count);
+    }
+
+    uint32_t median = stats_percentile(&stats, 0.5);
+    timer->type = type;
+    timer->overhead = median != STATS_OVERFLOW ? median : stats.mean;
+    timer->jitter = sqrt(stats_variance(&stats));
+
+    stats_free(&stats);
+    free(result);
+    return ERROR_NONE;
+}
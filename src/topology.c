@@ -0,0 +1,785 @@
+/**
+ * @file topology.c
+ * @date 16 Oct 2026
+ *
+ * @brief Contains the scan of the cache topology of all CPU cores.
+ */
+
+#define _GNU_SOURCE /* needed for CPU_ZERO, CPU_SET and sched_setaffinity */
+
+#include "topology.h"
+
+#include <cpuid.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief Directory of the CPU cores in the sysfs.
+ */
+#define SYSFS_CPU "/sys/devices/system/cpu"
+
+/**
+ * @brief Maximal amount of caches of one CPU core which are read with the
+ * CPUID fallback.
+ */
+#define TOPOLOGY_CPUID_CACHES 16
+
+/**
+ * @brief The raw CPUID information of one CPU core.
+ */
+typedef struct cpuid_core_s {
+    uint32_t apic_id;                         /**< (x2)APIC id. */
+    uint32_t smt_shift;                       /**< Bits of the hyper thread
+                                                 in the APIC id. */
+    uint32_t cache_count;                     /**< Amount of caches. */
+    cache_info_t caches[TOPOLOGY_CPUID_CACHES]; /**< Geometry of the caches. */
+    uint32_t share_shift[TOPOLOGY_CPUID_CACHES]; /**< Bits of the APIC id of
+                                                   the CPU cores which share
+                                                   a cache. */
+} cpuid_core_t;
+
+/**
+ * @brief Reads a small sysfs file.
+ *
+ * @param dir directory of the file or AT_FDCWD for absolute paths
+ * @param name name of the file
+ * @param buffer writes the zero terminated content into
+ * @param size size of @p buffer
+ *
+ * @retval ERROR_IO_SYS_CPU
+ * @retval ERROR_NONE
+ */
+static error_t topology_read(int dir, const char *name, char *buffer,
+                             size_t size) {
+    int fd = openat(dir, name, O_RDONLY);
+    if (fd == -1) {
+        return ERROR_IO_SYS_CPU;
+    }
+
+    ssize_t length = read(fd, buffer, size - 1);
+    close(fd);
+
+    if (length <= 0) {
+        return ERROR_IO_SYS_CPU;
+    }
+    buffer[length] = '\0';
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Reads an unsigned integer with an optional K or M suffix from a
+ * sysfs file.
+ *
+ * @retval ERROR_IO_SYS_CPU
+ * @retval ERROR_FMT
+ * @retval ERROR_NONE
+ */
+static error_t topology_read_uint(int dir, const char *name,
+                                  uint32_t *value) {
+    char buffer[32];
+    FORWARD_ON_FAIL(topology_read(dir, name, buffer, sizeof(buffer)));
+
+    char *end;
+    unsigned long parsed = strtoul(buffer, &end, 10);
+    if (end == buffer) {
+        return ERROR_FMT;
+    }
+
+    if (*end == 'K') {
+        parsed *= 1024;
+    } else if (*end == 'M') {
+        parsed *= 1024 * 1024;
+    }
+
+    *value = parsed;
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Parses the content of a sysfs cache type file.
+ */
+static cache_type_t topology_type(const char *name) {
+    if (!strncmp(name, "Data", 4)) {
+        return DATA;
+    } else if (!strncmp(name, "Instruction", 11)) {
+        return INSTRUCTION;
+    } else if (!strncmp(name, "Unified", 7)) {
+        return UNIFIED;
+    }
+    return UNKOWN;
+}
+
+/**
+ * @brief Returns the name of a cache type in the JSON output.
+ */
+static const char *topology_type_name(cache_type_t type) {
+    return type == DATA          ? "data"
+           : type == INSTRUCTION ? "instruction"
+           : type == UNIFIED     ? "unified"
+                                 : "unknown";
+}
+
+/**
+ * @brief Returns the index of a known cache or -1.
+ *
+ * Two caches are the same if they have the same level and type and are
+ * shared by the same CPU cores.
+ */
+static int64_t topology_lookup(const topology_t *topology, uint32_t level,
+                               cache_type_t type, const uint32_t *cpus,
+                               uint32_t cpu_count) {
+    for (uint32_t i = 0; i < topology->cache_count; i++) {
+        const cache_instance_t *cache = topology->caches + i;
+        if (cache->info.level == level && cache->info.type == type &&
+            cache->cpu_count == cpu_count &&
+            !memcmp(cache->cpus, cpus, sizeof(uint32_t) * cpu_count)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Appends a cache to the caches of a CPU core.
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t topology_attach(cpu_node_t *node, uint32_t cache) {
+    uint32_t *caches =
+        realloc(node->caches, sizeof(uint32_t) * (node->cache_count + 1));
+    if (caches == NULL) {
+        return ERROR_ALLOCATION;
+    }
+
+    node->caches = caches;
+    node->caches[node->cache_count++] = cache;
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Adds a new cache to a topology and to a CPU core.
+ *
+ * @param topology the topology
+ * @param capacity capacity of topology_t#caches, grows with the caches
+ * @param node the CPU core which uses the cache
+ * @param info geometry of the cache
+ * @param cpus the CPU cores which share the cache, owned by the topology
+ * afterwards, also on errors
+ * @param cpu_count amount of CPU cores
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t topology_insert(topology_t *topology, uint32_t *capacity,
+                               cpu_node_t *node, const cache_info_t *info,
+                               uint32_t *cpus, uint32_t cpu_count) {
+    if (topology->cache_count == *capacity) {
+        uint32_t grown = *capacity ? *capacity * 2 : 8;
+        cache_instance_t *caches =
+            realloc(topology->caches, sizeof(cache_instance_t) * grown);
+        if (caches == NULL) {
+            free(cpus);
+            return ERROR_ALLOCATION;
+        }
+        topology->caches = caches;
+        *capacity = grown;
+    }
+
+    cache_instance_t *cache = topology->caches + topology->cache_count++;
+    cache->info = *info;
+    cache->cpus = cpus;
+    cache->cpu_count = cpu_count;
+
+    return topology_attach(node, topology->cache_count - 1);
+}
+
+/**
+ * @brief Reads the online CPU cores.
+ *
+ * Falls back to the CPU affinity of this process if the sysfs is missing.
+ *
+ * @retval ERROR_GET_CPU_CORE
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t topology_online(uint32_t **cpus, uint32_t *count) {
+    char list[4096];
+    if (topology_read(AT_FDCWD, SYSFS_CPU "/online", list, sizeof(list)) ==
+            ERROR_NONE &&
+        parse_id_list(list, cpus, count) == ERROR_NONE) {
+        return ERROR_NONE;
+    }
+
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set)) {
+        return ERROR_GET_CPU_CORE;
+    }
+
+    *count = 0;
+    *cpus = malloc(sizeof(uint32_t) * CPU_COUNT(&set));
+    if (*cpus == NULL) {
+        return ERROR_ALLOCATION;
+    }
+
+    for (uint32_t i = 0; i < CPU_SETSIZE; i++) {
+        if (CPU_ISSET(i, &set)) {
+            (*cpus)[(*count)++] = i;
+        }
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Reads one cache directory of the sysfs.
+ *
+ * The geometry is only read if the cache is not known yet from another CPU
+ * core which shares it.
+ *
+ * @retval ERROR_IO_SYS_CPU
+ * @retval ERROR_FMT
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t topology_scan_index(topology_t *topology, uint32_t *capacity,
+                                   cpu_node_t *node, int dir,
+                                   uint32_t index) {
+    char buffer[4096];
+    cache_info_t info = {0};
+    uint32_t *cpus;
+    uint32_t cpu_count;
+
+    FORWARD_ON_FAIL(topology_read_uint(dir, "level", &info.level));
+    FORWARD_ON_FAIL(topology_read(dir, "type", buffer, sizeof(buffer)));
+    info.type = topology_type(buffer);
+
+    FORWARD_ON_FAIL(
+        topology_read(dir, "shared_cpu_list", buffer, sizeof(buffer)));
+    FORWARD_ON_FAIL(parse_id_list(buffer, &cpus, &cpu_count));
+
+    int64_t known =
+        topology_lookup(topology, info.level, info.type, cpus, cpu_count);
+    if (known >= 0) {
+        free(cpus);
+        return topology_attach(node, known);
+    }
+
+    error_t err;
+    if ((err = topology_read_uint(dir, "coherency_line_size",
+                                  &info.line_size)) ||
+        (err = topology_read_uint(dir, "size", &info.total_size)) ||
+        (err = topology_read_uint(dir, "number_of_sets", &info.set_count)) ||
+        (err = topology_read_uint(dir, "ways_of_associativity",
+                                  &info.ways_of_associativity))) {
+        free(cpus);
+        return err;
+    }
+
+    info.cache_id = index;
+    info.cpu_id = cpus[0];
+
+    return topology_insert(topology, capacity, node, &info, cpus, cpu_count);
+}
+
+/**
+ * @brief Reads the caches and hyper threads of every CPU core from the sysfs.
+ *
+ * @retval ERROR_IO_SYS_CPU
+ * @retval ERROR_FMT
+ * @retval ERROR_INVALID_ARGUMENT
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t topology_scan_sysfs(topology_t *topology) {
+    uint32_t capacity = 0;
+    char path[128];
+
+    for (uint32_t i = 0; i < topology->cpu_count; i++) {
+        cpu_node_t *node = topology->cpus + i;
+
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%u/cache", node->cpu);
+        int dir = open(path, O_RDONLY | O_DIRECTORY);
+        if (dir == -1) {
+            return ERROR_IO_SYS_CPU;
+        }
+
+        error_t err = ERROR_NONE;
+        for (uint32_t index = 0; err == ERROR_NONE; index++) {
+            char name[32];
+            snprintf(name, sizeof(name), "index%u", index);
+            int index_dir = openat(dir, name, O_RDONLY | O_DIRECTORY);
+            if (index_dir == -1) {
+                break;
+            }
+
+            err = topology_scan_index(topology, &capacity, node, index_dir,
+                                      index);
+            close(index_dir);
+        }
+        close(dir);
+        FORWARD_ON_FAIL(err);
+
+        char list[4096];
+        snprintf(path, sizeof(path),
+                 SYSFS_CPU "/cpu%u/topology/thread_siblings_list", node->cpu);
+        if (topology_read(AT_FDCWD, path, list, sizeof(list)) ||
+            parse_id_list(list, &node->siblings, &node->sibling_count)) {
+            node->siblings = malloc(sizeof(uint32_t));
+            if (node->siblings == NULL) {
+                return ERROR_ALLOCATION;
+            }
+            node->siblings[0] = node->cpu;
+            node->sibling_count = 1;
+        }
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Returns the amount of bits which are needed for a count of ids.
+ */
+static uint32_t topology_shift(uint32_t count) {
+    uint32_t shift = 0;
+    while ((1U << shift) < count) {
+        shift++;
+    }
+    return shift;
+}
+
+/**
+ * @brief Reads the CPUID information of the current CPU core.
+ *
+ * @retval ERROR_TOPOLOGY
+ * @retval ERROR_NONE
+ */
+static error_t topology_cpuid_core(cpuid_core_t *core) {
+    uint32_t eax, ebx, ecx, edx;
+
+    uint32_t max_leaf = __get_cpuid_max(0, NULL);
+    if (max_leaf < 4) {
+        return ERROR_TOPOLOGY;
+    }
+
+    core->smt_shift = 0;
+    __cpuid(1, eax, ebx, ecx, edx);
+    core->apic_id = ebx >> 24;
+    if (max_leaf >= 0xB) {
+        __cpuid_count(0xB, 0, eax, ebx, ecx, edx);
+        if (ebx) {
+            core->apic_id = edx;
+            core->smt_shift = eax & 0x1F;
+        }
+    }
+
+    core->cache_count = 0;
+    for (uint32_t i = 0; i < TOPOLOGY_CPUID_CACHES; i++) {
+        __cpuid_count(4, i, eax, ebx, ecx, edx);
+        uint32_t type = eax & 0x1F;
+        if (!type) {
+            break;
+        }
+
+        cache_info_t *info = core->caches + core->cache_count;
+        memset(info, 0, sizeof(cache_info_t));
+        info->type = type == 1 ? DATA
+                     : type == 2 ? INSTRUCTION
+                     : type == 3 ? UNIFIED
+                                 : UNKOWN;
+        info->level = (eax >> 5) & 0x7;
+        info->line_size = (ebx & 0xFFF) + 1;
+        info->ways_of_associativity = ((ebx >> 22) & 0x3FF) + 1;
+        info->set_count = ecx + 1;
+        info->total_size = info->line_size * info->ways_of_associativity *
+                           (((ebx >> 12) & 0x3FF) + 1) * info->set_count;
+        info->cache_id = i;
+
+        core->share_shift[core->cache_count] =
+            topology_shift(((eax >> 14) & 0xFFF) + 1);
+        core->cache_count++;
+    }
+
+    return core->cache_count ? ERROR_NONE : ERROR_TOPOLOGY;
+}
+
+/**
+ * @brief Collects the CPU cores whose APIC ids match above a shift.
+ *
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t topology_cpuid_group(const topology_t *topology,
+                                    const cpuid_core_t *cores, uint32_t core,
+                                    uint32_t shift, uint32_t **cpus,
+                                    uint32_t *count) {
+    *count = 0;
+    *cpus = malloc(sizeof(uint32_t) * topology->cpu_count);
+    if (*cpus == NULL) {
+        return ERROR_ALLOCATION;
+    }
+
+    for (uint32_t i = 0; i < topology->cpu_count; i++) {
+        if (cores[i].apic_id >> shift == cores[core].apic_id >> shift) {
+            (*cpus)[(*count)++] = topology->cpus[i].cpu;
+        }
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Reads the caches and hyper threads of every CPU core with CPUID.
+ *
+ * The current thread runs once on every CPU core, because CPUID only
+ * describes the CPU core which executes it.
+ *
+ * @retval ERROR_TOPOLOGY
+ * @retval ERROR_GET_CPU_CORE
+ * @retval ERROR_ALLOCATION
+ * @retval ERROR_NONE
+ */
+static error_t topology_scan_cpuid(topology_t *topology) {
+    cpu_set_t affinity;
+    if (sched_getaffinity(0, sizeof(affinity), &affinity)) {
+        return ERROR_GET_CPU_CORE;
+    }
+
+    cpuid_core_t *cores = calloc(topology->cpu_count, sizeof(cpuid_core_t));
+    if (cores == NULL) {
+        return ERROR_ALLOCATION;
+    }
+
+    error_t err = ERROR_NONE;
+    for (uint32_t i = 0; i < topology->cpu_count && err == ERROR_NONE; i++) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(topology->cpus[i].cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set)) {
+            err = ERROR_GET_CPU_CORE;
+        } else {
+            err = topology_cpuid_core(cores + i);
+        }
+    }
+
+    if (sched_setaffinity(0, sizeof(affinity), &affinity) && !err) {
+        err = ERROR_GET_CPU_CORE;
+    }
+
+    uint32_t capacity = 0;
+    for (uint32_t i = 0; i < topology->cpu_count && err == ERROR_NONE; i++) {
+        cpu_node_t *node = topology->cpus + i;
+
+        for (uint32_t c = 0; c < cores[i].cache_count && err == ERROR_NONE;
+             c++) {
+            const cache_info_t *info = cores[i].caches + c;
+            uint32_t *cpus;
+            uint32_t cpu_count;
+
+            err = topology_cpuid_group(topology, cores, i,
+                                       cores[i].share_shift[c], &cpus,
+                                       &cpu_count);
+            if (err) {
+                break;
+            }
+
+            int64_t known = topology_lookup(topology, info->level, info->type,
+                                            cpus, cpu_count);
+            if (known >= 0) {
+                free(cpus);
+                err = topology_attach(node, known);
+            } else {
+                cache_info_t shared = *info;
+                shared.cpu_id = cpus[0];
+                err = topology_insert(topology, &capacity, node, &shared, cpus,
+                                      cpu_count);
+            }
+        }
+
+        if (!err) {
+            err = topology_cpuid_group(topology, cores, i, cores[i].smt_shift,
+                                       &node->siblings, &node->sibling_count);
+        }
+    }
+
+    free(cores);
+    return err;
+}
+
+error_t topology_new(topology_t *topology) {
+    uint32_t *cpus;
+    uint32_t cpu_count;
+
+    memset(topology, 0, sizeof(topology_t));
+    FORWARD_ON_FAIL(topology_online(&cpus, &cpu_count));
+
+    topology->cpus = calloc(cpu_count, sizeof(cpu_node_t));
+    if (topology->cpus == NULL) {
+        free(cpus);
+        return ERROR_ALLOCATION;
+    }
+
+    topology->cpu_count = cpu_count;
+    for (uint32_t i = 0; i < cpu_count; i++) {
+        topology->cpus[i].cpu = cpus[i];
+    }
+    free(cpus);
+
+    char path[64];
+    snprintf(path, sizeof(path), SYSFS_CPU "/cpu%u/cache",
+             topology->cpus[0].cpu);
+
+    error_t err;
+    if (access(path, R_OK) == 0) {
+        topology->source = TOPOLOGY_SYSFS;
+        err = topology_scan_sysfs(topology);
+    } else {
+        topology->source = TOPOLOGY_CPUID;
+        err = topology_scan_cpuid(topology);
+    }
+
+    if (err) {
+        topology_free(topology);
+    }
+    return err;
+}
+
+/**
+ * @brief Returns the node of a CPU core or NULL.
+ */
+static const cpu_node_t *topology_node(const topology_t *topology,
+                                       uint32_t cpu) {
+    for (uint32_t i = 0; i < topology->cpu_count; i++) {
+        if (topology->cpus[i].cpu == cpu) {
+            return topology->cpus + i;
+        }
+    }
+    return NULL;
+}
+
+error_t topology_cache(const topology_t *topology, uint32_t cpu,
+                       uint32_t level, cache_info_t *info) {
+    const cpu_node_t *node = topology_node(topology, cpu);
+
+    for (uint32_t i = 0; node != NULL && i < node->cache_count; i++) {
+        const cache_info_t *cache = &topology->caches[node->caches[i]].info;
+        if (cache->level == level &&
+            (cache->type == DATA || cache->type == UNIFIED)) {
+            *info = *cache;
+            info->cpu_id = cpu;
+            return ERROR_NONE;
+        }
+    }
+
+    return ERROR_CACHE_NOT_EXISTS;
+}
+
+error_t topology_slice_count(const topology_t *topology,
+                             const cache_info_t *info, uint32_t *slices) {
+    const cpu_node_t *node = topology_node(topology, info->cpu_id);
+
+    for (uint32_t i = 0; node != NULL && i < node->cache_count; i++) {
+        const cache_instance_t *cache = topology->caches + node->caches[i];
+        if (cache->info.level == info->level &&
+            cache->info.cache_id == info->cache_id) {
+            *slices = cache->cpu_count / node->sibling_count;
+            if (*slices < 1) {
+                *slices = 1;
+            }
+            return ERROR_NONE;
+        }
+    }
+
+    return ERROR_CACHE_NOT_EXISTS;
+}
+
+/**
+ * @brief Returns if a list of ids contains an id.
+ */
+static int topology_contains(const uint32_t *ids, uint32_t count,
+                             uint32_t id) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (ids[i] == id) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Adds the candidates of one profiled CPU core to the workload.
+ *
+ * @param node the profiled CPU core
+ * @param candidates the CPU cores which match the placement
+ * @param candidate_count amount of candidates
+ * @param cpus all profiled CPU cores
+ * @param count amount of profiled CPU cores
+ * @param workload the CPU cores of the workload
+ * @param workload_count amount of CPU cores of the workload
+ *
+ * @return The amount of candidates which may run the workload.
+ */
+static uint32_t topology_place_node(const cpu_node_t *node,
+                                    const uint32_t *candidates,
+                                    uint32_t candidate_count,
+                                    const uint32_t *cpus, uint32_t count,
+                                    uint32_t *workload,
+                                    uint32_t *workload_count) {
+    uint32_t usable = 0;
+
+    // first other physical cores, then the hyper threads of this core
+    for (int siblings = 0; siblings < 2 && !usable; siblings++) {
+        for (uint32_t i = 0; i < candidate_count; i++) {
+            uint32_t cpu = candidates[i];
+            if (topology_contains(cpus, count, cpu) ||
+                topology_contains(node->siblings, node->sibling_count, cpu) !=
+                    siblings) {
+                continue;
+            }
+
+            usable++;
+            if (!topology_contains(workload, *workload_count, cpu)) {
+                workload[(*workload_count)++] = cpu;
+            }
+        }
+    }
+
+    return usable;
+}
+
+error_t topology_place(const topology_t *topology,
+                       topology_placement_t placement, const uint32_t *cpus,
+                       uint32_t count, uint32_t **workload,
+                       uint32_t *workload_count) {
+    *workload_count = 0;
+    *workload = malloc(sizeof(uint32_t) * (topology->cpu_count + count));
+    if (*workload == NULL) {
+        return ERROR_ALLOCATION;
+    }
+
+    if (placement == PLACEMENT_SAME_CORE) {
+        memcpy(*workload, cpus, sizeof(uint32_t) * count);
+        *workload_count = count;
+        return ERROR_NONE;
+    }
+
+    uint32_t level = placement == PLACEMENT_SHARED_L2 ? 2 : 3;
+    for (uint32_t i = 0; i < count; i++) {
+        const cpu_node_t *node = topology_node(topology, cpus[i]);
+        const uint32_t *candidates = NULL;
+        uint32_t candidate_count = 0;
+
+        if (node != NULL && placement == PLACEMENT_SMT_SIBLING) {
+            candidates = node->siblings;
+            candidate_count = node->sibling_count;
+        }
+
+        for (uint32_t c = 0; node != NULL && !candidates &&
+                             c < node->cache_count;
+             c++) {
+            const cache_instance_t *cache = topology->caches + node->caches[c];
+            if (cache->info.level == level &&
+                (cache->info.type == DATA || cache->info.type == UNIFIED)) {
+                candidates = cache->cpus;
+                candidate_count = cache->cpu_count;
+            }
+        }
+
+        if (node == NULL ||
+            !topology_place_node(node, candidates, candidate_count, cpus,
+                                 count, *workload, workload_count)) {
+            free(*workload);
+            *workload = NULL;
+            *workload_count = 0;
+            return ERROR_PLACEMENT;
+        }
+    }
+
+    return ERROR_NONE;
+}
+
+error_t topology_placement_from(const char *name,
+                                topology_placement_t *placement) {
+    if (!strcmp(name, "same-core")) {
+        *placement = PLACEMENT_SAME_CORE;
+    } else if (!strcmp(name, "smt-sibling")) {
+        *placement = PLACEMENT_SMT_SIBLING;
+    } else if (!strcmp(name, "shared-l2")) {
+        *placement = PLACEMENT_SHARED_L2;
+    } else if (!strcmp(name, "shared-l3")) {
+        *placement = PLACEMENT_SHARED_L3;
+    } else {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    return ERROR_NONE;
+}
+
+/**
+ * @brief Prints a list of ids as a JSON array.
+ */
+static void topology_print_ids(FILE *file, const uint32_t *ids,
+                               uint32_t count) {
+    fprintf(file, "[");
+    for (uint32_t i = 0; i < count; i++) {
+        fprintf(file, i ? ", %u" : "%u", ids[i]);
+    }
+    fprintf(file, "]");
+}
+
+void topology_print_json(const topology_t *topology, FILE *file) {
+    fprintf(file, "{\n  \"source\": \"%s\",\n  \"cpus\": [\n",
+            topology->source == TOPOLOGY_SYSFS ? "sysfs" : "cpuid");
+
+    for (uint32_t i = 0; i < topology->cpu_count; i++) {
+        const cpu_node_t *node = topology->cpus + i;
+        fprintf(file, "    {\"cpu\": %u, \"siblings\": ", node->cpu);
+        topology_print_ids(file, node->siblings, node->sibling_count);
+        fprintf(file, ", \"caches\": ");
+        topology_print_ids(file, node->caches, node->cache_count);
+        fprintf(file, "}%s\n", i + 1 < topology->cpu_count ? "," : "");
+    }
+
+    fprintf(file, "  ],\n  \"caches\": [\n");
+
+    for (uint32_t i = 0; i < topology->cache_count; i++) {
+        const cache_instance_t *cache = topology->caches + i;
+        fprintf(file,
+                "    {\"id\": %u, \"index\": %u, \"level\": %u, "
+                "\"type\": \"%s\", \"line_size\": %u, \"size\": %u, "
+                "\"sets\": %u, \"ways\": %u, \"shared_cpus\": ",
+                i, cache->info.cache_id, cache->info.level,
+                topology_type_name(cache->info.type), cache->info.line_size,
+                cache->info.total_size, cache->info.set_count,
+                cache->info.ways_of_associativity);
+        topology_print_ids(file, cache->cpus, cache->cpu_count);
+        fprintf(file, "}%s\n", i + 1 < topology->cache_count ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+}
+
+void topology_free(topology_t *topology) {
+    for (uint32_t i = 0; topology->cpus != NULL && i < topology->cpu_count;
+         i++) {
+        free(topology->cpus[i].siblings);
+        free(topology->cpus[i].caches);
+    }
+
+    for (uint32_t i = 0; topology->caches != NULL && i < topology->cache_count;
+         i++) {
+        free(topology->caches[i].cpus);
+    }
+
+    free(topology->cpus);
+    free(topology->caches);
+    topology->cpus = NULL;
+    topology->caches = NULL;
+    topology->cpu_count = 0;
+    topology->cache_count = 0;
+}
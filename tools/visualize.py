@@ -5,18 +5,20 @@ from math import ceil
 
 import h5py
 import numpy
+import os
 import time
 import matplotlib.pyplot as plt
 import matplotlib.animation as animation
 
 from matplotlib.container import BarContainer
 from matplotlib.image import AxesImage
+from matplotlib.ticker import FixedLocator, FuncFormatter, MaxNLocator
 
 from functools import reduce
 from multiprocessing import Process, cpu_count, Queue
 
 
-def image_worker(file_name, core_id, combines_lines, queue):
+def image_worker(file_name, core_id, combines_lines, queue, cpu=None):
     """
     Worker funktion, that calculates a part of the image.
     """
@@ -25,6 +27,7 @@ def image_worker(file_name, core_id, combines_lines, queue):
         combines=1,
         combine_all=False,
         combine_lines=combines_lines,
+        cpu=cpu,
     )
     start = ceil(len(measurement) / cpu_count()) * core_id
     end = ceil(len(measurement) / cpu_count()) * (core_id + 1)
@@ -42,14 +45,15 @@ def image_worker(file_name, core_id, combines_lines, queue):
     queue.put(result)
 
 
-def generate_image(file_name, combine_lines):
+def generate_image(file_name, combine_lines, cpu=None):
     """
     Calculates the content of an image in multiple processes.
     """
     queue = Queue()
     for i in range(cpu_count()):
         p = Process(
-            target=image_worker, args=(file_name, i, combine_lines, queue))
+            target=image_worker,
+            args=(file_name, i, combine_lines, queue, cpu))
         p.start()
 
     result = queue.get()
@@ -69,6 +73,7 @@ def video_worker(args, core_id, queue):
         combines=args.combine,
         combine_all=args.type == 'image',
         combine_lines=args.graph == 'bar_chart',
+        cpu=args.cpu,
     )
     start = ceil(len(measurement) / cpu_count()) * core_id
     end = ceil(len(measurement) / cpu_count()) * (core_id + 1)
@@ -121,7 +126,8 @@ def print_min_max_mean(args):
         mean = summary / value_count
 
     else:
-        image = generate_image(args.measure_data, args.graph == 'bar_chart')
+        image = generate_image(args.measure_data, args.graph == 'bar_chart',
+                               args.cpu)
         values = image.flatten()
         maximum = values.max()
         minimum = values.min()
@@ -132,9 +138,228 @@ def print_min_max_mean(args):
     print('mean: {}'.format(mean))
 
 
+CNV_MAGIC = b'CNVFRAME'
+
+CNV_HEADER = numpy.dtype([
+    ('magic', 'S8'),
+    ('version', '<u4'),
+    ('header_size', '<u4'),
+    ('cpu', '<u4'),
+    ('timer', '<u4'),
+    ('level', '<u4'),
+    ('type', '<u4'),
+    ('line_size', '<u4'),
+    ('total_size', '<u4'),
+    ('set_count', '<u4'),
+    ('way_count', '<u4'),
+    ('rank', '<u4'),
+    ('dim_x', '<u4'),
+    ('dim_y', '<u4'),
+    ('record_size', '<u4'),
+    ('frame_count', '<u8'),
+    ('bits', '<u4'),
+    ('threshold', '<u4'),
+    ('mask_sets', '<u4'),
+    ('mask_ways', '<u4'),
+])
+
+
+class BitmapFrames:
+    """
+    The classified frames of the profiler (`--classify`), unpacked on access.
+
+    Every frame is stored as a row of bytes, value `i` of the frame is bit
+    `i % 8` of byte `i // 8`. A set bit is a miss. Indexing returns the
+    unpacked frames with the values 0 and 1, so they can be used like the
+    `frames` dataset.
+    """
+
+    def __init__(self, bitmaps, shape, threshold):
+        self.bitmaps = bitmaps
+        self.frame_shape = tuple(int(dim) for dim in shape)
+        self.threshold = int(threshold)
+
+    @property
+    def shape(self):
+        return (self.bitmaps.shape[0], ) + self.frame_shape
+
+    def __len__(self):
+        return self.bitmaps.shape[0]
+
+    def __getitem__(self, key):
+        rows = numpy.asarray(self.bitmaps[key])
+        bits = numpy.unpackbits(rows, axis=-1, bitorder='little')
+        bits = bits[..., :int(numpy.prod(self.frame_shape))]
+        return bits.reshape(rows.shape[:-1] + self.frame_shape)
+
+
+def frames_of(file):
+    """
+    Returns the frames of a group or None for legacy files.
+
+    The bitmaps of classified files are unpacked, see BitmapFrames. Aggregated
+    files show the mean of every window as a frame.
+    """
+    if 'frames' in file:
+        return file['frames']
+    if 'windows' in file:
+        return file['windows']['mean']
+    if 'bitmaps' in file:
+        bitmaps = file['bitmaps']
+        return BitmapFrames(bitmaps, bitmaps.attrs['shape'],
+                            bitmaps.attrs['threshold'])
+    return None
+
+
+class CnvFile(dict):
+    """
+    A .cnv frame stream of the profiler, mapped into the memory.
+
+    Behaves like the group of a hdf5 file with the datasets `frames` and
+    `clock`, both are views of a numpy.memmap. The amount of frames follows
+    from the file size, so files of an interrupted run can be read as well.
+    The ids of the probed sets and ways behind the header of a version 2 file
+    become the datasets `sets` and `ways`.
+    """
+
+    def __init__(self, path):
+        header = numpy.fromfile(path, dtype=CNV_HEADER, count=1)[0]
+        if header['magic'] != CNV_MAGIC or header['version'] not in (1, 2):
+            raise ValueError('{} is not a .cnv file.'.format(path))
+        if header['version'] == 1:
+            # the fields of version 2 are zero padding in version 1
+            header['mask_sets'] = 0
+            header['mask_ways'] = 0
+
+        if header['rank'] == 2:
+            shape = (header['dim_y'], header['dim_x'])
+        else:
+            shape = (header['dim_y'], )
+        if header['bits'] == 1:
+            size = (int(numpy.prod(shape)) + 7) // 8
+            record = numpy.dtype([('clock', '<u8'), ('frame', 'u1', (size, ))])
+        else:
+            record = numpy.dtype([('clock', '<u8'), ('frame', '<u4', shape)])
+
+        size = os.path.getsize(path) - header['header_size']
+        count = size // record.itemsize if header['rank'] else 0
+        if count:
+            records = numpy.memmap(path,
+                                   dtype=record,
+                                   mode='r',
+                                   offset=int(header['header_size']),
+                                   shape=(count, ))
+        else:
+            records = numpy.zeros(0, dtype=record)
+
+        if header['bits'] == 1:
+            frames = BitmapFrames(records['frame'], shape,
+                                  header['threshold'])
+        else:
+            frames = records['frame']
+        super().__init__(frames=frames, clock=records['clock'])
+
+        ids = numpy.fromfile(path,
+                             dtype='<u4',
+                             count=int(header['mask_sets'] +
+                                       header['mask_ways']),
+                             offset=CNV_HEADER.itemsize)
+        if header['mask_sets']:
+            self['sets'] = ids[:header['mask_sets']]
+        if header['mask_ways']:
+            self['ways'] = ids[header['mask_sets']:]
+        self.header = header
+        self.filename = path
+        # mimics the file attribute of a hdf5 group
+        self.file = self
+
+    def close(self):
+        pass
+
+
+def is_cnv(path):
+    """
+    Returns if a file is a .cnv frame stream.
+    """
+    with open(path, 'rb') as file:
+        return file.read(len(CNV_MAGIC)) == CNV_MAGIC
+
+
+def open_measurement(path, cpu=None):
+    """
+    Opens a hdf5 file or a .cnv file and returns the group of a CPU core.
+
+    A .cnv file holds a single core. With multiple cores the profiler writes
+    one file `<path>.cpuN` per core, which is selected with `cpu`.
+    """
+    if cpu is not None and not os.path.exists(path):
+        path = '{}.cpu{}'.format(path, cpu)
+    if is_cnv(path):
+        return CnvFile(path)
+    return select_group(h5py.File(path, 'r'), cpu)
+
+
+def select_group(file, cpu=None):
+    """
+    Returns the group of a CPU core in an opened hdf5 file.
+
+    Files which were measured on multiple CPU cores contain one group `cpuN`
+    per core. If no core is given, the first core is used. Files of a single
+    core are returned unchanged.
+    """
+    if cpu is not None:
+        return file['cpu{}'.format(cpu)]
+    if 'frames' in file or 'bitmaps' in file or 'windows' in file:
+        return file
+    groups = sorted(
+        (name for name in file if name.startswith('cpu')),
+        key=lambda name: int(name[3:]),
+    )
+    if groups:
+        return file[groups[0]]
+    return file
+
+
+def probed_ids(file, name):
+    """
+    Returns the ids of the probed sets (`sets`) or ways (`ways`) of a group.
+
+    Frames which were measured with `--sets` or `--ways` only hold the rows or
+    columns of these ids. Returns None if all sets or ways were probed, so
+    the index of a row or column is its id.
+    """
+    if name in file:
+        return numpy.asarray(file[name][()])
+    return None
+
+
+def frame_count(file):
+    """
+    Returns the amount of measurements in an opened hdf5 file.
+    """
+    frames = frames_of(file)
+    if frames is not None:
+        return frames.shape[0]
+    return len(file)
+
+
 class MeasureData:
     """
     Wrapper Class for a hdf5 file, which can combine rows and/or columns
+
+    Two layouts are supported. Current files contain a single dataset
+    `frames[N][sets][ways]`, legacy files contain one dataset per iteration
+    which are named "0", "1", "2", ...
+    Files which were measured per set contain `frames[N][sets]`, such a frame
+    is handled like a frame with a single way.
+    Files which were measured on multiple CPU cores contain these datasets in
+    one group per core, see select_group.
+    .cnv files of the profiler are mapped into the memory and provide the
+    same datasets, see CnvFile.
+    Classified files contain `bitmaps` instead of `frames`, their frames are
+    unpacked to 0 (hit) and 1 (miss), see BitmapFrames.
+    Files which were measured with `--sets` or `--ways` contain the ids of
+    the rows and columns, see probed_ids.
     """
 
     def __init__(
@@ -142,11 +367,16 @@ class MeasureData:
             file,
             combines,
             combine_lines,
+            cpu=None,
     ):
         self.file = file
+        self.cpu = cpu
         self.iteration = 0
         self.combines = combines
         self._combine_lines = combine_lines
+        self.frames = frames_of(file)
+        self.sets = probed_ids(file, 'sets')
+        self.ways = probed_ids(file, 'ways')
 
     def __iter__(self):
         return self
@@ -172,7 +402,14 @@ class MeasureData:
         return self.__next__()
 
     def __len__(self):
-        return ceil(len(self.file) / self.combines)
+        return ceil(self.frame_count / self.combines)
+
+    @property
+    def frame_count(self):
+        """
+        The amount of single measurements in the file.
+        """
+        return frame_count(self.file)
 
     def __getitem__(self, key):
         """
@@ -192,13 +429,14 @@ class MeasureData:
             if len(self) == 1:  # case if an image gets created
                 # the child processes can not open the file if the file is
                 # still open in the parent process
-                file_name = self.file.filename
-                self.file.close()
+                file_name = self.file.file.filename
+                self.file.file.close()
                 time.sleep(0.1)
-                return generate_image(file_name, self.combine_lines)
+                return generate_image(file_name, self.combine_lines,
+                                      self.cpu)
 
-            elif len(self) == key and len(self.file) % self.combines:
-                max_combines = len(self.file) % self.combines
+            elif len(self) == key and self.frame_count % self.combines:
+                max_combines = self.frame_count % self.combines
             else:
                 max_combines = self.combines
 
@@ -212,14 +450,22 @@ class MeasureData:
                 lambda l, r: list(map(lambda e: e[0] + e[1], zip(l, r))), data)
 
     def chunk_at(self, key):
-        chunk = self.file[str(key)]
+        if self.frames is not None:
+            if key < 0 or self.frames.shape[0] <= key:
+                raise KeyError(key)
+            chunk = self.frames[key].astype(numpy.uint64)
+        else:
+            chunk = self.file[str(key)][()].astype(numpy.uint64)
+
+        if chunk.ndim == 1:
+            # measured per set, every set has a single value
+            chunk = chunk.reshape(-1, 1)
+
         if self._combine_lines:
             # fold a single row into a single value
-            return list(
-                map(lambda row: reduce(lambda x, y: x.astype(numpy.uint64) + y.astype(numpy.uint64), row),
-                    chunk))
+            return list(chunk.sum(axis=1))
         else:
-            return chunk.value.astype(numpy.uint64)
+            return chunk
 
     @property
     def combine_lines(self):
@@ -232,11 +478,13 @@ class MeasureData:
             combines=1,
             combine_all=False,
             combine_lines=False,
+            cpu=None,
     ):
         """
         Arguments
         ---------
             path: Path to hdf5 file.
+            cpu: The CPU core of a file with multiple cores.
             chunks_size: Amount of blocks which will be combined.
             combine_function: The function which combines the elementes of
                     chunk_size big array.
@@ -248,12 +496,12 @@ class MeasureData:
 
         print('Opening data set file ...')
 
-        file = h5py.File(path, 'r')
+        file = open_measurement(path, cpu)
 
         if combine_all:
-            combines = len(file.items())
+            combines = frame_count(file)
 
-        return cls(file, combines, combine_lines)
+        return cls(file, combines, combine_lines, cpu)
 
 
 def parse():
@@ -327,6 +575,15 @@ def parse():
         help='Defines the amount of iterations which will be combined.',
     )
 
+    parser.add_argument(
+        '--cpu',
+        metavar='ID',
+        default=None,
+        type=int,
+        help='Selects the CPU core of a file which was measured on multiple '
+        'cores. Defaults to the first core.',
+    )
+
     parser.add_argument(
         '--max',
         metavar='MAX',
@@ -388,6 +645,39 @@ def generic_video(measurement, args, figure, chart):
         raise ValueError('Not allowed type ({}).'.format(args.type))
 
 
+MAX_LABELED_IDS = 32
+
+
+def id_formatter(ids):
+    """
+    Returns a tick formatter which labels the index of a row or column with
+    the id of its set or way.
+    """
+
+    def label(value, position):
+        index = int(round(value))
+        if value != index or not 0 <= index < len(ids):
+            return ''
+        return str(ids[index])
+
+    return FuncFormatter(label)
+
+
+def label_axis(axis, ids):
+    """
+    Labels the ticks of an axis with the probed ids, if only some of the sets
+    or ways were probed.
+    """
+    if ids is None:
+        return
+    # a few ids are labeled all, since they need not be contiguous
+    if len(ids) <= MAX_LABELED_IDS:
+        axis.set_major_locator(FixedLocator(range(len(ids))))
+    else:
+        axis.set_major_locator(MaxNLocator(integer=True))
+    axis.set_major_formatter(id_formatter(ids))
+
+
 def heatmap_plot(measurement, args):
     """
     This function will handle the heatmap plot.
@@ -410,6 +700,8 @@ def heatmap_plot(measurement, args):
         measurement.combines), )
     plt.xlabel('Cache Lines')
     plt.ylabel('Cache Sets')
+    label_axis(plt.gca().xaxis, measurement.ways)
+    label_axis(plt.gca().yaxis, measurement.sets)
     generic_video(measurement, args, fig, heatmap)
 
 
@@ -436,6 +728,7 @@ def bar_chart_plot(measurement, args):
         measurement.combines))
     plt.ylabel('Clock Cycles')
     plt.xlabel('Cache Sets')
+    label_axis(plt.gca().xaxis, measurement.sets)
 
     generic_video(measurement, args, fig, bar_chart)
 
@@ -448,7 +741,8 @@ def main():
 
     if args.stats:
         print_min_max_mean(args)
-        print('data sets: {}'.format(len(h5py.File(args.measure_data, 'r'))))
+        print('data sets: {}'.format(
+            frame_count(open_measurement(args.measure_data, args.cpu))))
         return
 
     measurement = MeasureData.from_file(
@@ -456,6 +750,7 @@ def main():
         combines=args.combine,
         combine_all=args.type == 'image',
         combine_lines=args.graph == 'bar_chart',
+        cpu=args.cpu,
     )
 
     if args.graph == 'heatmap':